@@ -0,0 +1,88 @@
+#!/bin/sh
+# Adversarial input benchmark: generates sources that stress the line parsing (whitespace runs, long operand
+# lists, long strings) at line lengths of 20, 40 and 80 characters, the same number of bytes for each length,
+# and reports the assembling time per byte of each.
+# Each byte is looked at a bounded number of times, however long its line is, so the per-byte cost of a source
+# should not grow with its line length more than the words it puts per byte do (a longer string line puts more),
+# and it should stay at most the one of the plain source (the same statements as the whitespace source, short lines).
+# Usage: Tests/Benchmark/adversarial.sh [repeats] (from the repository root, after make)
+
+ASSEMBLER=${ASSEMBLER:-./assembler}
+REPEATS=${1:-200}
+LENGTHS="20 40 80"
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+# Whitespace runs around every token, and whitespace only lines (64000 bytes, at most 3200 code words)
+whitespace() {
+    awk -v len="$1" -v total=64000 '
+    function run(n,    s, i) { for (s = ""; i < n; ++i) s = s (i % 2 ? " " : "\t"); return s }
+    BEGIN {
+        pad = len - 1 - length("movr1,r2");
+        gap = int(pad / 4);
+        for (i = 0; i < total / (2 * len); ++i) {
+            print run(gap) "mov" run(gap) "r1" run(gap) "," run(pad - 3 * gap) "r2";
+            print (i + 1 < total / (2 * len)) ? run(len - 1) : sprintf("%" len - 1 "s", run(pad) "stop");
+        }
+    }'
+}
+
+# As many operands as a line can hold (8000 bytes, at most 3600 data words)
+operands() {
+    awk -v len="$1" -v total=8000 'BEGIN {
+        for (i = 0; i < total / len; ++i) {
+            line = ".data 1";
+            for (j = 1; length(line) + 2 <= len - 1; ++j)
+                line = line "," j % 10;
+            printf "%-" len - 1 "s\n", line;
+        }
+    }'
+}
+
+# Strings as long as a line can hold (4000 bytes, at most 3500 data words)
+strings() {
+    awk -v len="$1" -v total=4000 'BEGIN {
+        for (i = 0; i < total / len; ++i) {
+            printf ".string \"";
+            for (j = 0; j < len - 1 - length(".string \"\""); ++j)
+                printf "%c", 97 + j % 26;
+            printf "\"\n";
+        }
+    }'
+}
+
+# The same statements as the whitespace source, without the whitespace
+awk 'BEGIN {
+    for (i = 0; i < 1000; ++i)
+        print "mov r1,r2";
+    print "stop";
+}' > "$DIR/plain.as"
+
+for corpus in whitespace operands strings; do
+    for len in $LENGTHS; do
+        $corpus "$len" > "$DIR/$corpus$len.as"
+    done
+done
+
+# Assembles the source $1 #REPEATS times (each one from scratch) and prints its time per byte, labeled $2
+measure() {
+    args=""
+    i=0
+    while [ $i -lt "$REPEATS" ]; do
+        args="$args $DIR/$1"
+        i=$((i + 1))
+    done
+
+    bytes=$(($(wc -c < "$DIR/$1.as") * REPEATS))
+    start=$(date +%s%N)
+    $ASSEMBLER --quiet --stdout $args > /dev/null
+    end=$(date +%s%N)
+    echo "$2: $bytes bytes, $(((end - start) / bytes)) ns/byte"
+}
+
+measure plain plain
+for corpus in whitespace operands strings; do
+    for len in $LENGTHS; do
+        measure "$corpus$len" "$corpus/$len"
+    done
+done
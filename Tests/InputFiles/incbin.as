@@ -0,0 +1,11 @@
+; file incbin.as - incbinData.as has the same words as .data directives
+
+.entry WORDS
+MAIN:   lea BYTES, r1
+        prn PART
+        prn WORDS
+        stop
+BYTES:  .incbin "Binary/table.bin"
+PART:   .incbin "Binary/table.bin", 4, 2
+        .incbin "Binary/table.bin", 10
+WORDS:  .incbin "Binary/table.bin", 4, 6, 2
@@ -0,0 +1,10 @@
+; file incbinData.as - incbin.as with .data directives
+
+.entry WORDS
+MAIN:   lea BYTES, r1
+        prn PART
+        prn WORDS
+        stop
+BYTES:  .data 1, 2, 3, 255, 65, 0, 52, 18, 128, 127
+PART:   .data 65, 0
+WORDS:  .data 65, 4660, -128
@@ -0,0 +1,15 @@
+; file incbinErrors.as - every incbin error
+
+A:      .incbin Binary/table.bin
+B:      .incbin ""
+C:      .incbin "Binary/missing.bin"
+D:      .incbin "Binary"
+E:      .incbin "Binary/table.bin", -1
+F:      .incbin "Binary/table.bin", 1, 2, 1, 0
+G:      .incbin "Binary/table.bin", 8, 4
+H:      .incbin "Binary/table.bin", 0, 3, 2
+I:      .incbin "Binary/table.bin", 0, 3, 3
+J:      .incbin "Binary/table.bin", 2, 2, 2
+K:      .incbin "Binary/table.bin" 4
+L:      .incbin "Binary/table.bin",, 4
+        stop
@@ -0,0 +1,12 @@
+; file include.as - includeExpanded.as has its includes written out
+
+MAIN:   mov TABLE, r1
+        .include "Include/common.inc"
+        jsr PRINT
+        lea MSG, r2
+        prn COUNT
+        jsr LOG
+        cmp TABLE, #-4
+        stop
+.entry MAIN
+.entry TABLE
@@ -0,0 +1,10 @@
+; file includeErrors.as - every include error
+
+        .include "Include/cycle1.inc"
+        .include "Include/missing.inc"
+        .include "Include"
+        .include Include/more.inc
+        .include "Include/more.inc" x
+        .include "Include/bad.inc"
+        .include "includeErrors.as"
+        stop
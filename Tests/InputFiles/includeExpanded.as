@@ -0,0 +1,19 @@
+; file includeExpanded.as - include.as with its includes written out
+
+MAIN:   mov TABLE, r1
+; file common.inc - shared declarations and tables
+.extern PRINT
+.extern EXIT
+TABLE:  .data 1, 2, 3, -4
+MSG:    .string "hello"
+; file more.inc - included by common.inc
+.extern LOG
+COUNT:  .data 7
+        jsr PRINT
+        lea MSG, r2
+        prn COUNT
+        jsr LOG
+        cmp TABLE, #-4
+        stop
+.entry MAIN
+.entry TABLE
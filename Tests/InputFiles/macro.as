@@ -0,0 +1,24 @@
+; file macro.as - macroExpanded.as has its macros written out
+
+.entry LIST
+.extern fn1
+mcr pushAll
+        prn #48
+        inc r6
+endmcr
+mcr twice
+        pushAll
+        clr K
+        pushAll
+endmcr
+MAIN:   add r3, LIST
+        twice
+        jsr fn1
+        pushAll
+        stop
+mcr table
+LIST:   .data 6, -9
+        .string "mcr"
+endmcr
+        table
+K:      .data 31
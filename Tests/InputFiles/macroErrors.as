@@ -0,0 +1,25 @@
+; file macroErrors.as - every macro error
+
+mcr 1bad
+        prn #1
+endmcr
+mcr mov
+endmcr
+mcr good
+        prn #2
+        mcr inner
+        badinst r1
+endmcr
+mcr good
+endmcr
+endmcr
+mcr other extra
+endmcr extra
+L1:     good
+mcr broken
+        badinst r1
+endmcr
+        broken
+        stop
+mcr open
+        prn #3
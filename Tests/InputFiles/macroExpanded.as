@@ -0,0 +1,17 @@
+; file macroExpanded.as - macro.as with its macros written out
+
+.entry LIST
+.extern fn1
+MAIN:   add r3, LIST
+        prn #48
+        inc r6
+        clr K
+        prn #48
+        inc r6
+        jsr fn1
+        prn #48
+        inc r6
+        stop
+LIST:   .data 6, -9
+        .string "mcr"
+K:      .data 31
@@ -0,0 +1,19 @@
+; file pool.as - assembled with --pool-data
+; S3 duplicates S1 and is removed, so D1 starts where S3 started
+; TAIL is the end of D1 and shares its words
+
+.entry D1
+
+MAIN:   prn S1
+        prn S3
+        prn D1
+        lea TAIL, r2
+        prn *r2
+        stop
+
+S1:     .string "ab"
+S3:     .string "ab"
+D1:     .data 7, -3
+        .data 12
+TAIL:   .data -3, 12
+LAST:   .string "z"
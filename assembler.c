@@ -2,33 +2,406 @@
 #include "dataTypes.h"
 #include "firstPass.h"
 #include "fileHandling.h"
+#include "sourceFile.h"
 #include "externalVariables.h"
+#include "diagnostics.h"
+#include "optimizer.h"
+#include "languageServer.h"
+#include "watch.h"
+#include "batchIO.h"
+#include "workloadStats.h"
+#include "includeCache.h"
+#include "macro.h"
+#include "trace.h"
+
+/* The name given to the source when it is read from the standard input */
+#define STDIN_SOURCE_NAME "stdin"
+
+/* An argument starting with it names a file listing more arguments */
+#define RESPONSE_FILE_PREFIX '@'
+#define RESPONSE_FILE_SEPARATORS " \t\r\n"
+#define INITIAL_ARGUMENT_CAPACITY 64
+
+/* The file the statistics of the run are written to (with --stats) */
+static char *statsFileName = NULL;
+
+/* The file the trace of the run is written to (with --trace) */
+static char *traceFileName = NULL;
+
+/* Whether if a source couldn't be read or had errors (a check fails then) */
+static Boolean hadInvalidSource = FALSE;
+
+/**
+ * This function appends #argument to the #count arguments of #arguments (which can hold #capacity of them)
+ * **/
+void appendArgument(char ***arguments, int *count, int *capacity, char *argument) {
+    char **tmp;
+
+    /* Grow the arguments (by doubling) if needed */
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : INITIAL_ARGUMENT_CAPACITY;
+        if ((tmp = (char **) realloc(*arguments, (size_t) *capacity * sizeof(char *))) == NULL) {
+            perror("appendArgument");
+            exit(EXIT_FAILURE);
+        }
+        *arguments = tmp;
+    }
+    (*arguments)[(*count)++] = argument;
+}
+
+/**
+ * This function replaces every "@list" argument of #argv with the arguments listed in the file list (separated by
+ * white space), so a run isn't limited by the size of the command line. The lists are read in one batch.
+ * @return The arguments (their number is put in #argc), the lists are kept in memory for the whole run
+ * **/
+char **expandResponseFiles(int *argc, char **argv) {
+    FileRead *lists;
+    char **arguments = NULL, *token;
+    int i, listCount = 0, count = 0, capacity = 0;
+
+    for (i = 1; i < *argc; ++i)
+        if (argv[i][0] == RESPONSE_FILE_PREFIX && argv[i][1] != '\0')
+            ++listCount;
+    if (listCount == 0)
+        return argv;
+
+    /* Read all the lists together */
+    if ((lists = (FileRead *) malloc((size_t) listCount * sizeof(FileRead))) == NULL) {
+        perror("expandResponseFiles");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 1, listCount = 0; i < *argc; ++i)
+        if (argv[i][0] == RESPONSE_FILE_PREFIX && argv[i][1] != '\0') {
+            lists[listCount].path = argv[i] + 1;
+            initTextBuffer(&lists[listCount++].content);
+        }
+    readFileBatch(lists, (unsigned) listCount);
+
+    /* Put the listed arguments in place of their lists */
+    appendArgument(&arguments, &count, &capacity, argv[0]);
+    for (i = 1, listCount = 0; i < *argc; ++i) {
+        if (argv[i][0] != RESPONSE_FILE_PREFIX || argv[i][1] == '\0') {
+            appendArgument(&arguments, &count, &capacity, argv[i]);
+            continue;
+        }
+
+        if (!lists[listCount].isRead) {
+            printf("Couldn't Read The File List %s.\n", lists[listCount].path);
+            exit(EXIT_FAILURE);
+        }
+        appendChars(&lists[listCount].content, "", 1); /* Terminate it, the arguments are cut out of it */
+        for (token = strtok(lists[listCount].content.data, RESPONSE_FILE_SEPARATORS); token != NULL;
+             token = strtok(NULL, RESPONSE_FILE_SEPARATORS))
+            appendArgument(&arguments, &count, &capacity, token);
+        ++listCount;
+    }
+
+    free(lists);
+    *argc = count;
+    return arguments;
+}
+
+/**
+ * This function reads the options in #argv and moves the file names to the beginning of #argv
+ * @return The number of file names
+ * **/
+int readOptions(int argc, char **argv) {
+    int i, fileCount = 0;
+    FILE **stream;
+
+    /* Defaults: messages to the standard output, outputs to files */
+    diagnosticsFile = stdout;
+    shouldStreamOutput = FALSE;
+    objectStream = entryStream = externStream = stdout;
+    isQuietMode = FALSE;
+    maxErrors = 0;
+    shouldPoolData = FALSE;
+    shouldOptimize = FALSE;
+    shouldStripUnused = FALSE;
+    shouldOutputMap = isMapSortedBySize = FALSE;
+    shouldOutputXref = FALSE;
+    shouldOutputDebug = FALSE;
+    isServerMode = FALSE;
+    isWatchMode = FALSE;
+    shouldBatchIO = FALSE;
+    shouldCollectStats = FALSE;
+    shouldReportMemory = FALSE;
+    isCheckMode = FALSE;
+
+    for (i = 1; i < argc; ++i) {
+        stream = NULL;
+
+        if (strcmp(argv[i], "--stdout") == 0) /* The outputs are written to the standard output */
+            shouldStreamOutput = TRUE;
+        else if (strcmp(argv[i], "--obj-fd") == 0)
+            stream = &objectStream;
+        else if (strcmp(argv[i], "--ent-fd") == 0)
+            stream = &entryStream;
+        else if (strcmp(argv[i], "--ext-fd") == 0)
+            stream = &externStream;
+        else if (strcmp(argv[i], "--quiet") == 0) /* Only the errors are printed */
+            isQuietMode = TRUE;
+        else if (strcmp(argv[i], "--pool-data") == 0) /* Data items with the same content share their words */
+            shouldPoolData = TRUE;
+        else if (strcmp(argv[i], "--optimize") == 0) /* Rewrite statements to shorter ones before assembling */
+            shouldOptimize = TRUE;
+        else if (strcmp(argv[i], "--strip-unused") == 0) /* Remove the unreferenced code blocks and data items */
+            shouldStripUnused = TRUE;
+        else if (strcmp(argv[i], "--map") == 0) /* A map of the symbols is written too */
+            shouldOutputMap = TRUE;
+        else if (strcmp(argv[i], "--map-by-size") == 0) /* The same, sorted by size */
+            shouldOutputMap = isMapSortedBySize = TRUE;
+        else if (strcmp(argv[i], "--xref") == 0) /* The sites referring to every symbol are written too */
+            shouldOutputXref = TRUE;
+        else if (strcmp(argv[i], "--debug") == 0) /* The address to source line table is written too */
+            shouldOutputDebug = TRUE;
+        else if (strcmp(argv[i], "--watch") == 0) /* Assemble the files again whenever they change */
+            isWatchMode = TRUE;
+        else if (strcmp(argv[i], "--lsp") == 0) /* Serve editors over the Language Server Protocol */
+            isServerMode = TRUE;
+        else if (strcmp(argv[i], "--batch-io") == 0) /* Read the sources and write the outputs in batches */
+            shouldBatchIO = TRUE;
+        else if (strcmp(argv[i], "--check") == 0) /* Only validate the sources, the exit status tells if they are */
+            isCheckMode = TRUE;
+        else if (strcmp(argv[i], "--mem-report") == 0) { /* The allocations and the peak memory are reported */
+#ifdef TRACK_MEMORY
+            shouldReportMemory = TRUE;
+#else
+            printf("Option %s Needs An Assembler Built With TRACK_MEMORY.\n", argv[i]);
+            exit(EXIT_FAILURE);
+#endif
+        }
+        else if (strcmp(argv[i], "--max-errors") == 0) { /* A pass stops after that many errors */
+            if (i + 1 == argc || !isNumber(argv[i + 1]) || atoi(argv[i + 1]) < 0) {
+                printf("Option %s Needs A Non Negative Number.\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            maxErrors = (unsigned) atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--stats") == 0) { /* What the sources hold is written to a JSON file */
+            if (i + 1 == argc) {
+                printf("Option %s Needs A File Name.\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            statsFileName = argv[++i];
+            shouldCollectStats = TRUE;
+        }
+        else if (strcmp(argv[i], "--trace") == 0) { /* The spans of the run are written to a trace file */
+            if (i + 1 == argc) {
+                printf("Option %s Needs A File Name.\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            traceFileName = argv[++i];
+        }
+        else if (strncmp(argv[i], "--", 2) == 0) {
+            printf("Unknown Option %s.\n", argv[i]);
+            exit(EXIT_FAILURE);
+        } else { /* A file name ("-" is the standard input), kept in order at the beginning of #argv */
+            if (strcmp(argv[i], "-") == 0)
+                shouldStreamOutput = TRUE;
+            argv[fileCount++] = argv[i];
+        }
+
+        if (stream != NULL) { /* An output is written to a file descriptor */
+            if (i + 1 == argc || (*stream = openOutputDescriptor(argv[i + 1])) == NULL) {
+                printf("Option %s Needs A File Descriptor That Is Open For Writing.\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            shouldStreamOutput = TRUE;
+            ++i;
+        }
+    }
+
+    /* A check validates the sources as they are written, and has no outputs to add to */
+    if (isCheckMode)
+        shouldPoolData = shouldOptimize = shouldStripUnused = shouldOutputMap = shouldOutputXref =
+                shouldOutputDebug = FALSE;
+
+    /* The debug table is binary, it has no place among the text outputs of a stream */
+    if (shouldStreamOutput && shouldOutputDebug) {
+        printf("Option --debug Can't Be Used With Streamed Outputs.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* The outputs of several sources on the same streams are told apart by their names */
+    shouldMarkModules = BOOLEANIZE(shouldStreamOutput && fileCount > 1);
+
+    /* Messages must not be mixed with outputs written to the standard output */
+    if (shouldStreamOutput && (objectStream == stdout || entryStream == stdout || externStream == stdout))
+        diagnosticsFile = stderr;
+
+    return fileCount;
+}
+
+/**
+ * This function assembles #source: the passes, the output files, then everything reported on it is printed
+ * **/
+void assembleSource(SourceFile *source) {
+    /* The tables of the file before are freed, then all global variables are reset */
+    freeSymbolTable(&symbolTable);
+    freeExternEventsTable(&externEventTable);
+    initializeGlobalVariables();
+    sourceName = source->name; /* The files the source refers to are relative to it, from the passes before the first */
+    beginMemoryFile(source->name); /* What the file allocates from now on is accounted to it */
+    traceBegin("assembleSource", source->name);
+    traceBegin("expandIncludes", source->name);
+    expandIncludes(source); /* The lines of the included files follow their .include lines */
+    traceEnd("expandIncludes");
+    traceBegin("expandMacros", source->name);
+    expandMacros(source); /* The bodies of the macros replace their uses */
+    traceEnd("expandMacros");
+
+    enterMemoryPhase(OPTIMIZE_PHASE);
+    traceBegin("optimize", source->name);
+    if (shouldOptimize)
+        optimizeSource(source); /* Rewrite the source in memory */
+    if (shouldStripUnused)
+        eliminateUnusedBlocks(source); /* Remove what is never referred to */
+    traceEnd("optimize");
+    firstPass(source); /* Do the first pass on the file, second pass and file creation will be called from there */
+    if (hadErrors())
+        hadInvalidSource = TRUE;
+    flushDiagnostics(); /* Print everything reported on the file at once */
+    freeMacros();
+    traceEnd("assembleSource");
+    endMemoryFile();
+}
+
+/**
+ * This function assembles the #count sources in #names, #BATCH_FILE_COUNT at a time: the sources of a batch are read
+ * together, then assembled one by one, then the outputs of all of them are written together
+ * @return Whether if any source was assembled
+ * **/
+Boolean assembleInBatches(char **names, int count) {
+    FileRead reads[BATCH_FILE_COUNT];
+    SourceFile source;
+    Boolean hadSuccessfulRun = FALSE, isStdin;
+    int first, i, size;
+
+    for (first = 0; first < count; first += size) {
+        size = count - first < BATCH_FILE_COUNT ? count - first : BATCH_FILE_COUNT;
+
+        /* Read the sources of the batch (the standard input isn't a file, it's read in its turn) */
+        enterMemoryPhase(READ_PHASE);
+        traceBegin("readFileBatch", NULL);
+        for (i = 0; i < size; ++i) {
+            reads[i].path = strcmp(names[first + i], "-") == 0 ? NULL : appendFileSuffix(names[first + i], ASM);
+            initTextBuffer(&reads[i].content);
+        }
+        readFileBatch(reads, (unsigned) size);
+        traceEnd("readFileBatch");
+
+        for (i = 0; i < size; ++i) {
+            isStdin = BOOLEANIZE(strcmp(names[first + i], "-") == 0);
+            if (isStdin)
+                readSourceFile(stdin, STDIN_SOURCE_NAME, &source);
+            else if (reads[i].isRead)
+                readSourceText(reads[i].content.data, reads[i].content.length, names[first + i], &source);
+
+            if (isStdin || reads[i].isRead) {
+                assembleSource(&source);
+                freeSourceFile(&source);
+                hadSuccessfulRun = TRUE;
+            } else {
+                fprintf(diagnosticsFile, "\nERROR: Couldn't Open File %s, Try To Check If It Exists,"
+                                " And If You Have The Correct Permissions To Open It.\n", names[first + i]);
+                hadInvalidSource = TRUE;
+            }
+
+            free(reads[i].path);
+            freeTextBuffer(&reads[i].content);
+        }
+
+        /* Write the outputs of the batch */
+        enterMemoryPhase(OUTPUT_PHASE);
+        traceBegin("flushOutputFiles", NULL);
+        flushOutputFiles();
+        traceEnd("flushOutputFiles");
+    }
+
+    endFileBatches();
+    return hadSuccessfulRun;
+}
 
 int main(int argc, char **argv) {
     FILE *fp; /* Will hold the current file */
-    Boolean hadSuccessfulRun = FALSE;
+    SourceFile source; /* Will hold the lines of the current file */
+    Boolean hadSuccessfulRun = FALSE, isStdin;
+    int i, fileCount;
+
+    argv = expandResponseFiles(&argc, argv); /* The file lists are replaced by the files they list */
+    fileCount = readOptions(argc, argv);
+    if (shouldReportMemory) /* The allocations are accounted from now on */
+        startMemoryReport();
+    /* The spans are recorded from now on (the server and the watch never end, there's no point to record them) */
+    if (traceFileName != NULL && !isServerMode && !isWatchMode)
+        startTrace();
+
+    if (isServerMode) { /* The documents come from the editor, nothing is written to files */
+        diagnosticsFile = stderr;
+        shouldPoolData = shouldOptimize = shouldStripUnused = shouldOutputDebug = shouldCollectStats = FALSE;
+        shouldReportMemory = isCheckMode = FALSE;
+        return runLanguageServer(stdin, stdout);
+    }
 
-    if (argc == 1) { /* If no file was given */
+    if (fileCount == 0) { /* If no file was given */
         printf("No File Was Given, Try The Command \"assembler x y\", Where x.as and y.as "
                         "Are Existing Assembly Files.");
         exit(EXIT_FAILURE);
     }
 
-    while (--argc > 0) { /* Go through all files */
-        if ((fp = openFile(*++argv, ASM, "r"))) { /* Open the file as an assembly file */
-            initializeGlobalVariables(); /* Reset all global variables from last run */
-            firstPass(*argv, fp); /* Do the first pass on the file, second pass and file creation will be called from there */
-            fclose(fp); /* Close the current file */
+    if (isWatchMode) { /* The files are read by the watch, first and after every change */
+        for (i = 0; i < fileCount; ++i)
+            if (strcmp(argv[i], "-") == 0) {
+                printf("The Standard Input Can't Be Watched.\n");
+                exit(EXIT_FAILURE);
+            }
+        shouldBatchIO = FALSE; /* A change assembles few files, each one is written when it is assembled */
+        shouldCollectStats = FALSE; /* The run never ends, there's no point to write the statistics at */
+        shouldReportMemory = FALSE; /* The same for the memory report */
+        return watchSources(argv, fileCount, assembleSource);
+    }
+
+    if (shouldBatchIO) /* Many files are read and written in batches */
+        hadSuccessfulRun = assembleInBatches(argv, fileCount);
+    else for (i = 0; i < fileCount; ++i) { /* Go through all files */
+        isStdin = BOOLEANIZE(strcmp(argv[i], "-") == 0);
+        enterMemoryPhase(READ_PHASE);
+        traceBegin("readSourceFile", argv[i]);
+        if ((fp = isStdin ? stdin : openFile(argv[i], ASM, "r"))) { /* Open the file as an assembly file */
+            readSourceFile(fp, isStdin ? STDIN_SOURCE_NAME : argv[i], &source); /* Read the whole source */
+            if (!isStdin)
+                fclose(fp); /* Close the current file */
+            traceEnd("readSourceFile");
+            assembleSource(&source);
+            freeSourceFile(&source);
             hadSuccessfulRun = TRUE;
-        } else /* If fopen returned NULL */
-            printf("\nERROR: Couldn't Open File %s, Try To Check If It Exists,"
-                            " And If You Have The Correct Permissions To Open It.\n", *argv);
+        } else { /* If fopen returned NULL */
+            fprintf(diagnosticsFile, "\nERROR: Couldn't Open File %s, Try To Check If It Exists,"
+                            " And If You Have The Correct Permissions To Open It.\n", argv[i]);
+            hadInvalidSource = TRUE;
+            traceEnd("readSourceFile");
+        }
     }
 
    if (hadSuccessfulRun) {
         freeSymbolTable(&symbolTable);
         freeExternEventsTable(&externEventTable);
     }
+    freeIncludeCache();
+
+    /* The statistics of all the files together */
+    if (shouldCollectStats && !saveWorkloadStats(statsFileName))
+        fprintf(diagnosticsFile, "\nERROR: Couldn't Write The Statistics File %s.\n", statsFileName);
+
+    /* What was allocated by the run, and what is left allocated at its end */
+    if (shouldReportMemory)
+        writeMemoryReport(diagnosticsFile);
+
+    /* The spans of the run, on a timeline */
+    if (traceFileName != NULL && !saveTrace(traceFileName))
+        fprintf(diagnosticsFile, "\nERROR: Couldn't Write The Trace File %s.\n", traceFileName);
 
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    /* A check fails if any source is invalid */
+    return isCheckMode && hadInvalidSource ? EXIT_FAILURE : EXIT_SUCCESS;
+}
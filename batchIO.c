@@ -0,0 +1,428 @@
+/*****************************************
+* Batched File I/O Operations            *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#define _GNU_SOURCE /* For syscall (the C library has no io_uring calls), pread, pwrite */
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "batchIO.h"
+
+/* An operation of a batch, made through the ring or with the plain call */
+typedef struct {
+    unsigned char opcode;    /* IORING_OP_OPENAT / _READ / _WRITE / _FSYNC / _CLOSE                    */
+    int fd;                  /* The descriptor it works on (not for an open)                           */
+    char *path;              /* The path an open opens                                                 */
+    int flags;               /* The flags of an open                                                   */
+    char *buffer;            /* What a read reads into / a write writes                                */
+    unsigned length;         /* The bytes a read / write asks for                                      */
+    unsigned long offset;    /* Where in the file a read / write starts                                */
+    long result;             /* What the call returned (a descriptor, a byte count or 0), or -errno    */
+    Boolean isDone;          /* If it was made                                                         */
+} FileOperation;
+
+/* The rings shared with the kernel, mapped from an io_uring descriptor */
+typedef struct {
+    int fd;                               /* The io_uring descriptor                  */
+    unsigned *sqHead, *sqTail, *sqMask;   /* The submission ring                      */
+    unsigned *sqArray;                    /* The indices of the submitted entries     */
+    struct io_uring_sqe *sqes;            /* The submission entries                   */
+    unsigned sqEntries;                   /* The number of submission entries         */
+    unsigned *cqHead, *cqTail, *cqMask;   /* The completion ring                      */
+    struct io_uring_cqe *cqes;            /* The completion entries                   */
+    void *sqRing, *cqRing;                /* The mappings (the same one on new kernels) */
+    size_t sqRingSize, cqRingSize, sqesSize;
+} Ring;
+
+/* The ring of the batches, set up by the first batch */
+static Ring ring;
+static enum {RING_UNTRIED, RING_READY, RING_UNAVAILABLE} ringState = RING_UNTRIED;
+
+/* Functions */
+/**
+ * This function sets up the ring
+ * @return TRUE on success, else FALSE (io_uring isn't available)
+ * **/
+static Boolean setupRing() {
+    struct io_uring_params params;
+    char *sqRing, *cqRing;
+
+    memset(&params, 0, sizeof(params));
+    if ((ring.fd = (int) syscall(__NR_io_uring_setup, BATCH_RING_ENTRIES, &params)) < 0)
+        return FALSE;
+
+    ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring.sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    /* Newer kernels map both rings together */
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        ring.sqRingSize = ring.cqRingSize = ring.sqRingSize > ring.cqRingSize ? ring.sqRingSize : ring.cqRingSize;
+
+    ring.sqRing = mmap(NULL, ring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED, ring.fd, IORING_OFF_SQ_RING);
+    ring.cqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? ring.sqRing :
+                  mmap(NULL, ring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED, ring.fd, IORING_OFF_CQ_RING);
+    ring.sqes = (struct io_uring_sqe *) mmap(NULL, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED, ring.fd,
+                                             IORING_OFF_SQES);
+    if (ring.sqRing == MAP_FAILED || ring.cqRing == MAP_FAILED || ring.sqes == MAP_FAILED) {
+        close(ring.fd);
+        return FALSE;
+    }
+
+    sqRing = (char *) ring.sqRing;
+    cqRing = (char *) ring.cqRing;
+    ring.sqHead = (unsigned *) (sqRing + params.sq_off.head);
+    ring.sqTail = (unsigned *) (sqRing + params.sq_off.tail);
+    ring.sqMask = (unsigned *) (sqRing + params.sq_off.ring_mask);
+    ring.sqArray = (unsigned *) (sqRing + params.sq_off.array);
+    ring.sqEntries = params.sq_entries;
+    ring.cqHead = (unsigned *) (cqRing + params.cq_off.head);
+    ring.cqTail = (unsigned *) (cqRing + params.cq_off.tail);
+    ring.cqMask = (unsigned *) (cqRing + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *) (cqRing + params.cq_off.cqes);
+    return TRUE;
+}
+
+/**
+ * This function fills the submission entry #sqe for #operation, its completion will carry #index
+ * **/
+static void prepareEntry(struct io_uring_sqe *sqe, FileOperation *operation, unsigned index) {
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = operation->opcode;
+    sqe->user_data = index;
+
+    if (operation->opcode == IORING_OP_OPENAT) {
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (unsigned long) operation->path;
+        sqe->len = OUTPUT_FILE_MODE;
+        sqe->open_flags = (unsigned) operation->flags;
+    } else {
+        sqe->fd = operation->fd;
+        sqe->addr = (unsigned long) operation->buffer;
+        sqe->len = operation->length;
+        sqe->off = operation->offset;
+    }
+}
+
+/**
+ * This function unmaps and closes the ring, it's unavailable from now on
+ * **/
+static void releaseRing() {
+    munmap(ring.sqes, ring.sqesSize);
+    if (ring.cqRing != ring.sqRing)
+        munmap(ring.cqRing, ring.cqRingSize);
+    munmap(ring.sqRing, ring.sqRingSize);
+    close(ring.fd);
+    ringState = RING_UNAVAILABLE;
+}
+
+/**
+ * This function takes the completions the ring holds into #operations, and adds their number to #completed
+ * **/
+static void takeCompletions(FileOperation *operations, unsigned *completed) {
+    struct io_uring_cqe *cqe;
+    unsigned head;
+
+    /* The tail is read before the entries behind it */
+    head = *ring.cqHead;
+    __sync_synchronize();
+    for (; head != *ring.cqTail; ++head, ++*completed) {
+        cqe = ring.cqes + (head & *ring.cqMask);
+        operations[cqe->user_data].result = cqe->res;
+        operations[cqe->user_data].isDone = TRUE;
+    }
+    __sync_synchronize();
+    *ring.cqHead = head;
+}
+
+/**
+ * This function gives the ring up after it failed, while the #submitted operations of #operations from #first were
+ * submitted: the completions it holds are taken, the submitted ones that didn't complete fail (making them again with
+ * the plain calls could close a descriptor that was reused, or open a file twice), then the ring is released
+ * **/
+static void abandonRing(FileOperation *operations, unsigned first, unsigned submitted) {
+    unsigned i, completed = 0;
+
+    takeCompletions(operations, &completed);
+    for (i = first; i < first + submitted; ++i)
+        if (!operations[i].isDone) {
+            operations[i].result = -EIO;
+            operations[i].isDone = TRUE;
+        }
+    releaseRing();
+}
+
+/**
+ * This function makes the #count operations of #operations through the ring, #BATCH_RING_ENTRIES of them
+ * (at most) with every system call
+ * **/
+static void runOnRing(FileOperation *operations, unsigned count) {
+    unsigned done, chunk, i, index, tail, completed, retries;
+    long submitted, toSubmit;
+
+    for (done = 0; done < count; done += chunk) {
+        chunk = count - done < ring.sqEntries ? count - done : ring.sqEntries;
+
+        /* Fill the entries, then publish them by moving the tail (after the entries are visible) */
+        tail = *ring.sqTail;
+        for (i = 0; i < chunk; ++i) {
+            index = (tail + i) & *ring.sqMask;
+            prepareEntry(ring.sqes + index, operations + done + i, done + i);
+            ring.sqArray[index] = index;
+        }
+        __sync_synchronize();
+        *ring.sqTail = tail + chunk;
+        __sync_synchronize();
+
+        /* Submit them and wait for all of them to complete */
+        for (toSubmit = chunk, completed = 0, retries = 0; completed < chunk;) {
+            submitted = syscall(__NR_io_uring_enter, ring.fd, (unsigned) toSubmit, chunk - completed,
+                                IORING_ENTER_GETEVENTS, NULL, 0);
+            if (submitted < 0 && errno == EINTR)
+                continue;
+            if (submitted < 0 && (errno == EAGAIN || errno == EBUSY) && ++retries <= MAX_RING_RETRIES) {
+                takeCompletions(operations, &completed); /* The kernel is short of room, taking them makes some */
+                continue;
+            }
+            if (submitted < 0) { /* What wasn't submitted is made with the plain calls */
+                abandonRing(operations, done, chunk - (unsigned) toSubmit);
+                return;
+            }
+            toSubmit -= submitted < toSubmit ? submitted : toSubmit;
+            takeCompletions(operations, &completed);
+        }
+    }
+}
+
+/**
+ * This function makes #operation with the plain system call
+ * **/
+static void runPlain(FileOperation *operation) {
+    long result = -1;
+
+    switch (operation->opcode) {
+        case IORING_OP_OPENAT:
+            result = open(operation->path, operation->flags, OUTPUT_FILE_MODE);
+            break;
+        case IORING_OP_READ:
+            result = (long) pread(operation->fd, operation->buffer, operation->length, (off_t) operation->offset);
+            break;
+        case IORING_OP_WRITE:
+            result = (long) pwrite(operation->fd, operation->buffer, operation->length, (off_t) operation->offset);
+            break;
+        case IORING_OP_FSYNC:
+            result = fsync(operation->fd);
+            break;
+        case IORING_OP_CLOSE:
+            result = close(operation->fd);
+            break;
+        default:
+            errno = EINVAL;
+            break;
+    }
+
+    operation->result = result < 0 ? -errno : result;
+    operation->isDone = TRUE;
+}
+
+/**
+ * This function makes the #count operations of #operations, through the ring if it's available
+ * **/
+static void runOperations(FileOperation *operations, unsigned count) {
+    unsigned i;
+
+    for (i = 0; i < count; ++i)
+        operations[i].isDone = FALSE;
+
+    if (ringState == RING_UNTRIED)
+        ringState = setupRing() ? RING_READY : RING_UNAVAILABLE;
+    if (ringState == RING_READY)
+        runOnRing(operations, count);
+
+    /* What the ring didn't make, or made on a kernel that doesn't know the operation, is made with the plain calls */
+    for (i = 0; i < count; ++i)
+        if (!operations[i].isDone || operations[i].result == -EINVAL || operations[i].result == -EOPNOTSUPP) {
+            if (operations[i].isDone && ringState == RING_READY) /* The kernel doesn't know it, don't ask again */
+                releaseRing();
+            runPlain(operations + i);
+        }
+}
+
+/**
+ * This function returns #count new operations
+ * **/
+static FileOperation *newOperations(unsigned count) {
+    FileOperation *operations = (FileOperation *) calloc(count ? count : 1, sizeof(FileOperation));
+
+    if (operations == NULL) {
+        perror("newOperations");
+        exit(EXIT_FAILURE);
+    }
+    return operations;
+}
+
+/**
+ * This function opens the #count files of #paths with #flags, and puts their descriptors (-1 for the ones that
+ * couldn't be opened) in #fds
+ * **/
+static void openBatch(char **paths, unsigned count, int flags, int *fds) {
+    FileOperation *operations = newOperations(count);
+    unsigned i, opened = 0;
+
+    /* The missing paths aren't opened */
+    for (i = 0; i < count; ++i)
+        if (paths[i] != NULL) {
+            operations[opened].opcode = IORING_OP_OPENAT;
+            operations[opened].path = paths[i];
+            operations[opened++].flags = flags;
+        }
+    runOperations(operations, opened);
+
+    for (i = 0, opened = 0; i < count; ++i)
+        fds[i] = paths[i] == NULL ? -1 : (int) (operations[opened++].result >= 0 ? operations[opened - 1].result : -1);
+    free(operations);
+}
+
+/**
+ * This function runs #opcode (a sync / a close) on the #count descriptors of #fds that are open, and puts whether it
+ * succeeded in #results
+ * **/
+static void runOnDescriptors(unsigned char opcode, int *fds, unsigned count, Boolean *results) {
+    FileOperation *operations = newOperations(count);
+    unsigned i, used = 0;
+
+    for (i = 0; i < count; ++i)
+        if (fds[i] >= 0) {
+            operations[used].opcode = opcode;
+            operations[used++].fd = fds[i];
+        }
+    runOperations(operations, used);
+
+    for (i = 0, used = 0; i < count; ++i)
+        results[i] = fds[i] >= 0 && operations[used++].result == 0;
+    free(operations);
+}
+
+void readFileBatch(FileRead *reads, unsigned count) {
+    FileOperation *operations = newOperations(count);
+    char **paths = (char **) malloc((count ? count : 1) * sizeof(char *));
+    int *fds = (int *) malloc((count ? count : 1) * sizeof(int));
+    Boolean *isActive = (Boolean *) malloc((count ? count : 1) * sizeof(Boolean));
+    unsigned i, active;
+
+    if (paths == NULL || fds == NULL || isActive == NULL) {
+        perror("readFileBatch");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Open all of them */
+    for (i = 0; i < count; ++i)
+        paths[i] = reads[i].path;
+    openBatch(paths, count, O_RDONLY, fds);
+
+    /* Read all of them, a round after round, until each one ends (a small file ends in the second round) */
+    for (i = 0; i < count; ++i) {
+        reads[i].isRead = FALSE;
+        isActive[i] = BOOLEANIZE(fds[i] >= 0);
+    }
+    do {
+        for (i = 0, active = 0; i < count; ++i)
+            if (isActive[i]) {
+                reserveTextBuffer(&reads[i].content, BATCH_READ_CHUNK);
+                operations[active].opcode = IORING_OP_READ;
+                operations[active].fd = fds[i];
+                operations[active].buffer = reads[i].content.data + reads[i].content.length;
+                operations[active].length = (unsigned) (reads[i].content.capacity - reads[i].content.length);
+                operations[active++].offset = reads[i].content.length;
+            }
+        runOperations(operations, active);
+
+        for (i = 0, active = 0; i < count; ++i)
+            if (isActive[i]) {
+                if (operations[active].result > 0) /* More may follow */
+                    reads[i].content.length += (size_t) operations[active].result;
+                else { /* The end of the file, or an error */
+                    reads[i].isRead = BOOLEANIZE(operations[active].result == 0);
+                    isActive[i] = FALSE;
+                }
+                ++active;
+            }
+    } while (active > 0);
+
+    /* Close all of them */
+    runOnDescriptors(IORING_OP_CLOSE, fds, count, isActive);
+
+    free(isActive);
+    free(fds);
+    free(paths);
+    free(operations);
+}
+
+void writeFileBatch(FileWrite *writes, unsigned count) {
+    FileOperation *operations = newOperations(count);
+    char **paths = (char **) malloc((count ? count : 1) * sizeof(char *));
+    int *fds = (int *) malloc((count ? count : 1) * sizeof(int));
+    size_t *written = (size_t *) calloc(count ? count : 1, sizeof(size_t));
+    Boolean *results = (Boolean *) malloc((count ? count : 1) * sizeof(Boolean));
+    unsigned i, active;
+
+    if (paths == NULL || fds == NULL || written == NULL || results == NULL) {
+        perror("writeFileBatch");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Create all of them */
+    for (i = 0; i < count; ++i)
+        paths[i] = writes[i].path;
+    openBatch(paths, count, O_WRONLY | O_CREAT | O_TRUNC, fds);
+
+    /* Write all of them, a round after round, until each one is written whole (most are in the first round) */
+    for (i = 0; i < count; ++i)
+        writes[i].isWritten = BOOLEANIZE(fds[i] >= 0);
+    do {
+        for (i = 0, active = 0; i < count; ++i)
+            if (writes[i].isWritten && written[i] < writes[i].content.length) {
+                operations[active].opcode = IORING_OP_WRITE;
+                operations[active].fd = fds[i];
+                operations[active].buffer = writes[i].content.data + written[i];
+                operations[active].length = (unsigned) (writes[i].content.length - written[i]);
+                operations[active++].offset = written[i];
+            }
+        runOperations(operations, active);
+
+        for (i = 0, active = 0; i < count; ++i)
+            if (writes[i].isWritten && written[i] < writes[i].content.length) {
+                if (operations[active].result > 0)
+                    written[i] += (size_t) operations[active].result;
+                else
+                    writes[i].isWritten = FALSE;
+                ++active;
+            }
+    } while (active > 0);
+
+    /* Sync, then close all of them */
+    runOnDescriptors(IORING_OP_FSYNC, fds, count, results);
+    for (i = 0; i < count; ++i)
+        writes[i].isWritten = BOOLEANIZE(writes[i].isWritten && results[i]);
+    runOnDescriptors(IORING_OP_CLOSE, fds, count, results);
+    for (i = 0; i < count; ++i)
+        writes[i].isWritten = BOOLEANIZE(writes[i].isWritten && results[i]);
+
+    free(results);
+    free(written);
+    free(fds);
+    free(paths);
+    free(operations);
+}
+
+void endFileBatches() {
+    if (ringState == RING_READY)
+        releaseRing();
+    ringState = RING_UNTRIED;
+}
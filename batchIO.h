@@ -0,0 +1,55 @@
+/*****************************************
+* Batched File I/O Header                *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef BATCH_IO_H
+#define BATCH_IO_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "textBuffer.h"
+
+/* Definitions */
+#define BATCH_RING_ENTRIES 128     /* The operations submitted to the kernel at once                    */
+#define BATCH_FILE_COUNT 128       /* The sources read (and the outputs written) together               */
+#define BATCH_READ_CHUNK 16384     /* The bytes a read of a batch asks for (more are read if it fills)  */
+#define OUTPUT_FILE_MODE 0666      /* The permissions of a new output file (before the umask)           */
+#define MAX_RING_RETRIES 64        /* The times a submission the kernel had no room for is tried again  */
+
+/* Type Definitions */
+/* A file read by a batch */
+typedef struct {
+    char *path;            /* The path of the file                                  */
+    TextBuffer content;    /* Its content                                           */
+    Boolean isRead;        /* If it was read whole                                  */
+} FileRead;
+
+/* A file written by a batch */
+typedef struct {
+    char *path;            /* The path of the file                                  */
+    TextBuffer content;    /* What is written to it                                 */
+    Boolean isWritten;     /* If it was written whole, synced and closed            */
+} FileWrite;
+
+/* Function Prototypes */
+/**
+ * This function reads the #count files of #reads (their content buffers must be initialized). The opens, the reads
+ * and the closes of all of them are submitted together through io_uring, or made one by one with the plain calls
+ * where io_uring isn't available.
+ * **/
+void readFileBatch(FileRead *reads, unsigned count);
+
+/**
+ * This function creates (or truncates) the #count files of #writes, writes their contents and syncs them, batched
+ * like readFileBatch
+ * **/
+void writeFileBatch(FileWrite *writes, unsigned count);
+
+/**
+ * This function releases the ring of the batches (if one was set up)
+ * **/
+void endFileBatches();
+
+#endif
@@ -0,0 +1,142 @@
+/*****************************************
+* Cross Reference Index Operations       *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "crossReference.h"
+#include "symbolHash.h"
+#include "externalVariables.h"
+#include "fileHandling.h"
+
+/* A reference as recorded by the second pass (in address order) */
+typedef struct {
+    char *name;          /* The name of the symbol (owned by the symbol table) */
+    ReferenceSite site;  /* Where it is referred to                            */
+} RecordedReference;
+
+/*
+ * The index is in compressed sparse row form: the symbols are numbered (in the order of the symbol table), the
+ * sites of symbol #i are sites[offsets[i]] .. sites[offsets[i + 1] - 1], and #symbolIndices maps a name to its number.
+ */
+static RecordedReference *recorded = NULL;
+static unsigned recordedCount = 0, recordedCapacity = 0;
+static ReferenceSite *sites = NULL;
+static unsigned *offsets = NULL, symbolCount = 0;
+static SymbolHash symbolIndices;
+static Boolean isIndexBuilt = FALSE;
+
+/* Functions */
+/**
+ * This function frees the index (not the recorded references)
+ * **/
+static void freeCrossReferenceIndex() {
+    if (isIndexBuilt) {
+        freeSymbolHash(&symbolIndices);
+        free(sites);
+        free(offsets);
+        sites = NULL;
+        offsets = NULL;
+        symbolCount = 0;
+        isIndexBuilt = FALSE;
+    }
+}
+
+void resetCrossReferences() {
+    freeCrossReferenceIndex();
+    recordedCount = 0;
+}
+
+void addCrossReference(LabelPointer label, unsigned address, int lineNum, Boolean isSource) {
+    RecordedReference *tmp;
+
+    /* Grow the recorded references (by doubling) if needed */
+    if (recordedCount == recordedCapacity) {
+        recordedCapacity = recordedCapacity ? recordedCapacity * 2 : INITIAL_REFERENCE_CAPACITY;
+        if ((tmp = (RecordedReference *) realloc(recorded, recordedCapacity * sizeof(RecordedReference))) == NULL) {
+            perror("addCrossReference");
+            exit(EXIT_FAILURE);
+        }
+        recorded = tmp;
+    }
+
+    recorded[recordedCount].name = label->labelName;
+    recorded[recordedCount].site.address = address;
+    recorded[recordedCount].site.lineNum = lineNum;
+    recorded[recordedCount].site.isSource = isSource;
+    ++recordedCount;
+}
+
+void buildCrossReferenceIndex() {
+    LabelPointer node;
+    unsigned i, symbol, *next;
+
+    freeCrossReferenceIndex();
+
+    /* Number the symbols */
+    for (node = symbolTable; node; node = node->next)
+        ++symbolCount;
+    initSymbolHash(&symbolIndices, symbolCount);
+    for (node = symbolTable, i = 0; node; node = node->next, ++i)
+        insertSymbol(&symbolIndices, node->labelName, i, 0);
+
+    offsets = (unsigned *) calloc(symbolCount + 1, sizeof(unsigned));
+    next = (unsigned *) malloc((symbolCount + 1) * sizeof(unsigned));
+    sites = (ReferenceSite *) malloc((recordedCount ? recordedCount : 1) * sizeof(ReferenceSite));
+    if (offsets == NULL || next == NULL || sites == NULL) {
+        perror("buildCrossReferenceIndex");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Count the sites of every symbol, the prefix sums are where their sites start */
+    for (i = 0; i < recordedCount; ++i)
+        ++offsets[findSymbol(&symbolIndices, recorded[i].name)->value + 1];
+    for (symbol = 0; symbol < symbolCount; ++symbol) {
+        offsets[symbol + 1] += offsets[symbol];
+        next[symbol] = offsets[symbol];
+    }
+
+    /* Put every site in its place (the recorded order is the address order, and it is kept) */
+    for (i = 0; i < recordedCount; ++i) {
+        symbol = findSymbol(&symbolIndices, recorded[i].name)->value;
+        sites[next[symbol]++] = recorded[i].site;
+    }
+
+    free(next);
+    isIndexBuilt = TRUE;
+}
+
+ReferenceSite *getSymbolReferences(char *name, unsigned *count) {
+    SymbolHashNode *node;
+
+    if (!isIndexBuilt)
+        buildCrossReferenceIndex();
+
+    *count = 0;
+    if ((node = findSymbol(&symbolIndices, name)) == NULL ||
+        (*count = offsets[node->value + 1] - offsets[node->value]) == 0)
+        return NULL;
+
+    return sites + offsets[node->value];
+}
+
+void writeXrefFile(TextBuffer *buffer) {
+    char line[MAX_OUTPUT_LINE_LENGTH];
+    LabelPointer node;
+    ReferenceSite *symbolSites;
+    unsigned i, count;
+
+    /* Every symbol, then a line for each site referring to it */
+    for (node = symbolTable; node; node = node->next) {
+        symbolSites = getSymbolReferences(node->labelName, &count);
+        sprintf(line, "%s\t%u\n", node->labelName, count);
+        appendString(buffer, line);
+
+        for (i = 0; i < count; ++i) {
+            sprintf(line, "\t%04u\tline %d\t%s\n", symbolSites[i].address, symbolSites[i].lineNum,
+                    symbolSites[i].isSource ? "source" : "destination");
+            appendString(buffer, line);
+        }
+    }
+}
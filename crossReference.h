@@ -0,0 +1,53 @@
+/*****************************************
+* Cross Reference Index Header           *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef CROSS_REFERENCE_H
+#define CROSS_REFERENCE_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "textBuffer.h"
+
+/* Definitions */
+#define INITIAL_REFERENCE_CAPACITY 256
+
+/* Type Definitions */
+/* A place where a symbol is used (an operand word in the code image) */
+typedef struct {
+    unsigned address;  /* The address of the operand word             Example: 129 */
+    int lineNum;       /* The line of the operand in the source         Example: 14  */
+    Boolean isSource;  /* If it is the source operand, else the destination         */
+} ReferenceSite;
+
+/* Function Prototypes */
+/**
+ * This function empties the index (before a file is assembled)
+ * **/
+void resetCrossReferences();
+
+/**
+ * This function records a reference to the symbol #label from the operand word at #address, on line #lineNum
+ * **/
+void addCrossReference(LabelPointer label, unsigned address, int lineNum, Boolean isSource);
+
+/**
+ * This function builds the index (the sites of every symbol, next to each other) from the recorded references.
+ * It is built once, the queries after it are answered from it.
+ * **/
+void buildCrossReferenceIndex();
+
+/**
+ * This function returns the sites referring to the symbol #name, in address order
+ * @return The first site (the number of sites is put in #count), or NULL if #name isn't referred to
+ * **/
+ReferenceSite *getSymbolReferences(char *name, unsigned *count);
+
+/**
+ * This function writes the xref file (every symbol and the sites referring to it) into #buffer
+ * **/
+void writeXrefFile(TextBuffer *buffer);
+
+#endif
@@ -0,0 +1,113 @@
+/*****************************************
+* Data Pool Operations                   *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "dataPool.h"
+
+/*
+ * The pool holds every suffix of every item kept in the data image, hashed from its last word backwards so the
+ * hashes of all the suffixes of an item are found in one scan.
+ * An item is a labeled data directive and the unlabeled data directives after it, it is only known to be complete
+ * when the next labeled data directive starts (or the file ends), so its words are installed first and removed
+ * afterwards if they are a duplicate.
+ */
+static PoolEntry pool[POOL_TABLE_SIZE];
+static LabelPointer pendingLabel = NULL;
+static unsigned pendingStart = 0, wordsSaved = 0;
+
+/* Functions */
+/**
+ * This function mixes the word #w into the hash #hash (FNV-1a)
+ * **/
+static unsigned mixWord(unsigned hash, Word w) {
+    unsigned i;
+
+    for (i = 0; i < sizeof(Word); ++i, w >>= 8U) {
+        hash ^= w & 0xFFU;
+        hash *= 16777619U; /* FNV prime */
+    }
+
+    return hash ? hash : 1; /* 0 marks an empty entry */
+}
+
+/**
+ * This function adds the words #start..#start + #length - 1 of the data image, with the hash #hash, to the pool
+ * **/
+static void addPoolEntry(unsigned hash, unsigned start, unsigned length) {
+    unsigned i = hash & (POOL_TABLE_SIZE - 1);
+
+    /* Linear probing (the table is at most half full) */
+    while (pool[i].hash)
+        i = (i + 1) & (POOL_TABLE_SIZE - 1);
+
+    pool[i].hash = hash;
+    pool[i].start = start;
+    pool[i].length = length;
+}
+
+/**
+ * This function looks for #length words equal to the ones at #start in the pool, with the hash #hash
+ * @return Their data address, or #start if they aren't in the pool
+ * **/
+static unsigned findPoolEntry(unsigned hash, unsigned start, unsigned length) {
+    unsigned i = hash & (POOL_TABLE_SIZE - 1);
+
+    for (; pool[i].hash; i = (i + 1) & (POOL_TABLE_SIZE - 1))
+        if (pool[i].hash == hash && pool[i].length == length &&
+            memcmp(dataImage + pool[i].start, dataImage + start, length * sizeof(Word)) == 0)
+            return pool[i].start;
+
+    return start;
+}
+
+void resetDataPool() {
+    memset(pool, 0, sizeof(pool));
+    pendingLabel = NULL;
+    pendingStart = 0;
+    wordsSaved = 0;
+}
+
+void beginPooledItem(LabelPointer label) {
+    endPooledItem();
+    pendingLabel = label;
+    pendingStart = dc;
+    label->value = dc; /* Ending the previous item may have moved dc back */
+}
+
+void endPooledItem() {
+    unsigned i, length = dc - pendingStart, hash = 2166136261U, existing; /* FNV offset basis */
+
+    /* If there is no item, or it's empty */
+    if (pendingLabel == NULL || length == 0) {
+        pendingLabel = NULL;
+        return;
+    }
+
+    /* Hash the words of the item from the last one */
+    for (i = dc; i > pendingStart; --i)
+        hash = mixWord(hash, dataImage[i - 1]);
+
+    if ((existing = findPoolEntry(hash, pendingStart, length)) != pendingStart) {
+        /* The words are already in the data image, remove them and point the label to the existing ones */
+        pendingLabel->value = existing;
+        dc = pendingStart;
+        dataWordsInstalled -= length;
+        wordsSaved += length;
+    } else {
+        /* Add every suffix of the item to the pool (the hash of each one extends the hash of the next one) */
+        hash = 2166136261U;
+        for (i = dc; i > pendingStart; --i) {
+            hash = mixWord(hash, dataImage[i - 1]);
+            addPoolEntry(hash, i - 1, dc - (i - 1));
+        }
+    }
+
+    pendingLabel = NULL;
+}
+
+unsigned getPooledWordsSaved() {
+    return wordsSaved;
+}
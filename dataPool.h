@@ -0,0 +1,48 @@
+/*****************************************
+* Data Pool Header                       *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef DATA_POOL_H
+#define DATA_POOL_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "externalVariables.h"
+
+/* Definitions */
+#define POOL_TABLE_SIZE (2 * MEMORY_SIZE) /* A power of 2, twice the most words (so suffixes) the pool can hold */
+
+/* Type Definitions */
+/* A run of words in the data image that a later item with the same words can share */
+typedef struct {
+    unsigned hash;    /* The hash of the words (0 marks an empty entry)  */
+    unsigned start;   /* The data address of the first word              */
+    unsigned length;  /* The number of words                             */
+} PoolEntry;
+
+/* Function Prototypes */
+/**
+ * This function empties the pool (before a file is assembled)
+ * **/
+void resetDataPool();
+
+/**
+ * This function starts a pooled item: the data words installed from now on (until the next item starts)
+ * belong to #label, which is set to the current dc (after the previous item ended)
+ * **/
+void beginPooledItem(LabelPointer label);
+
+/**
+ * This function ends the current item: if its words are already in the data image (as a whole item or the end
+ * of one), they are removed and its label points to the existing ones, else they are added to the pool
+ * **/
+void endPooledItem();
+
+/**
+ * This function returns the number of data words saved by the pool in the current file
+ * **/
+unsigned getPooledWordsSaved();
+
+#endif
@@ -64,6 +64,7 @@ void insertLabel(LabelList *lst, unsigned int valueP, char *labelNameP, LabelFea
     strcpy(nodeToAdd->labelName, labelNameP); /* Set "labelName" field to #labelNameP */
     nodeToAdd->feature   = featureP;          /* Set "feature" field to #featureP     */
     nodeToAdd->isEntry   = isEntryP;          /* Set "isEntryP" field to #isEntryP    */
+    nodeToAdd->references = 0;                /* No operand refers to it yet          */
 
     /* Attaching the node to #lst at the beginning */
     nodeToAdd->next = *lst; /* Set "next" field to the head of the list #lst. (Could be NULL) */
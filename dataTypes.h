@@ -11,9 +11,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "memoryTracker.h"
 
 /* Definitions */
 #define BITS_IN_WORD ((unsigned ) 15 )
+#define WORD_MASK ((1U << BITS_IN_WORD) - 1)
 #define MAX_DIRECTIVE_LENGTH 16
 
 /* This macro will enforce a Boolean (/ Bit) type on x (non-zero value yield 1) (0 yield 0) */
@@ -43,7 +45,9 @@ typedef enum {
 } Instruction;
 
 /* All possible directives */
-typedef enum {DATA_DIR = 0, STRING_DIR, ENTRY_DIR, EXTERN_DIR, UNKNOWN_DIRECTIVE = -1} Directive;
+typedef enum {
+    DATA_DIR = 0, STRING_DIR, ENTRY_DIR, EXTERN_DIR, INCBIN_DIR, INCLUDE_DIR, UNKNOWN_DIRECTIVE = -1
+} Directive;
 
 /* All possible addressing modes ordered by their number */
 typedef enum {
@@ -59,8 +63,8 @@ typedef enum {ABSOLUTE = 2, RELOCATABLE = 1, EXTERNAL = 0} ARE;
 /* This enum contains all registers (r0 / r1 / r2 / r3 / r4 / r5 / r6 / r7)  */
 typedef enum {R0, R1, R2, R3, R4, R5, R6, R7} Register;
 
-/* This enum contains all file types (Assembly / Object / Entry / Extern) */
-typedef enum {ASM, OBJ, ENT, EXT, UNKNOWN_FILE_TYPE} FileType;
+/* This enum contains all file types (Assembly / Object / Entry / Extern / Map / Cross Reference / Debug) */
+typedef enum {ASM, OBJ, ENT, EXT, MAP, XREF, DBG, UNKNOWN_FILE_TYPE} FileType;
 
 /* This enum contains all error codes */
 typedef enum {
@@ -71,9 +75,16 @@ typedef enum {
               ENTRY_LABEL_DOSENT_EXIST, EXTERN_OPERAND_INVALID, EXTERN_OPERAND_ALREADY_EXIST,
               INVALID_COMMAS,
               STRING_OPERAND_INVALID, DATA_OPERAND_INVALID,
+              DATA_IMAGE_OVERFLOW, INCBIN_OPERANDS_INVALID, INCBIN_FILE_INVALID, INCBIN_WORD_TOO_WIDE,
+              OPERAND_LABEL_UNDEFINED,
+              INCLUDE_OPERAND_INVALID, INCLUDE_FILE_INVALID, INCLUDE_CYCLE,
+              MACRO_NAME_INVALID, MACRO_NAME_ALREADY_EXIST, MACRO_NESTED, MACRO_NOT_ENDED, MACRO_END_INVALID,
               NO_ERROR = -1
 } Error;
 
+/* The severity of a diagnostic */
+typedef enum {SEVERITY_ERROR, SEVERITY_WARNING} Severity;
+
 /*** Dynamic Data Storage ***/
 /* Definition of a label */
 typedef struct LabelNode {
@@ -81,6 +92,7 @@ typedef struct LabelNode {
     char *labelName; /* The name of the label.                     Example : LIST */
     LabelFeature feature; /* The feature of the label              (CODE / DATA)  */
     Boolean isEntry; /* If the label is to be used in other files. (FALSE / TRUE) */
+    unsigned references; /* The number of operands referring to the label.   Example: 3    */
     struct LabelNode *next; /* A pointer to the next label in the list.           */
 } Label;
 
@@ -0,0 +1,61 @@
+/*****************************************
+* Debug Table Lookup                     *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "dataTypes.h"
+#include "debugTable.h"
+#include "fileHandling.h"
+
+/* Functions */
+/**
+ * This function prints every entry of #table
+ * **/
+void printDebugTable(DebugTable *table) {
+    DebugLocation location = {0, 0, 0};
+    size_t offset = 0;
+    unsigned i;
+
+    for (i = 0; i < table->entryCount && (offset = decodeDebugEntry(table, offset, &location)) != 0; ++i) {
+        printf("%04u\t%s:%d:%d\n", location.address, table->sourceName, location.lineNum, location.column);
+    }
+}
+
+int main(int argc, char **argv) {
+    DebugTable table;
+    DebugLocation location;
+    char *fileName, *end;
+    unsigned long address;
+    int i, status = EXIT_SUCCESS;
+
+    if (argc < 2) { /* If no program was given */
+        printf("Try The Command \"debugLookup x [address...]\", Where x.dbg Was Made By \"assembler --debug x\".\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fileName = appendFileSuffix(argv[1], DBG);
+    if (!loadDebugTable(fileName, &table)) {
+        printf("ERROR: Couldn't Read The Debug File %s.\n", fileName);
+        exit(EXIT_FAILURE);
+    }
+    free(fileName);
+
+    /* Without addresses, the whole table is printed */
+    if (argc == 2)
+        printDebugTable(&table);
+
+    for (i = 2; i < argc; ++i) {
+        address = strtoul(argv[i], &end, 10);
+        if (end == argv[i] || *end != '\0')
+            printf("%s\tnot an address\n", argv[i]), status = EXIT_FAILURE;
+        else if (!lookupDebugAddress(&table, (unsigned) address, &location))
+            printf("%04lu\tnot found\n", address), status = EXIT_FAILURE;
+        else
+            printf("%04lu\t%s:%d:%d\n", address, table.sourceName, location.lineNum, location.column);
+    }
+
+    freeDebugTable(&table);
+    return status;
+}
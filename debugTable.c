@@ -0,0 +1,369 @@
+/*****************************************
+* Debug Table Operations                 *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include <limits.h>
+#include "debugTable.h"
+#include "externalVariables.h"
+#include "firstPass.h"
+
+/* A statement that installed words, as recorded by the first pass (addresses are final after it) */
+typedef struct {
+    unsigned offset;   /* The offset of the first word in its image    */
+    int lineNum;       /* The line of the statement                    */
+    int column;        /* The column where the statement starts        */
+} DebugRecord;
+
+/* The records of one image, in offset order */
+typedef struct {
+    DebugRecord *records;
+    unsigned count;
+    unsigned capacity;
+} DebugRecordList;
+
+static DebugRecordList codeRecords = {NULL, 0, 0}, dataRecords = {NULL, 0, 0};
+static int pendingLine = 0, pendingColumn = 0;
+static Boolean isCodeRecorded = FALSE, isDataRecorded = FALSE;
+
+/* Functions */
+void resetDebugTable() {
+    codeRecords.count = dataRecords.count = 0;
+    endDebugLines();
+}
+
+void beginDebugLine(int lineNum, int column) {
+    pendingLine = lineNum;
+    pendingColumn = column;
+    isCodeRecorded = isDataRecorded = FALSE;
+}
+
+void endDebugLines() {
+    pendingLine = 0;
+}
+
+void markDebugWords(Boolean isCode, unsigned offset) {
+    DebugRecordList *list = isCode ? &codeRecords : &dataRecords;
+    DebugRecord *tmp;
+
+    /* Only the first words of a statement (in each image) start an entry */
+    if (pendingLine == 0 || (isCode ? isCodeRecorded : isDataRecorded))
+        return;
+
+    /* Words that were taken back (a pooled data item) don't belong to their statements anymore */
+    while (list->count > 0 && list->records[list->count - 1].offset >= offset)
+        --list->count;
+
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : INITIAL_DEBUG_CAPACITY;
+        if ((tmp = (DebugRecord *) realloc(list->records, list->capacity * sizeof(DebugRecord))) == NULL) {
+            perror("markDebugWords");
+            exit(EXIT_FAILURE);
+        }
+        list->records = tmp;
+    }
+
+    list->records[list->count].offset = offset;
+    list->records[list->count].lineNum = pendingLine;
+    list->records[list->count].column = pendingColumn;
+    ++list->count;
+
+    if (isCode)
+        isCodeRecorded = TRUE;
+    else
+        isDataRecorded = TRUE;
+}
+
+/**
+ * This function appends #value to #buffer as a varint (7 bits in every byte, the lowest first)
+ * **/
+static void appendVarint(TextBuffer *buffer, unsigned long value) {
+    char byte;
+
+    do {
+        byte = (char) (value & VARINT_VALUE_MASK);
+        value >>= VARINT_VALUE_BITS;
+        if (value)
+            byte |= (char) VARINT_MORE_FLAG;
+        appendChars(buffer, &byte, 1);
+    } while (value);
+}
+
+/**
+ * This function reads a varint at #offset of #bytes (#length bytes long) into #value
+ * @return The offset after the varint, or 0 if it isn't whole (it runs past #length or doesn't fit in #value)
+ * **/
+static size_t readVarint(unsigned char *bytes, size_t length, size_t offset, unsigned long *value) {
+    unsigned shift = 0;
+
+    *value = 0;
+    while (offset < length && shift < sizeof(unsigned long) * CHAR_BIT) {
+        *value |= (unsigned long) (bytes[offset] & VARINT_VALUE_MASK) << shift;
+        shift += VARINT_VALUE_BITS;
+        if (!(bytes[offset++] & VARINT_MORE_FLAG))
+            return offset;
+    }
+
+    return 0;
+}
+
+/**
+ * This function appends the location #current, relative to #previous, to #buffer
+ * **/
+static void appendDebugEntry(TextBuffer *buffer, DebugLocation *previous, DebugLocation *current) {
+    unsigned addressDelta = current->address - previous->address;
+    int lineDelta = current->lineNum - previous->lineNum;
+    char byte;
+
+    if (addressDelta < SHORT_ENTRY_LIMIT && lineDelta >= 0 && lineDelta < SHORT_ENTRY_LIMIT) {
+        byte = (char) ((addressDelta << 4U) | ((unsigned) lineDelta << 1U) | (current->column != previous->column));
+        appendChars(buffer, &byte, 1);
+        if (current->column != previous->column)
+            appendVarint(buffer, (unsigned long) current->column);
+    } else {
+        byte = (char) LONG_ENTRY_FLAG;
+        appendChars(buffer, &byte, 1);
+        appendVarint(buffer, addressDelta);
+        appendVarint(buffer, lineDelta >= 0 ? 2UL * lineDelta : 2UL * -lineDelta - 1); /* zigzag */
+        appendVarint(buffer, (unsigned long) current->column);
+    }
+}
+
+size_t decodeDebugEntry(DebugTable *table, size_t offset, DebugLocation *previous) {
+    unsigned char byte;
+    unsigned long value;
+
+    if (offset >= table->entriesLength)
+        return 0;
+    byte = table->entries[offset++];
+
+    if (!(byte & LONG_ENTRY_FLAG)) {
+        previous->address += byte >> 4U;
+        previous->lineNum += (byte >> 1U) & (SHORT_ENTRY_LIMIT - 1);
+        if (byte & 1U) {
+            offset = readVarint(table->entries, table->entriesLength, offset, &value);
+            previous->column = (int) value;
+        }
+    } else {
+        if ((offset = readVarint(table->entries, table->entriesLength, offset, &value)) == 0)
+            return 0;
+        previous->address += (unsigned) value;
+        if ((offset = readVarint(table->entries, table->entriesLength, offset, &value)) == 0)
+            return 0;
+        previous->lineNum += (value & 1U) ? -(int) ((value + 1) / 2) : (int) (value / 2);
+        offset = readVarint(table->entries, table->entriesLength, offset, &value);
+        previous->column = (int) value;
+    }
+
+    return offset;
+}
+
+void writeDebugFile(TextBuffer *buffer) {
+    TextBuffer entries, checkpoints;
+    DebugLocation previous = {0, 0, 0}, current;
+    DebugRecordList *lists[2];
+    unsigned i, list, count = 0, starts[2], ends[2];
+    char *name = sourceName ? sourceName : "";
+
+    /* The code entries come first, then the data ones (the data image follows the code image) */
+    lists[0] = &codeRecords, starts[0] = MEMORY_OFFSET, ends[0] = codeWordsInstalled;
+    lists[1] = &dataRecords, starts[1] = MEMORY_OFFSET + codeWordsInstalled, ends[1] = dataWordsInstalled;
+
+    initTextBuffer(&entries);
+    initTextBuffer(&checkpoints);
+
+    for (list = 0; list < 2; ++list)
+        for (i = 0; i < lists[list]->count && lists[list]->records[i].offset < ends[list]; ++i) {
+            current.address = lists[list]->records[i].offset + starts[list];
+            current.lineNum = lists[list]->records[i].lineNum;
+            current.column = lists[list]->records[i].column;
+
+            /* A checkpoint holds the state of the decoder before its entry */
+            if (count % DEBUG_CHECKPOINT_INTERVAL == 0) {
+                appendVarint(&checkpoints, previous.address);
+                appendVarint(&checkpoints, (unsigned long) previous.lineNum);
+                appendVarint(&checkpoints, (unsigned long) previous.column);
+                appendVarint(&checkpoints, entries.length);
+            }
+
+            appendDebugEntry(&entries, &previous, &current);
+            previous = current;
+            ++count;
+        }
+
+    /* The magic, the source name, the counts, the checkpoints and the entries */
+    appendChars(buffer, DEBUG_TABLE_MAGIC, DEBUG_TABLE_MAGIC_LENGTH);
+    appendChars(buffer, name, strlen(name) + 1);
+    appendVarint(buffer, count);
+    appendVarint(buffer, MEMORY_OFFSET + codeWordsInstalled + dataWordsInstalled);
+    appendVarint(buffer, entries.length);
+    appendChars(buffer, checkpoints.data, checkpoints.length);
+    appendChars(buffer, entries.data, entries.length);
+
+    freeTextBuffer(&entries);
+    freeTextBuffer(&checkpoints);
+}
+
+Boolean loadDebugTable(char *fileName, DebugTable *table) {
+    FILE *file;
+    long size;
+    unsigned char *bytes;
+    size_t offset, nameLength;
+    unsigned i;
+    unsigned long value;
+    DebugLocation location;
+    DebugCheckpoint *checkpoint;
+    Boolean isValid = TRUE;
+
+    table->sourceName = NULL;
+    table->entries = NULL;
+    table->checkpoints = NULL;
+
+    /* Read the whole file */
+    if ((file = fopen(fileName, "rb")) == NULL)
+        return FALSE;
+    if (fseek(file, 0L, SEEK_END) != 0 || (size = ftell(file)) < DEBUG_TABLE_MAGIC_LENGTH) {
+        fclose(file);
+        return FALSE;
+    }
+    rewind(file);
+    if ((bytes = (unsigned char *) malloc((size_t) size)) == NULL) {
+        perror("loadDebugTable");
+        exit(EXIT_FAILURE);
+    }
+    isValid = BOOLEANIZE(fread(bytes, 1, (size_t) size, file) == (size_t) size &&
+                         memcmp(bytes, DEBUG_TABLE_MAGIC, DEBUG_TABLE_MAGIC_LENGTH) == 0 &&
+                         memchr(bytes + DEBUG_TABLE_MAGIC_LENGTH, '\0', size - DEBUG_TABLE_MAGIC_LENGTH) != NULL);
+    fclose(file);
+    if (!isValid) {
+        free(bytes);
+        return FALSE;
+    }
+
+    /* The source name */
+    nameLength = strlen((char *) bytes + DEBUG_TABLE_MAGIC_LENGTH);
+    if ((table->sourceName = (char *) malloc(nameLength + 1)) == NULL) {
+        perror("loadDebugTable");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(table->sourceName, (char *) bytes + DEBUG_TABLE_MAGIC_LENGTH);
+    offset = DEBUG_TABLE_MAGIC_LENGTH + nameLength + 1;
+
+    /* The counts (every entry takes a byte at least, so there can't be more entries than bytes) */
+    offset = readVarint(bytes, (size_t) size, offset, &value);
+    table->entryCount = (unsigned) value;
+    isValid = BOOLEANIZE(offset != 0 && value == table->entryCount);
+    offset = readVarint(bytes, (size_t) size, offset, &value);
+    table->endAddress = (unsigned) value;
+    offset = readVarint(bytes, (size_t) size, offset, &value);
+    table->entriesLength = (size_t) value;
+    if (!isValid || offset == 0 || table->entriesLength > (size_t) size - offset ||
+        table->entryCount > table->entriesLength) {
+        free(bytes);
+        freeDebugTable(table);
+        return FALSE;
+    }
+
+    /* The checkpoints */
+    table->checkpointCount = (table->entryCount + DEBUG_CHECKPOINT_INTERVAL - 1) / DEBUG_CHECKPOINT_INTERVAL;
+    if ((table->checkpoints = (DebugCheckpoint *) malloc((table->checkpointCount + 1) *
+                                                         sizeof(DebugCheckpoint))) == NULL) {
+        perror("loadDebugTable");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < table->checkpointCount; ++i) {
+        offset = readVarint(bytes, (size_t) size, offset, &value);
+        table->checkpoints[i].address = (unsigned) value;
+        offset = readVarint(bytes, (size_t) size, offset, &value);
+        table->checkpoints[i].lineNum = (int) value;
+        offset = readVarint(bytes, (size_t) size, offset, &value);
+        table->checkpoints[i].column = (int) value;
+        offset = readVarint(bytes, (size_t) size, offset, &value);
+        table->checkpoints[i].offset = (size_t) value;
+        isValid = BOOLEANIZE(isValid && offset != 0);
+    }
+
+    /* The entries */
+    if (!isValid || offset + table->entriesLength != (size_t) size) {
+        free(bytes);
+        freeDebugTable(table);
+        return FALSE;
+    }
+    if ((table->entries = (unsigned char *) malloc(table->entriesLength + 1)) == NULL) {
+        perror("loadDebugTable");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(table->entries, bytes + offset, table->entriesLength);
+    free(bytes);
+
+    /* Every entry must be whole, every checkpoint must hold the state before its entry, and the entries must fill
+     * their bytes exactly, so the lookups never decode past them */
+    location.address = 0, location.lineNum = location.column = 0;
+    for (i = 0, offset = 0; isValid && i < table->entryCount; ++i) {
+        checkpoint = table->checkpoints + i / DEBUG_CHECKPOINT_INTERVAL;
+        if (i % DEBUG_CHECKPOINT_INTERVAL == 0)
+            isValid = BOOLEANIZE(checkpoint->offset == offset && checkpoint->address == location.address &&
+                                 checkpoint->lineNum == location.lineNum && checkpoint->column == location.column);
+        isValid = BOOLEANIZE(isValid && (offset = decodeDebugEntry(table, offset, &location)) != 0);
+    }
+    if (!isValid || offset != table->entriesLength) {
+        freeDebugTable(table);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+Boolean lookupDebugAddress(DebugTable *table, unsigned address, DebugLocation *location) {
+    unsigned low = 0, high = table->checkpointCount, middle, i, last;
+    DebugLocation current, next;
+    size_t offset;
+
+    if (table->entryCount == 0 || address >= table->endAddress)
+        return FALSE;
+
+    /* Binary search the last checkpoint whose entry doesn't start after #address */
+    while (high - low > 1) {
+        middle = (low + high) / 2;
+        current.address = table->checkpoints[middle].address;
+        current.lineNum = table->checkpoints[middle].lineNum;
+        current.column = table->checkpoints[middle].column;
+        decodeDebugEntry(table, table->checkpoints[middle].offset, &current);
+
+        if (current.address <= address)
+            low = middle;
+        else
+            high = middle;
+    }
+
+    /* Decode the entries after it, up to the last one that doesn't start after #address */
+    current.address = table->checkpoints[low].address;
+    current.lineNum = table->checkpoints[low].lineNum;
+    current.column = table->checkpoints[low].column;
+    offset = decodeDebugEntry(table, table->checkpoints[low].offset, &current);
+    if (current.address > address)
+        return FALSE;
+
+    last = (low + 1) * DEBUG_CHECKPOINT_INTERVAL;
+    for (i = low * DEBUG_CHECKPOINT_INTERVAL + 1; i < last && i < table->entryCount; ++i) {
+        next = current;
+        offset = decodeDebugEntry(table, offset, &next);
+        if (next.address > address)
+            break;
+        current = next;
+    }
+
+    *location = current;
+    return TRUE;
+}
+
+void freeDebugTable(DebugTable *table) {
+    free(table->sourceName);
+    free(table->entries);
+    free(table->checkpoints);
+    table->sourceName = NULL;
+    table->entries = NULL;
+    table->checkpoints = NULL;
+}
@@ -0,0 +1,110 @@
+/*****************************************
+* Debug Table Header                     *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef DEBUG_TABLE_H
+#define DEBUG_TABLE_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "textBuffer.h"
+
+/* Definitions */
+#define DEBUG_TABLE_MAGIC "ASDB"
+#define DEBUG_TABLE_MAGIC_LENGTH 4
+#define DEBUG_CHECKPOINT_INTERVAL 64   /* The entries between two checkpoints (decoded linearly by a lookup)  */
+#define INITIAL_DEBUG_CAPACITY 256
+
+/*
+ * An entry is encoded relative to the one before it. Most entries take a single byte:
+ * 0aaallc (a: the address delta 0-7, l: the line delta 0-7, c: the column changed), followed by the column
+ * (a varint) if it changed. Other entries start with 0x80 and hold the address delta, the line delta (zigzag)
+ * and the column as varints.
+ */
+#define SHORT_ENTRY_LIMIT 8
+#define LONG_ENTRY_FLAG 0x80U
+#define VARINT_MORE_FLAG 0x80U
+#define VARINT_VALUE_MASK 0x7FU
+#define VARINT_VALUE_BITS 7
+
+/* Type Definitions */
+/* Where a word of the image came from */
+typedef struct {
+    unsigned address;  /* The address of the first word of the statement  Example: 100 */
+    int lineNum;       /* The line of the statement                         Example: 4   */
+    int column;        /* The column (1 based) where the statement starts   Example: 7   */
+} DebugLocation;
+
+/* The state of the decoder at an entry (every DEBUG_CHECKPOINT_INTERVAL entries) */
+typedef struct {
+    unsigned address;  /* The address of the entry before it (0 for the first one)  */
+    int lineNum;       /* The line of the entry before it                          */
+    int column;        /* The column of the entry before it                        */
+    size_t offset;     /* Where the entry starts in the encoded entries            */
+} DebugCheckpoint;
+
+/* A debug table loaded from a .dbg file */
+typedef struct {
+    char *sourceName;               /* The source the image was assembled from  */
+    unsigned entryCount;            /* The number of entries                    */
+    unsigned endAddress;            /* The address after the last word          */
+    unsigned char *entries;         /* The encoded entries                      */
+    size_t entriesLength;           /* The number of bytes in #entries          */
+    DebugCheckpoint *checkpoints;   /* The checkpoints, in address order        */
+    unsigned checkpointCount;       /* The number of checkpoints                */
+} DebugTable;
+
+/* Function Prototypes */
+/**
+ * This function empties the recorded entries (before a file is assembled)
+ * **/
+void resetDebugTable();
+
+/**
+ * This function starts the statement on line #lineNum, that starts at column #column: the first code or data
+ * words installed from now on are attributed to it
+ * **/
+void beginDebugLine(int lineNum, int column);
+
+/**
+ * This function is told that words are installed at #offset of the code image (#isCode) or data image
+ * **/
+void markDebugWords(Boolean isCode, unsigned offset);
+
+/**
+ * This function stops attributing installed words to a statement
+ * **/
+void endDebugLines();
+
+/**
+ * This function writes the debug file (the recorded entries with their final addresses, encoded) into #buffer
+ * **/
+void writeDebugFile(TextBuffer *buffer);
+
+/**
+ * This function reads the debug file #fileName into #table, checking that every entry is whole and that the
+ * checkpoints agree with the entries
+ * @return TRUE on success, else FALSE (the file can't be read, or it isn't a valid debug table)
+ * **/
+Boolean loadDebugTable(char *fileName, DebugTable *table);
+
+/**
+ * This function finds the statement that the word at #address came from
+ * @return TRUE if found (it is put in #location), else FALSE
+ * **/
+Boolean lookupDebugAddress(DebugTable *table, unsigned address, DebugLocation *location);
+
+/**
+ * This function decodes the entry at #offset of #table, after the entry #previous (it is updated to the entry)
+ * @return The offset of the next entry, or 0 if the entry isn't whole (it starts or runs past the entries)
+ * **/
+size_t decodeDebugEntry(DebugTable *table, size_t offset, DebugLocation *previous);
+
+/**
+ * This function frees the memory held by #table
+ * **/
+void freeDebugTable(DebugTable *table);
+
+#endif
@@ -0,0 +1,123 @@
+/*****************************************
+* Instruction Decoding Operations        *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "dataTypes.h"
+#include "decoder.h"
+#include "firstPass.h"
+#include "secondPass.h"
+#include "utils.h"
+
+/* Lookup Tables */
+/* The addressing mode of every value of a (one-hot) addressing mode field */
+static const AddressingMode addressingModeTable[ADDRESSING_MODE_FIELD_MASK + 1] = {
+    UNKNOWN_ADDRESSING_MODE,                            /* 0000 - No operand */
+    IMMEDIATE,                                          /* 0001 */
+    DIRECT,                                             /* 0010 */
+    UNKNOWN_ADDRESSING_MODE,                            /* 0011 */
+    REGISTER_INDIRECT,                                  /* 0100 */
+    UNKNOWN_ADDRESSING_MODE, UNKNOWN_ADDRESSING_MODE,   /* 0101, 0110 */
+    UNKNOWN_ADDRESSING_MODE,                            /* 0111 */
+    REGISTER_DIRECT,                                    /* 1000 */
+    UNKNOWN_ADDRESSING_MODE, UNKNOWN_ADDRESSING_MODE,   /* 1001, 1010 */
+    UNKNOWN_ADDRESSING_MODE, UNKNOWN_ADDRESSING_MODE,   /* 1011, 1100 */
+    UNKNOWN_ADDRESSING_MODE, UNKNOWN_ADDRESSING_MODE,   /* 1101, 1110 */
+    UNKNOWN_ADDRESSING_MODE                             /* 1111 */
+};
+
+/* The mnemonic of every instruction, ordered by opcode */
+static char *mnemonicTable[OPCODE_FIELD_MASK + 1] = {
+    "mov", "cmp", "add", "sub", "lea", "clr", "not", "inc",
+    "dec", "jmp", "bne", "red", "prn", "jsr", "rts", "stop"
+};
+
+/* Functions */
+AddressingMode decodeAddressingMode(Word w, Boolean isSource) {
+    unsigned offset = isSource ? SOURCE_ADDRESSING_MODE_OFFSET : DEST_ADDRESSING_MODE_OFFSET;
+
+    return addressingModeTable[(w >> offset) & ADDRESSING_MODE_FIELD_MASK];
+}
+
+Boolean decodeFirstWord(Word w, DecodedWord *decoded) {
+    unsigned srcField  = (w >> SOURCE_ADDRESSING_MODE_OFFSET) & ADDRESSING_MODE_FIELD_MASK;
+    unsigned destField = (w >> DEST_ADDRESSING_MODE_OFFSET) & ADDRESSING_MODE_FIELD_MASK;
+
+    decoded->inst     = (Instruction) ((w >> OPCODE_OFFSET) & OPCODE_FIELD_MASK);
+    decoded->srcMode  = addressingModeTable[srcField];
+    decoded->destMode = addressingModeTable[destField];
+    decoded->are      = getState(w, EXTERNAL) ? EXTERNAL : getState(w, RELOCATABLE) ? RELOCATABLE : ABSOLUTE;
+    decoded->width    = 1 + getOperandInstructionWidth(decoded->srcMode, decoded->destMode);
+
+    /* A non-empty field must hold exactly one mode */
+    if ((srcField && decoded->srcMode == UNKNOWN_ADDRESSING_MODE) ||
+        (destField && decoded->destMode == UNKNOWN_ADDRESSING_MODE))
+        return FALSE;
+
+    /* First words are always absolute, and the modes must be legal for the instruction */
+    return (w & ((1U << ARE_OFFSET) - 1)) == (1U << ABSOLUTE) &&
+           hasCorrectAddressingModes(decoded->inst, decoded->srcMode, decoded->destMode);
+}
+
+Register decodeRegister(Word w, Boolean isSource) {
+    unsigned offset = isSource ? SOURCE_REGISTER_NUM_OFFSET : DEST_REGISTER_NUM_OFFSET;
+
+    return (Register) ((w >> offset) & REGISTER_FIELD_MASK);
+}
+
+int decodeOperandValue(Word w) {
+    int value = (int) ((w & WORD_MASK) >> ARE_OFFSET);
+
+    /* The value field is a 12 bit two's complement number */
+    if (value & (1 << (OPERAND_VALUE_BITS - 1)))
+        value -= (1 << OPERAND_VALUE_BITS);
+
+    return value;
+}
+
+int signExtendWord(Word w) {
+    int value = (int) (w & WORD_MASK);
+
+    /* A word is a 15 bit two's complement number */
+    if (value & (1 << (BITS_IN_WORD - 1)))
+        value -= (1 << BITS_IN_WORD);
+
+    return value;
+}
+
+char *getInstructionMnemonic(Instruction inst) {
+    if (inst < MOV_INST || inst > STOP_INST)
+        return "???";
+
+    return mnemonicTable[inst];
+}
+
+char *getAddressingModeName(AddressingMode mode) {
+    switch (mode) {
+        case IMMEDIATE:
+            return "immediate";
+        case DIRECT:
+            return "direct";
+        case REGISTER_INDIRECT:
+            return "register indirect";
+        case REGISTER_DIRECT:
+            return "register direct";
+        case UNKNOWN_ADDRESSING_MODE:
+        default:
+            return "none";
+    }
+}
+
+char *getAREName(ARE are) {
+    switch (are) {
+        case ABSOLUTE:
+            return "A";
+        case RELOCATABLE:
+            return "R";
+        case EXTERNAL:
+        default:
+            return "E";
+    }
+}
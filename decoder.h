@@ -0,0 +1,72 @@
+/*****************************************
+* Instruction Decoding Header            *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef DECODER_H
+#define DECODER_H
+
+/*Imports */
+#include "dataTypes.h"
+
+/* Definitions */
+#define ADDRESSING_MODE_FIELD_MASK ((1U << 4) - 1)
+#define OPCODE_FIELD_MASK ((1U << 4) - 1)
+#define REGISTER_FIELD_MASK ((1U << 3) - 1)
+#define OPERAND_VALUE_BITS (12)
+#define MAX_INSTRUCTION_WIDTH (3)
+
+/* Type Definitions */
+/* The fields of the first word of an instruction */
+typedef struct {
+    Instruction inst;         /* The instruction (by its opcode)                           */
+    AddressingMode srcMode;   /* The addressing mode of the source operand (could be none) */
+    AddressingMode destMode;  /* The addressing mode of the dest operand   (could be none) */
+    ARE are;                  /* The ARE field of the word                                 */
+    unsigned width;           /* The number of words of the instruction (first included)  */
+} DecodedWord;
+
+/* Function Prototypes */
+/**
+ * This function decodes the first word of an instruction #w into #decoded
+ * @return TRUE if #w is a legal first word (legal modes for its instruction, an absolute ARE), else FALSE
+ * **/
+Boolean decodeFirstWord(Word w, DecodedWord *decoded);
+
+/**
+ * This function returns the addressing mode held in a one-hot field of a first word (or UNKNOWN if empty / illegal)
+ * **/
+AddressingMode decodeAddressingMode(Word w, Boolean isSource);
+
+/**
+ * This function returns the register held in an operand word
+ * **/
+Register decodeRegister(Word w, Boolean isSource);
+
+/**
+ * This function returns the (sign-extended) value held in an immediate / direct operand word
+ * **/
+int decodeOperandValue(Word w);
+
+/**
+ * This function returns the name of an instruction ("mov", "cmp", ...), or "???" if unknown
+ * **/
+char *getInstructionMnemonic(Instruction inst);
+
+/**
+ * This function returns the name of an addressing mode ("immediate", "direct", ...), or "none"
+ * **/
+char *getAddressingModeName(AddressingMode mode);
+
+/**
+ * This function returns the name of an ARE option ("A", "R" or "E")
+ * **/
+char *getAREName(ARE are);
+
+/**
+ * This function returns a word as a signed 15 bit number
+ * **/
+int signExtendWord(Word w);
+
+#endif
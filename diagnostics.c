@@ -0,0 +1,76 @@
+/*****************************************
+* Diagnostics Operations                 *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "diagnostics.h"
+#include "textBuffer.h"
+#include "externalVariables.h"
+#include "utils.h"
+
+/* The diagnostics of the current file, and the text that will be printed for it */
+static Diagnostic *diagnostics = NULL;
+static unsigned diagnosticCount = 0, diagnosticCapacity = 0, errorCount = 0;
+static TextBuffer reportedText = {NULL, 0, 0};
+
+/* Functions */
+void resetDiagnostics() {
+    diagnosticCount = 0;
+    errorCount = 0;
+    clearTextBuffer(&reportedText);
+}
+
+void reportDiagnostic(Severity severity, int lineNum, int column, Error err) {
+    Diagnostic *tmp;
+    char line[MAX_DIAGNOSTIC_LINE_LENGTH];
+
+    /* Grow the diagnostics array (by doubling) if needed */
+    if (diagnosticCount == diagnosticCapacity) {
+        diagnosticCapacity = diagnosticCapacity ? diagnosticCapacity * 2 : 16;
+        if ((tmp = (Diagnostic *) realloc(diagnostics, diagnosticCapacity * sizeof(Diagnostic))) == NULL) {
+            perror("reportDiagnostic");
+            exit(EXIT_FAILURE);
+        }
+        diagnostics = tmp;
+    }
+
+    diagnostics[diagnosticCount].severity = severity;
+    diagnostics[diagnosticCount].lineNum = lineNum;
+    diagnostics[diagnosticCount].column = column;
+    diagnostics[diagnosticCount].err = err;
+    ++diagnosticCount;
+
+    if (severity == SEVERITY_ERROR)
+        ++errorCount;
+
+    sprintf(line, "%s Stats For Line no. %d, Column %d:\t%s\n", severity == SEVERITY_ERROR ? "Error" : "Warning",
+            lineNum, column, getErrorMessage(err));
+    appendString(&reportedText, line);
+}
+
+void reportText(char *text) {
+    if (!isQuietMode)
+        appendString(&reportedText, text);
+}
+
+Boolean hadErrors() {
+    return BOOLEANIZE(errorCount > 0);
+}
+
+Boolean reachedErrorLimit() {
+    return BOOLEANIZE(maxErrors && errorCount >= maxErrors);
+}
+
+Diagnostic *getDiagnostics(unsigned *count) {
+    *count = diagnosticCount;
+    return diagnostics;
+}
+
+void flushDiagnostics() {
+    /* One write for the whole file */
+    writeTextBuffer(&reportedText, diagnosticsFile);
+    fflush(diagnosticsFile);
+    clearTextBuffer(&reportedText);
+}
@@ -0,0 +1,61 @@
+/*****************************************
+* Diagnostics Header                     *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+/*Imports */
+#include "dataTypes.h"
+
+/* Definitions */
+#define MAX_DIAGNOSTIC_LINE_LENGTH 160
+
+/* Type Definitions */
+/* A diagnostic reported on a line of the current file */
+typedef struct {
+    Severity severity; /* Error / Warning                                   */
+    int lineNum;       /* The line of the diagnostic                        */
+    int column;        /* The column of the diagnostic (1 based)            */
+    Error err;         /* What went wrong                                   */
+} Diagnostic;
+
+/* Function Prototypes */
+/**
+ * This function empties the diagnostics of the current file (call it before every file)
+ * **/
+void resetDiagnostics();
+
+/**
+ * This function reports a diagnostic on line #lineNum, column #column of the current file
+ * **/
+void reportDiagnostic(Severity severity, int lineNum, int column, Error err);
+
+/**
+ * This function reports a progress message (dropped in quiet mode)
+ * **/
+void reportText(char *text);
+
+/**
+ * This function returns whether if any error was reported for the current file
+ * **/
+Boolean hadErrors();
+
+/**
+ * This function returns whether if the current file reached the maximal number of errors (if one was set)
+ * **/
+Boolean reachedErrorLimit();
+
+/**
+ * This function returns the diagnostics reported for the current file, and their number in #count
+ * **/
+Diagnostic *getDiagnostics(unsigned *count);
+
+/**
+ * This function writes everything reported for the current file to #diagnosticsFile at once
+ * **/
+void flushDiagnostics();
+
+#endif
@@ -0,0 +1,354 @@
+/*****************************************
+* Disassembler                           *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include "dataTypes.h"
+#include "objectFile.h"
+#include "decoder.h"
+#include "symbolHash.h"
+#include "textBuffer.h"
+#include "firstPass.h"
+#include "secondPass.h"
+#include "trace.h"
+
+/* Definitions */
+#define MAX_DISASSEMBLY_THREADS 64
+#define MAX_DISASSEMBLED_LINE_LENGTH 256
+#define MAX_OPERAND_TEXT_LENGTH 48
+/* Smaller images are not worth the threads */
+#define MIN_WORDS_PER_THREAD 4096
+
+/* Type Definitions */
+/* The symbolic information of an image, indexed by the index of a word in the image */
+typedef struct {
+    ObjectModule *module;         /* The disassembled module                                      */
+    char **labels;                /* The label of every word (an entry / a synthesized one / NULL) */
+    char **externNames;           /* The external symbol used by every word (or NULL)             */
+    unsigned char *isInstruction; /* Whether if a code word is the first word of an instruction   */
+    unsigned illegalWords;        /* The number of code words that aren't a legal instruction      */
+} ImageSymbols;
+
+/* A range of the image that is disassembled into its own buffer */
+typedef struct {
+    ImageSymbols *symbols; /* The symbolic information of the image             */
+    unsigned first, last;  /* The range of word indexes [first, last)           */
+    TextBuffer text;       /* The disassembly of the range                      */
+} DisassemblyJob;
+
+/* Functions */
+/**
+ * This function writes the text of an operand of mode #mode held in #operandWord (the word in index #index) into #text
+ * **/
+void formatOperand(ImageSymbols *symbols, AddressingMode mode, Word operandWord, unsigned index, Boolean isSource,
+                   char *text) {
+    unsigned address;
+
+    switch (mode) {
+        case IMMEDIATE:
+            sprintf(text, "#%d", decodeOperandValue(operandWord));
+            break;
+        case DIRECT:
+            address = (operandWord & WORD_MASK) >> ARE_OFFSET;
+            if (getState(operandWord, EXTERNAL))
+                sprintf(text, "%s", symbols->externNames[index] ? symbols->externNames[index] : "???");
+            else if (address >= MEMORY_OFFSET && address - MEMORY_OFFSET <
+                     symbols->module->codeWords + symbols->module->dataWords &&
+                     symbols->labels[address - MEMORY_OFFSET])
+                sprintf(text, "%s", symbols->labels[address - MEMORY_OFFSET]);
+            else
+                sprintf(text, "%u", address);
+            break;
+        case REGISTER_INDIRECT:
+            sprintf(text, "*r%d", decodeRegister(operandWord, isSource));
+            break;
+        case REGISTER_DIRECT:
+            sprintf(text, "r%d", decodeRegister(operandWord, isSource));
+            break;
+        case UNKNOWN_ADDRESSING_MODE:
+        default:
+            *text = '\0';
+            break;
+    }
+}
+
+/**
+ * This function appends the octal form of word #index (and its ARE option if it isn't absolute) to #line
+ * **/
+void appendWordAnnotation(ImageSymbols *symbols, unsigned index, Boolean isOperand, char *line) {
+    Word w = symbols->module->image[index];
+
+    sprintf(line + strlen(line), " %05o", w);
+    if (isOperand && !getState(w, ABSOLUTE))
+        sprintf(line + strlen(line), "(%s)", getAREName(getState(w, EXTERNAL) ? EXTERNAL : RELOCATABLE));
+}
+
+/**
+ * This function disassembles the words in the range of #job into its buffer
+ * **/
+void *disassembleRange(void *arg) {
+    DisassemblyJob *job = (DisassemblyJob *) arg;
+    ImageSymbols *symbols = job->symbols;
+    ObjectModule *module = symbols->module;
+    char line[MAX_DISASSEMBLED_LINE_LENGTH], statement[MAX_DISASSEMBLED_LINE_LENGTH];
+    char srcText[MAX_OPERAND_TEXT_LENGTH], destText[MAX_OPERAND_TEXT_LENGTH];
+    unsigned i, index, srcIndex, destIndex;
+    Boolean isSrcRegister, isDestRegister;
+    DecodedWord decoded;
+
+    initTextBuffer(&job->text);
+    traceBegin("disassembleRange", module->name);
+
+    for (index = job->first; index < job->last; index += decoded.width) {
+        decoded.width = 1;
+
+        /*
+         * The address and the words are annotated in a comment line before the statement
+         * (the assembler only accepts whole line comments, so the output can be assembled again)
+         */
+        sprintf(line, "; %04u", index + MEMORY_OFFSET);
+        sprintf(statement, "%s%s", symbols->labels[index] ? symbols->labels[index] : "",
+                symbols->labels[index] ? ":\t" : "\t");
+
+        if (index >= module->codeWords) { /* A data word */
+            appendWordAnnotation(symbols, index, FALSE, line);
+            sprintf(statement + strlen(statement), ".data %d", signExtendWord(module->image[index]));
+
+        } else if (!symbols->isInstruction[index] || !decodeFirstWord(module->image[index], &decoded) ||
+                   index + decoded.width > module->codeWords) { /* A word that isn't an instruction */
+            decoded.width = 1;
+            appendWordAnnotation(symbols, index, FALSE, line);
+            strcat(line, " (Illegal Instruction, Written As Data: Assembled Again, It Moves To The Data Image)");
+            sprintf(statement + strlen(statement), ".data %d", signExtendWord(module->image[index]));
+
+        } else { /* An instruction, its operand words are consumed as getOperandInstructionWidth defines them */
+            isSrcRegister  = BOOLEANIZE(decoded.srcMode  == REGISTER_INDIRECT || decoded.srcMode  == REGISTER_DIRECT);
+            isDestRegister = BOOLEANIZE(decoded.destMode == REGISTER_INDIRECT || decoded.destMode == REGISTER_DIRECT);
+            if (isSrcRegister && isDestRegister)
+                srcIndex = destIndex = index + 1;
+            else if (decoded.srcMode != UNKNOWN_ADDRESSING_MODE)
+                srcIndex = index + 1, destIndex = index + 2;
+            else
+                srcIndex = index, destIndex = index + 1;
+
+            formatOperand(symbols, decoded.srcMode, module->image[srcIndex], srcIndex, TRUE, srcText);
+            formatOperand(symbols, decoded.destMode, module->image[destIndex], destIndex, FALSE, destText);
+
+            strcat(statement, getInstructionMnemonic(decoded.inst));
+            if (*srcText)
+                sprintf(statement + strlen(statement), " %s,", srcText);
+            if (*destText)
+                sprintf(statement + strlen(statement), " %s", destText);
+
+            for (i = 0; i < decoded.width; ++i)
+                appendWordAnnotation(symbols, index + i, BOOLEANIZE(i > 0), line);
+        }
+
+        strcat(line, "\n");
+        strcat(statement, "\n");
+        appendString(&job->text, line);
+        appendString(&job->text, statement);
+    }
+
+    traceEnd("disassembleRange");
+    return NULL;
+}
+
+/**
+ * This function fills #symbols for #module: entry labels, extern usages, instruction starts, and a synthesized
+ * label for every relocatable target without an entry label (one that isn't a name of the module already)
+ * **/
+void buildImageSymbols(ObjectModule *module, ImageSymbols *symbols) {
+    unsigned i, suffix, address, totalWords = module->codeWords + module->dataWords;
+    long index;
+    DecodedWord decoded;
+    char label[MAX_OPERAND_TEXT_LENGTH];
+    SymbolHash names;
+
+    symbols->module = module;
+    symbols->labels = (char **) calloc(totalWords + 1, sizeof(char *));
+    symbols->externNames = (char **) calloc(totalWords + 1, sizeof(char *));
+    symbols->isInstruction = (unsigned char *) calloc(totalWords + 1, 1);
+    symbols->illegalWords = 0;
+    if (!symbols->labels || !symbols->externNames || !symbols->isInstruction) {
+        perror("buildImageSymbols");
+        exit(EXIT_FAILURE);
+    }
+    initSymbolHash(&names, module->entryCount + module->externCount + module->codeWords); /* It never grows */
+
+    /* Entry symbols name their addresses */
+    for (i = 0; i < module->entryCount; ++i) {
+        insertSymbol(&names, module->entries[i].name, 0, 0);
+        if ((index = getImageIndex(module, module->entries[i].address)) >= 0)
+            symbols->labels[index] = module->entries[i].name;
+    }
+
+    /* Extern records name the operand words that use them */
+    for (i = 0; i < module->externCount; ++i) {
+        insertSymbol(&names, module->externs[i].name, 0, 0);
+        if ((index = getImageIndex(module, module->externs[i].address)) >= 0)
+            symbols->externNames[index] = module->externs[i].name;
+    }
+
+    /* Find the instruction boundaries and the relocatable targets */
+    for (i = 0; i < module->codeWords; i += decoded.width) {
+        symbols->isInstruction[i] = TRUE;
+        if (!decodeFirstWord(module->image[i], &decoded) || i + decoded.width > module->codeWords) {
+            decoded.width = 1;
+            ++symbols->illegalWords;
+            continue;
+        }
+
+        for (index = i + 1; index < i + decoded.width; ++index) {
+            if (!getState(module->image[index], RELOCATABLE))
+                continue;
+            address = (module->image[index] & WORD_MASK) >> ARE_OFFSET;
+            if (address < MEMORY_OFFSET || address - MEMORY_OFFSET >= totalWords ||
+                symbols->labels[address - MEMORY_OFFSET])
+                continue;
+
+            /* The name of an entry or an extern (like L0105) isn't taken, the label gets a suffix instead */
+            sprintf(label, "L%04u", address);
+            for (suffix = 1; findSymbol(&names, label) != NULL; ++suffix)
+                sprintf(label, "L%04uX%u", address, suffix);
+            insertSymbol(&names, label, 0, 0);
+
+            if ((symbols->labels[address - MEMORY_OFFSET] = (char *) malloc(strlen(label) + 1)) == NULL) {
+                perror("buildImageSymbols");
+                exit(EXIT_FAILURE);
+            }
+            strcpy(symbols->labels[address - MEMORY_OFFSET], label);
+        }
+    }
+
+    freeSymbolHash(&names);
+}
+
+/**
+ * This function writes the .extern / .entry declarations of #module to #file (each extern once)
+ * **/
+void writeDeclarations(ObjectModule *module, FILE *file) {
+    SymbolHash seen;
+    unsigned i;
+
+    initSymbolHash(&seen, module->externCount);
+    for (i = 0; i < module->externCount; ++i)
+        if (insertSymbol(&seen, module->externs[i].name, 0, 0) == NULL)
+            fprintf(file, ".extern %s\n", module->externs[i].name);
+    freeSymbolHash(&seen);
+
+    for (i = 0; i < module->entryCount; ++i)
+        fprintf(file, ".entry %s\n", module->entries[i].name);
+}
+
+int main(int argc, char **argv) {
+    ObjectModule module;
+    ImageSymbols symbols;
+    DisassemblyJob *jobs;
+    pthread_t threads[MAX_DISASSEMBLY_THREADS];
+    unsigned i, jobCount = 1, threadCount = 1, totalWords, split;
+    char *outputName = NULL, *traceName = NULL;
+    FILE *output = stdout;
+
+    /* Read the options */
+    for (--argc, ++argv; argc > 1 && **argv == '-'; --argc, ++argv) {
+        if (strcmp(*argv, "-j") == 0 && argc > 2)
+            threadCount = (unsigned) atoi(*++argv), --argc;
+        else if (strcmp(*argv, "-o") == 0 && argc > 2)
+            outputName = *++argv, --argc;
+        else if (strcmp(*argv, "-t") == 0 && argc > 2) /* The spans of the threads are written to a trace file */
+            traceName = *++argv, --argc;
+        else {
+            printf("Unknown Option %s.\n", *argv);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc != 1) {
+        printf("Try The Command \"disassembler [-j threads] [-o out.as] [-t trace.json] x\", Where x.obj Is An "
+               "Object File.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (threadCount < 1)
+        threadCount = 1;
+    if (threadCount > MAX_DISASSEMBLY_THREADS)
+        threadCount = MAX_DISASSEMBLY_THREADS;
+
+    if (traceName != NULL)
+        startTrace();
+
+    traceBegin("loadObjectModule", *argv);
+    if (!loadObjectModule(*argv, &module))
+        exit(EXIT_FAILURE);
+    traceEnd("loadObjectModule");
+
+    if (outputName && (output = fopen(outputName, "w")) == NULL) {
+        printf("ERROR: Couldn't Create %s.\n", outputName);
+        exit(EXIT_FAILURE);
+    }
+
+    totalWords = module.codeWords + module.dataWords;
+    traceBegin("buildImageSymbols", module.name);
+    buildImageSymbols(&module, &symbols);
+    traceEnd("buildImageSymbols");
+
+    /* Split the image between the jobs, only at instruction boundaries */
+    while (jobCount < threadCount && totalWords / (jobCount + 1) >= MIN_WORDS_PER_THREAD)
+        ++jobCount;
+    if ((jobs = (DisassemblyJob *) calloc(jobCount, sizeof(DisassemblyJob))) == NULL) {
+        perror("disassembler");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0, split = 0; i < jobCount; ++i) {
+        jobs[i].symbols = &symbols;
+        jobs[i].first = split;
+        split = (i == jobCount - 1) ? totalWords : (unsigned) ((double) totalWords * (i + 1) / jobCount);
+        while (split < module.codeWords && !symbols.isInstruction[split])
+            ++split;
+        if (split < jobs[i].first)
+            split = jobs[i].first;
+        jobs[i].last = split;
+    }
+
+    /* Disassemble (the first job runs on this thread) */
+    for (i = 1; i < jobCount; ++i)
+        if (pthread_create(&threads[i], NULL, disassembleRange, &jobs[i]) != 0) {
+            perror("disassembler");
+            exit(EXIT_FAILURE);
+        }
+    disassembleRange(&jobs[0]);
+    for (i = 1; i < jobCount; ++i)
+        pthread_join(threads[i], NULL);
+
+    /* Write the disassembly in order */
+    traceBegin("writeDisassembly", module.name);
+    fprintf(output, "; Disassembly Of %s.obj: %u Code Words, %u Data Words\n", module.name, module.codeWords,
+            module.dataWords);
+    if (symbols.illegalWords > 0)
+        fprintf(output, "; WARNING: %u Code Words Aren't Instructions, They Are Written As .data, So This Output "
+                        "Assembles Into A Different Image\n", symbols.illegalWords);
+    writeDeclarations(&module, output);
+    for (i = 0; i < jobCount; ++i) {
+        writeTextBuffer(&jobs[i].text, output);
+        freeTextBuffer(&jobs[i].text);
+    }
+
+    if (output != stdout)
+        fclose(output);
+    traceEnd("writeDisassembly");
+
+    /* The threads have ended, their spans are written together (before the module they name is freed) */
+    if (traceName != NULL && !saveTrace(traceName))
+        printf("ERROR: Couldn't Write The Trace File %s.\n", traceName);
+
+    free(jobs);
+    freeObjectModule(&module);
+
+    return EXIT_SUCCESS;
+}
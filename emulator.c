@@ -0,0 +1,121 @@
+/*****************************************
+* Emulator                               *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include <time.h>
+#include "dataTypes.h"
+#include "objectFile.h"
+#include "machine.h"
+
+/* Definitions */
+#define DEFAULT_BENCHMARK_INSTRUCTIONS 100000000UL
+
+/* Functions */
+/**
+ * This function prints the registers and the flags of #machine
+ * **/
+void printMachineState(Machine *machine) {
+    int i;
+
+    printf("PC: %u\tZ: %d\tInstructions Executed: %lu\n", machine->pc, machine->zeroFlag, machine->executed);
+    for (i = 0; i < NUMBER_OF_REGISTERS; ++i)
+        printf("r%d: %05o%c", i, machine->registers[i], (i == NUMBER_OF_REGISTERS - 1) ? '\n' : '\t');
+}
+
+/**
+ * This function runs the loaded program of #machine over and over (without I/O) until #instructions
+ * instructions were executed, and prints the throughput
+ * **/
+MachineState benchmarkMachine(Machine *machine, unsigned long instructions) {
+    unsigned long total = 0, runs = 0;
+    MachineState state = MACHINE_HALTED;
+    clock_t start;
+    double seconds;
+
+    machine->input = machine->output = NULL;
+
+    start = clock();
+    while (total < instructions) {
+        resetMachine(machine);
+        state = runMachine(machine, instructions - total);
+        total += machine->executed;
+        ++runs;
+
+        /* A program that stops with an error can't be measured */
+        if (state != MACHINE_HALTED && state != MACHINE_STEP_LIMIT)
+            break;
+    }
+    seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    printf("Executed %lu Instructions In %lu Runs In %.3f Seconds", total, runs, seconds);
+    if (seconds > 0)
+        printf(" (%.2f Million Instructions Per Second)", total / seconds / 1e6);
+    printf(".\n");
+
+    return state;
+}
+
+int main(int argc, char **argv) {
+    ObjectModule module;
+    Machine *machine;
+    MachineState state;
+    unsigned long maxSteps = 0, benchmarkInstructions = 0;
+    Boolean shouldDump = FALSE;
+
+    /* Read the options */
+    for (--argc, ++argv; argc > 1 && **argv == '-'; --argc, ++argv) {
+        if (strcmp(*argv, "--dump") == 0)
+            shouldDump = TRUE;
+        else if (strcmp(*argv, "--max-steps") == 0 && argc > 2)
+            maxSteps = strtoul(*++argv, NULL, 10), --argc;
+        else if (strcmp(*argv, "--bench") == 0 && argc > 2 && isdigit(**(argv + 1)))
+            benchmarkInstructions = strtoul(*++argv, NULL, 10), --argc;
+        else if (strcmp(*argv, "--bench") == 0)
+            benchmarkInstructions = DEFAULT_BENCHMARK_INSTRUCTIONS;
+        else {
+            printf("Unknown Option %s.\n", *argv);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc != 1) { /* If no program was given */
+        printf("Try The Command \"emulator [--dump] [--max-steps n] [--bench [n]] x\", Where x.obj Is A Linked "
+               "Object File.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (!loadObjectModule(*argv, &module))
+        exit(EXIT_FAILURE);
+
+    if ((machine = (Machine *) calloc(1, sizeof(Machine))) == NULL) {
+        perror("emulator");
+        exit(EXIT_FAILURE);
+    }
+
+    if (!loadMachine(machine, &module))
+        exit(EXIT_FAILURE);
+
+    if (benchmarkInstructions)
+        state = benchmarkMachine(machine, benchmarkInstructions);
+    else {
+        machine->input = stdin, machine->output = stdout;
+        state = runMachine(machine, maxSteps);
+        fflush(stdout);
+    }
+
+    if (state != MACHINE_HALTED && state != MACHINE_STEP_LIMIT)
+        printf("\nERROR: %s In Address %u.\n", getMachineStateDescription(state), machine->pc);
+    else if (state == MACHINE_STEP_LIMIT && !benchmarkInstructions)
+        printf("\nThe Step Limit Was Reached In Address %u.\n", machine->pc);
+
+    if (shouldDump)
+        printMachineState(machine);
+
+    freeObjectModule(&module);
+    free(machine);
+
+    return (state == MACHINE_HALTED || state == MACHINE_STEP_LIMIT) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
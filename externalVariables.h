@@ -12,6 +12,8 @@
 #define MEMORY_SIZE 4096
 
 int errorCode;
+int currentLineNum; /* The number of the line being analyzed */
+int errorColumn; /* The column of #errorCode, when it is known more precisely than the statement start */
 LabelList symbolTable;
 ExternEventList externEventTable;
 unsigned ic, codeWordsInstalled;
@@ -19,6 +21,28 @@ unsigned dc, dataWordsInstalled;
 Word dataImage[MEMORY_SIZE];
 Word machineCodeImage[MEMORY_SIZE];
 Boolean shouldOutputEntry, shouldOutputExtern;
+char *sourceName; /* The name of the source being assembled (files it refers to are relative to it) */
+
+/* Run options (set once by main, not reset between files) */
+FILE *diagnosticsFile;                        /* Where errors and progress messages are printed       */
+Boolean shouldStreamOutput;                   /* Write outputs to the streams below instead of files */
+Boolean shouldMarkModules;                    /* Precede the streamed outputs of a source by its name  */
+FILE *objectStream, *entryStream, *externStream;
+Boolean isQuietMode;                          /* Don't print progress banners                         */
+unsigned maxErrors;                           /* Stop a pass of a file after that many errors (0: all) */
+Boolean shouldPoolData;                       /* Share the words of data items with the same content  */
+Boolean shouldOptimize;                       /* Run the peephole optimizer before the first pass     */
+Boolean shouldStripUnused;                    /* Remove the code and data that are never referred to  */
+Boolean shouldOutputMap;                      /* Write a map of the symbols (.map)                     */
+Boolean isMapSortedBySize;                    /* Sort the map by size (largest first), else by address */
+Boolean shouldOutputXref;                     /* Write the sites referring to every symbol (.xref)     */
+Boolean shouldOutputDebug;                    /* Write the address to source line table (.dbg)        */
+Boolean isServerMode;                         /* Serve editors (LSP) on the standard streams, no files */
+Boolean isWatchMode;                          /* Assemble the files again whenever they change         */
+Boolean shouldBatchIO;                        /* Read the sources and write the outputs in batches     */
+Boolean shouldCollectStats;                   /* Count what the sources hold (instruction mix, ...)    */
+Boolean shouldReportMemory;                   /* Report the allocations and the peak memory at the end */
+Boolean isCheckMode;                          /* Only validate the sources, nothing is encoded or written */
 
 /* Type Definitions */
 
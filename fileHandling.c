@@ -5,12 +5,26 @@
 */
 
 /* Imports */
+#define _POSIX_C_SOURCE 200112L /* For fdopen, fsync, mmap */
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "dataTypes.h"
 #include "secondPass.h"
 #include "fileHandling.h"
 #include "externalVariables.h"
 #include "utils.h"
 #include "firstPass.h"
+#include "textBuffer.h"
+#include "crossReference.h"
+#include "debugTable.h"
+#include "batchIO.h"
+#include "trace.h"
+
+/* The outputs queued by updateOutputFile when the I/O is batched (their paths and contents), for flushOutputFiles */
+static FileWrite *queuedOutputs = NULL;
+static unsigned queuedCount = 0, queuedCapacity = 0;
 
 /* Functions */
 char *appendFileSuffix(char *fileName, FileType t) {
@@ -35,6 +49,15 @@ char *appendFileSuffix(char *fileName, FileType t) {
         case EXT: /* Extern file */
             strcat(buffer, ".ext");
             break;
+        case MAP: /* Map file */
+            strcat(buffer, ".map");
+            break;
+        case XREF: /* Cross reference file */
+            strcat(buffer, ".xref");
+            break;
+        case DBG: /* Debug file */
+            strcat(buffer, ".dbg");
+            break;
 
         case UNKNOWN_FILE_TYPE:
         default:
@@ -55,55 +78,475 @@ FILE *openFile(char *fileName, FileType t, char *mode) {
     return fp;
 }
 
-void writeEntryFile(FILE *file) {
+char *getSourceRelativePath(char *fileName) {
+    char *separator = sourceName ? strrchr(sourceName, PATH_SEPARATOR) : NULL;
+    size_t directoryLength = (*fileName == PATH_SEPARATOR || separator == NULL) ? 0 : separator - sourceName + 1;
+    char *path = (char *) malloc(directoryLength + strlen(fileName) + 1);
+
+    if (path == NULL) {
+        perror("getSourceRelativePath");
+        exit(EXIT_FAILURE);
+    }
+
+    /* The directory of the source (nothing if the path is absolute or the source is in the working directory) */
+    memcpy(path, sourceName, directoryLength);
+    strcpy(path + directoryLength, fileName);
+    return path;
+}
+
+unsigned char *mapBinaryFile(char *fileName, size_t *size) {
+    static unsigned char emptyContent[1]; /* An empty file can't be mapped, it has no content to point to */
+    struct stat status;
+    void *content;
+    int fd;
+
+    if ((fd = open(fileName, O_RDONLY)) < 0)
+        return NULL;
+
+    if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+
+    *size = (size_t) status.st_size;
+    if (*size == 0) {
+        close(fd);
+        return emptyContent;
+    }
+
+    /* The mapping stays valid after the descriptor is closed */
+    content = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return content == MAP_FAILED ? NULL : (unsigned char *) content;
+}
+
+void unmapBinaryFile(unsigned char *content, size_t size) {
+    if (size > 0)
+        munmap(content, size);
+}
+
+void writeEntryFile(TextBuffer *buffer) {
     LabelPointer node = symbolTable;
+    char line[MAX_OUTPUT_LINE_LENGTH];
 
     /* Go through the symbol table and print the ones marked as entry */
     for (; node; node = node->next)
-        if (node->isEntry)
-            fprintf(file, "%s\t%d\n", node->labelName, node->value);
+        if (node->isEntry) {
+            sprintf(line, "%s\t%d\n", node->labelName, node->value);
+            appendString(buffer, line);
+        }
 }
 
-void writeExternFile(FILE *file) {
+void writeExternFile(TextBuffer *buffer) {
     ExternEventPointer node = externEventTable;
+    char line[MAX_OUTPUT_LINE_LENGTH];
 
     /* Go through the extern events list and print it */
-    for (; node; node = node->next)
-        fprintf(file, "%s\t%d\n", node->labelName, node->address);
+    for (; node; node = node->next) {
+        sprintf(line, "%s\t%d\n", node->labelName, node->address);
+        appendString(buffer, line);
+    }
 }
 
-void writeObjectFile(FILE *file) {
+/**
+ * This function compares map entries by segment, then address, then name
+ * **/
+static int compareMapEntriesByAddress(const void *a, const void *b) {
+    LabelPointer first = ((MapEntry *) a)->label, second = ((MapEntry *) b)->label;
+
+    if (first->feature != second->feature)
+        return first->feature == CODE_FEATURE ? -1 : second->feature == CODE_FEATURE ? 1 :
+               first->feature == DATA_FEATURE ? -1 : 1;
+    if (first->value != second->value)
+        return first->value < second->value ? -1 : 1;
+    return strcmp(first->labelName, second->labelName);
+}
+
+/**
+ * This function compares map entries by size (largest first), then by address
+ * **/
+static int compareMapEntriesBySize(const void *a, const void *b) {
+    unsigned first = ((MapEntry *) a)->size, second = ((MapEntry *) b)->size;
+
+    if (first != second)
+        return first > second ? -1 : 1;
+    return compareMapEntriesByAddress(a, b);
+}
+
+void writeMapFile(TextBuffer *buffer) {
+    static char *segmentNames[] = {"data", "code", "extern"}; /* By LabelFeature */
+    unsigned i, j, count = 0, codeEnd = codeWordsInstalled + MEMORY_OFFSET, dataEnd = codeEnd + dataWordsInstalled;
+    char line[MAX_OUTPUT_LINE_LENGTH];
+    LabelPointer node;
+    MapEntry *entries;
+
+    for (node = symbolTable; node; node = node->next)
+        ++count;
+
+    if ((entries = (MapEntry *) malloc((count ? count : 1) * sizeof(MapEntry))) == NULL) {
+        perror("writeMapFile");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0, node = symbolTable; node; node = node->next, ++i)
+        entries[i].label = node;
+
+    /* In address order, a symbol ends where the next symbol (at a higher address) of its segment starts */
+    qsort(entries, count, sizeof(MapEntry), compareMapEntriesByAddress);
+    for (i = 0; i < count; ++i) {
+        node = entries[i].label;
+        for (j = i + 1; j < count && entries[j].label->feature == node->feature &&
+                        entries[j].label->value == node->value; ++j)
+            ;
+
+        if (node->feature == EXTERN_FEATURE)
+            entries[i].size = 0;
+        else if (j < count && entries[j].label->feature == node->feature)
+            entries[i].size = entries[j].label->value - node->value;
+        else
+            entries[i].size = (node->feature == CODE_FEATURE ? codeEnd : dataEnd) - node->value;
+    }
+
+    if (isMapSortedBySize)
+        qsort(entries, count, sizeof(MapEntry), compareMapEntriesBySize);
+
+    sprintf(line, "; code: %u words, data: %u words\n", codeWordsInstalled, dataWordsInstalled);
+    appendString(buffer, line);
+    appendString(buffer, "; address\tsize\trefs\tsegment\tentry\tsymbol\n");
+    for (i = 0; i < count; ++i) {
+        node = entries[i].label;
+        sprintf(line, "%04u\t%u\t%u\t%s\t%s\t%s\n", node->value, entries[i].size, node->references,
+                segmentNames[node->feature], node->isEntry ? "yes" : "no", node->labelName);
+        appendString(buffer, line);
+    }
+
+    free(entries);
+}
+
+void writeObjectFile(TextBuffer *buffer) {
     unsigned i, currentAddressNumber = 0;
+    char line[MAX_OUTPUT_LINE_LENGTH];
 
     /* Print the "header" of the object file */
-    fprintf(file, "%d\t\t%d\n", codeWordsInstalled, dataWordsInstalled);
+    sprintf(line, "%d\t\t%d\n", codeWordsInstalled, dataWordsInstalled);
+    appendString(buffer, line);
 
-    /* Print the machine code image */
-    for (i = 0; i < codeWordsInstalled; ++i, ++currentAddressNumber)
-        fprintf(file, "%04d\t%s\n", currentAddressNumber + MEMORY_OFFSET, toOctal(machineCodeImage[i]));
+    /* Print the machine code image (masking a word to 15 bits is its octal form, as toOctal makes it) */
+    for (i = 0; i < codeWordsInstalled; ++i, ++currentAddressNumber) {
+        sprintf(line, "%04d\t%05o\n", currentAddressNumber + MEMORY_OFFSET, machineCodeImage[i] & WORD_MASK);
+        appendString(buffer, line);
+    }
 
     /* Print the data image */
-    for (i = 0; i < dataWordsInstalled; ++i, ++currentAddressNumber)
-        fprintf(file, "%04d\t%s\n", currentAddressNumber + MEMORY_OFFSET, toOctal(dataImage[i]));
+    for (i = 0; i < dataWordsInstalled; ++i, ++currentAddressNumber) {
+        sprintf(line, "%04d\t%05o\n", currentAddressNumber + MEMORY_OFFSET, dataImage[i] & WORD_MASK);
+        appendString(buffer, line);
+    }
+}
+
+FILE *openOutputDescriptor(char *fdText) {
+    char *end;
+    long fd = strtol(fdText, &end, 10);
+
+    /* The descriptor must be a non-negative number */
+    if (end == fdText || *end != '\0' || fd < 0)
+        return NULL;
+
+    /* The standard output already has a stream */
+    if (fd == 1)
+        return stdout;
+
+    return fdopen((int) fd, "w");
+}
+
+/**
+ * This function appends the module marker of the source to #buffer, if several sources are streamed and #stream
+ * wasn't marked for the source yet (#marked holds the #markedCount streams that were, #stream is added to them)
+ * **/
+static void appendModuleMarker(TextBuffer *buffer, FILE *stream, FILE **marked, int *markedCount) {
+    int i;
+
+    if (!shouldMarkModules)
+        return;
+    for (i = 0; i < *markedCount; ++i)
+        if (marked[i] == stream)
+            return;
+    marked[(*markedCount)++] = stream;
+
+    appendString(buffer, MODULE_SECTION_MARKER " ");
+    appendString(buffer, sourceName ? sourceName : "");
+    appendChars(buffer, "\n", 1);
+}
+
+void writeOutputStreams() {
+    TextBuffer buffer;
+    FILE *marked[3]; /* The streams the source was marked on */
+    int markedCount = 0;
 
+    initTextBuffer(&buffer);
+
+    /* Write the object output */
+    appendModuleMarker(&buffer, objectStream, marked, &markedCount);
+    writeObjectFile(&buffer);
+    writeTextBuffer(&buffer, objectStream);
+
+    if (shouldOutputExtern) { /* If an extern output should be written, write it */
+        clearTextBuffer(&buffer);
+        appendModuleMarker(&buffer, externStream, marked, &markedCount);
+        if (externStream == objectStream)
+            appendString(&buffer, EXTERN_SECTION_MARKER "\n");
+        writeExternFile(&buffer);
+        writeTextBuffer(&buffer, externStream);
+    }
+    if (shouldOutputEntry) { /* If an entry output should be written, write it */
+        clearTextBuffer(&buffer);
+        appendModuleMarker(&buffer, entryStream, marked, &markedCount);
+        if (entryStream == objectStream)
+            appendString(&buffer, ENTRY_SECTION_MARKER "\n");
+        writeEntryFile(&buffer);
+        writeTextBuffer(&buffer, entryStream);
+    }
+    if (shouldOutputMap) { /* If a map should be written, it goes with the object output */
+        clearTextBuffer(&buffer);
+        appendString(&buffer, MAP_SECTION_MARKER "\n");
+        writeMapFile(&buffer);
+        writeTextBuffer(&buffer, objectStream);
+    }
+    if (shouldOutputXref) { /* If a cross reference should be written, it goes with the object output */
+        clearTextBuffer(&buffer);
+        appendString(&buffer, XREF_SECTION_MARKER "\n");
+        writeXrefFile(&buffer);
+        writeTextBuffer(&buffer, objectStream);
+    }
+
+    /* The consumer on the other side may be waiting for the output */
+    fflush(objectStream);
+    fflush(externStream);
+    fflush(entryStream);
+    freeTextBuffer(&buffer);
+}
+
+/**
+ * This function returns #outputName with the temporary file suffix, in a new string
+ * **/
+static char *getTempName(char *outputName) {
+    char *tempName = (char *) malloc(strlen(outputName) + strlen(TEMP_FILE_SUFFIX) + 1);
+
+    if (tempName == NULL) {
+        perror("getTempName");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(tempName, outputName);
+    strcat(tempName, TEMP_FILE_SUFFIX);
+    return tempName;
+}
+
+/**
+ * This function queues #content to be written to #outputName (which is kept) by flushOutputFiles
+ * **/
+static void queueOutputFile(char *outputName, TextBuffer *content) {
+    FileWrite *tmp;
+
+    /* Grow the queue (by doubling) if needed */
+    if (queuedCount == queuedCapacity) {
+        queuedCapacity = queuedCapacity ? queuedCapacity * 2 : BATCH_FILE_COUNT;
+        if ((tmp = (FileWrite *) realloc(queuedOutputs, queuedCapacity * sizeof(FileWrite))) == NULL) {
+            perror("queueOutputFile");
+            exit(EXIT_FAILURE);
+        }
+        queuedOutputs = tmp;
+    }
+
+    /* The buffer of the caller is reused for the next output, the content is copied */
+    queuedOutputs[queuedCount].path = outputName;
+    initTextBuffer(&queuedOutputs[queuedCount].content);
+    appendChars(&queuedOutputs[queuedCount].content, content->data, content->length);
+    ++queuedCount;
+}
+
+Boolean isFileContentEqual(char *fileName, TextBuffer *content) {
+    FILE *file;
+    char chunk[COMPARE_CHUNK_SIZE];
+    size_t offset = 0, count;
+    Boolean isEqual;
+
+    /* A file that can't be read is not equal to anything */
+    if ((file = fopen(fileName, "rb")) == NULL)
+        return FALSE;
+
+    /* Compare the sizes first, most changes change the size */
+    if (fseek(file, 0L, SEEK_END) != 0 || ftell(file) != (long) content->length) {
+        fclose(file);
+        return FALSE;
+    }
+    rewind(file);
+
+    /* Compare the content chunk by chunk */
+    isEqual = TRUE;
+    while (isEqual && (count = fread(chunk, 1, COMPARE_CHUNK_SIZE, file)) > 0) {
+        isEqual = BOOLEANIZE(offset + count <= content->length &&
+                             memcmp(chunk, content->data + offset, count) == 0);
+        offset += count;
+    }
+
+    fclose(file);
+    return BOOLEANIZE(isEqual && offset == content->length);
+}
+
+OutputStatus updateOutputFile(char *fileName, FileType t, TextBuffer *content) {
+    char *outputName = appendFileSuffix(fileName, t), *tempName;
+    OutputStatus status = OUTPUT_WRITTEN;
+    FILE *file;
+
+    if (outputName == NULL)
+        return OUTPUT_FAILED;
+
+    /* A batched output is compared and written with the rest of its batch */
+    if (shouldBatchIO) {
+        queueOutputFile(outputName, content);
+        return OUTPUT_QUEUED;
+    }
+
+    /* If the file already holds the content, leave it (and its modification time) alone */
+    if (isFileContentEqual(outputName, content)) {
+        free(outputName);
+        return OUTPUT_UNCHANGED;
+    }
+
+    /* Write a temporary file next to the output, and rename it over the output once it is complete */
+    tempName = getTempName(outputName);
+    if ((file = fopen(tempName, "wb")) == NULL)
+        status = OUTPUT_FAILED;
+    else {
+        if (!writeTextBuffer(content, file) || fflush(file) != 0 || fsync(fileno(file)) != 0)
+            status = OUTPUT_FAILED;
+        if (fclose(file) != 0)
+            status = OUTPUT_FAILED;
+        if (status == OUTPUT_FAILED || rename(tempName, outputName) != 0) {
+            remove(tempName);
+            status = OUTPUT_FAILED;
+        }
+    }
+
+    if (status == OUTPUT_FAILED)
+        fprintf(diagnosticsFile, "\nERROR: Couldn't Write The Output File %s.\n", outputName);
+
+    free(tempName);
+    free(outputName);
+    return status;
+}
+
+void flushOutputFiles() {
+    FileRead *existing;
+    FileWrite *changed;
+    unsigned i, changedCount = 0, *changedOutput;
+
+    if (queuedCount == 0)
+        return;
+    if ((existing = (FileRead *) malloc(queuedCount * sizeof(FileRead))) == NULL ||
+        (changed = (FileWrite *) malloc(queuedCount * sizeof(FileWrite))) == NULL ||
+        (changedOutput = (unsigned *) malloc(queuedCount * sizeof(unsigned))) == NULL) {
+        perror("flushOutputFiles");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Read what the outputs hold now (the ones that don't exist yet just fail to be read) */
+    for (i = 0; i < queuedCount; ++i) {
+        existing[i].path = queuedOutputs[i].path;
+        initTextBuffer(&existing[i].content);
+    }
+    traceBegin("readFileBatch", NULL);
+    readFileBatch(existing, queuedCount);
+    traceEnd("readFileBatch");
+
+    /* Write the ones whose content changed to temporary files (the contents are shared with the queue) */
+    for (i = 0; i < queuedCount; ++i) {
+        if (!(existing[i].isRead && existing[i].content.length == queuedOutputs[i].content.length &&
+              memcmp(existing[i].content.data, queuedOutputs[i].content.data, existing[i].content.length) == 0)) {
+            changedOutput[changedCount] = i;
+            changed[changedCount].path = getTempName(queuedOutputs[i].path);
+            changed[changedCount++].content = queuedOutputs[i].content;
+        }
+        freeTextBuffer(&existing[i].content);
+    }
+    traceBegin("writeFileBatch", NULL);
+    writeFileBatch(changed, changedCount);
+    traceEnd("writeFileBatch");
+
+    /* Rename the complete ones over the outputs */
+    for (i = 0; i < changedCount; ++i) {
+        if (!changed[i].isWritten || rename(changed[i].path, queuedOutputs[changedOutput[i]].path) != 0) {
+            remove(changed[i].path);
+            fprintf(diagnosticsFile, "\nERROR: Couldn't Write The Output File %s.\n",
+                    queuedOutputs[changedOutput[i]].path);
+        }
+        free(changed[i].path);
+    }
+
+    /* Empty the queue (its memory is kept for the next batch) */
+    for (i = 0; i < queuedCount; ++i) {
+        free(queuedOutputs[i].path);
+        freeTextBuffer(&queuedOutputs[i].content);
+    }
+    queuedCount = 0;
+
+    free(changedOutput);
+    free(changed);
+    free(existing);
 }
 
 void createOutputFiles(char *filename) {
-    FILE *objFile, *entFile, *extFile;
+    TextBuffer buffer;
+
+    /* If the outputs are streamed, no file is created */
+    if (shouldStreamOutput) {
+        writeOutputStreams();
+        return;
+    }
+
+    /* Every output is made in memory, and the file is replaced only if its content changed */
+    initTextBuffer(&buffer);
 
     /* Create the object file */
-    objFile = openFile(filename, OBJ, "w");
-    writeObjectFile(objFile);
-    fclose(objFile);
+    traceBegin("writeObjectFile", filename);
+    writeObjectFile(&buffer);
+    updateOutputFile(filename, OBJ, &buffer);
+    traceEnd("writeObjectFile");
 
     if (shouldOutputExtern) { /* If an ext file should be created, make it */
-        extFile = openFile(filename, EXT, "w");
-        writeExternFile(extFile);
-        fclose(extFile);
+        traceBegin("writeExternFile", filename);
+        clearTextBuffer(&buffer);
+        writeExternFile(&buffer);
+        updateOutputFile(filename, EXT, &buffer);
+        traceEnd("writeExternFile");
     }
     if (shouldOutputEntry) { /* If an ent file should be created, make it */
-        entFile = openFile(filename, ENT, "w");
-        writeEntryFile(entFile);
-        fclose(entFile);
+        traceBegin("writeEntryFile", filename);
+        clearTextBuffer(&buffer);
+        writeEntryFile(&buffer);
+        updateOutputFile(filename, ENT, &buffer);
+        traceEnd("writeEntryFile");
+    }
+    if (shouldOutputMap) { /* If a map file should be created, make it */
+        traceBegin("writeMapFile", filename);
+        clearTextBuffer(&buffer);
+        writeMapFile(&buffer);
+        updateOutputFile(filename, MAP, &buffer);
+        traceEnd("writeMapFile");
     }
+    if (shouldOutputXref) { /* If a cross reference file should be created, make it */
+        traceBegin("writeXrefFile", filename);
+        clearTextBuffer(&buffer);
+        writeXrefFile(&buffer);
+        updateOutputFile(filename, XREF, &buffer);
+        traceEnd("writeXrefFile");
+    }
+    if (shouldOutputDebug) { /* If a debug file should be created, make it */
+        traceBegin("writeDebugFile", filename);
+        clearTextBuffer(&buffer);
+        writeDebugFile(&buffer);
+        updateOutputFile(filename, DBG, &buffer);
+        traceEnd("writeDebugFile");
+    }
+
+    freeTextBuffer(&buffer);
 }
@@ -8,9 +8,36 @@
 #define FILE_HANDLING_H
 
 /*Imports */
+#include "textBuffer.h"
 
 /* Definitions */
 #define SUFFIX_LENGTH 8
+
+/*
+ * When the outputs are streamed and the entry / extern outputs share the stream of the object output,
+ * each of them is preceded by a line holding its marker. When several sources are streamed, the outputs of each
+ * one are preceded on every stream by a line holding the module marker and the name of the source
+ */
+#define MODULE_SECTION_MARKER ".module"
+#define ENTRY_SECTION_MARKER ".ent"
+#define EXTERN_SECTION_MARKER ".ext"
+#define MAP_SECTION_MARKER ".map"
+#define XREF_SECTION_MARKER ".xref"
+
+#define MAX_OUTPUT_LINE_LENGTH 128
+#define COMPARE_CHUNK_SIZE 4096
+#define TEMP_FILE_SUFFIX ".tmp"
+#define PATH_SEPARATOR '/'
+
+/* Type Definitions */
+/* What happened to an output file */
+typedef enum {OUTPUT_WRITTEN, OUTPUT_UNCHANGED, OUTPUT_FAILED, OUTPUT_QUEUED} OutputStatus;
+
+/* A symbol in the map file */
+typedef struct {
+    LabelPointer label;  /* The symbol                                                              */
+    unsigned size;       /* The words from its address to the next symbol (or the end) of its segment */
+} MapEntry;
 /* Function Prototypes */
 /**
  * This function opens a file of type #t with mode #mode
@@ -23,24 +50,75 @@ FILE *openFile(char *fileName, FileType t, char *mode);
 char *appendFileSuffix(char *fileName, FileType t);
 
 /**
- * This function create the output files
+ * This function create the output files (only the ones whose content changed are written)
  * **/
 void createOutputFiles(char *filename);
 
+/**
+ * This function returns whether if the file #fileName exists and holds exactly #content
+ * **/
+Boolean isFileContentEqual(char *fileName, TextBuffer *content);
+
+/**
+ * This function replaces the output file of type #t of #fileName with #content, through a temporary file
+ * and a rename, unless the file already holds #content (when the I/O is batched, it is only queued for
+ * flushOutputFiles)
+ * **/
+OutputStatus updateOutputFile(char *fileName, FileType t, TextBuffer *content);
+
+/**
+ * This function updates the queued output files like updateOutputFile does, with all the reads of them made
+ * together, then all the writes
+ * **/
+void flushOutputFiles();
+
+
+/**
+ * This function writes the outputs to #objectStream, #entryStream and #externStream (instead of files)
+ * **/
+void writeOutputStreams();
+
+/**
+ * This function opens a stream for writing to the file descriptor in #fdText ("1", "3", ...)
+ * @return The stream, or NULL if #fdText is not a number or the descriptor is not open for writing
+ * **/
+FILE *openOutputDescriptor(char *fdText);
+
+/**
+ * This function returns the path of #fileName, a file referred to by the source #sourceName (a relative
+ * #fileName is relative to the directory of the source), in a new string
+ * **/
+char *getSourceRelativePath(char *fileName);
+
+/**
+ * This function maps the file #fileName to memory (read only)
+ * @return The content of the file (its size is put in #size), or NULL if the file can't be mapped
+ * **/
+unsigned char *mapBinaryFile(char *fileName, size_t *size);
+
+/**
+ * This function unmaps #content, the #size bytes returned by mapBinaryFile
+ * **/
+void unmapBinaryFile(unsigned char *content, size_t size);
+
+/**
+ * This function writes the entry file into #buffer
+ * **/
+void writeEntryFile(TextBuffer *buffer);
 
 /**
- * This function writes the entry file
+ * This function writes the extern file into #buffer
  * **/
-void writeEntryFile(FILE *file);
+void writeExternFile(TextBuffer *buffer);
 
 /**
- * This function writes the extern file
+ * This function writes the map file (every symbol with its address, size, segment and references) into #buffer
  * **/
-void writeExternFile(FILE *file);
+void writeMapFile(TextBuffer *buffer);
 
 /**
- * This function writes the object file
+ * This function writes the object file into #buffer
  * **/
-void writeObjectFile(FILE *file);
+void writeObjectFile(TextBuffer *buffer);
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -11,11 +11,21 @@
 #include "externalVariables.h"
 #include "utils.h"
 #include "mainHeader.h"
+#include "sourceFile.h"
+#include "diagnostics.h"
+#include "fileHandling.h"
+#include "dataPool.h"
+#include "debugTable.h"
+#include "workloadStats.h"
+#include "includeCache.h"
+#include "decoder.h"
+#include "trace.h"
 
 /* Functions */
 int installStringFromLine(char *line) {
     char *args; /* Will hold the string */
     char *noQuotes; /* Will hold the string without the quotes */
+    Word words[MAX_LINE_LENGTH]; /* Will hold the characters of the string */
     int count = 0;
 
     args = strip(strstr(line, ".string")); /* go to the directive */
@@ -25,50 +35,166 @@ int installStringFromLine(char *line) {
     /* If no operand was given */
     if (isEmpty(args)) {
         errorCode = INVALID_OPERANDS_STRING_DIR;
+        errorColumn = getInstructionColumn(line);
         return -1;
     }
 
     if (isString(args)) { /* if the argument is a valid string */
         noQuotes = getString(args);
         while (*noQuotes) {
-            installWordInData((unsigned int) *noQuotes); /* install each character */
+            words[count] = (unsigned int) *noQuotes; /* convert each character */
             ++noQuotes;
             ++count;
         }
-        installWordInData((unsigned int ) '\0'); /* install the ending '\0' */
+        words[count] = (unsigned int) '\0'; /* and the ending '\0' */
         ++count;
+
+        /* install them all at once */
+        if (!installWordsInData(words, (unsigned) count))
+            return -1;
     } else { /* if the argument is not valid */
         errorCode = STRING_OPERAND_INVALID;
+        errorColumn = (int) (args - line) + 1;
         return -1;
     }
     return count;
 }
 
 int installNumbersFromLine(char *line) {
-    char *args; /* Will hold the arguments */
-    int count = 0;
+    char *args, *next; /* Will hold the arguments, and the rest of them after each one */
+    Word words[MAX_LINE_LENGTH]; /* Will hold the numbers (a line can't have more of them) */
+    int count = 0, number;
 
-    char *tempNumber, delim[] = ", \t"; /* for strtok */
     args = strip(strstr(line, ".data")); /* go to the directive */
     args += strlen(".data"); /* skip it */
     args = strip(args); /* skip spaces */
 
-    /* Go through the arguments */
-    tempNumber = strtok(args, delim);
-    while (BOOLEANIZE(tempNumber)) { /* While strtok is not NULL */
-        if (isNumber(tempNumber)) { /* If its a valid number */
-            installWordInData(getNumber(tempNumber)); /* install it */
-            ++count;
-        }
-        else { /* if the argument is invalid */
+    /* Go through the arguments, each one is validated and converted in the same scan */
+    while (*args) {
+        /* Skip the delimiters */
+        while (*args == ',' || *args == ' ' || *args == '\t')
+            ++args;
+
+        if (*args == '\0')
+            break;
+
+        if ((next = readNumber(args, &number)) == NULL) { /* if the argument is invalid */
             errorCode = DATA_OPERAND_INVALID;
+            errorColumn = (int) (args - line) + 1;
             return -1;
         }
-        tempNumber = strtok(NULL, delim); /* get the next argument */
+        words[count++] = (Word) number;
+        args = next;
     }
+
+    /* install them all at once */
+    if (count > 0 && !installWordsInData(words, (unsigned) count))
+        return -1;
+
     return count;
 }
 
+void installBinaryFromLine(char *line) {
+    char *args, *next, *fileName, *path; /* Will hold the arguments, the quoted file name and its path */
+    long operands[MAX_INCBIN_OPERANDS] = {0, -1, 1}; /* The offset, length and width (-1: up to the end of the file) */
+    int operandCount = 0, number, i, nameColumn, numbersColumn = 0; /* Where the file name and the numbers start */
+    unsigned char *content;
+    size_t size, byte;
+    Word *words = NULL, value;
+    unsigned count, w;
+
+    args = strip(strstr(line, ".incbin")); /* go to the directive */
+    args += strlen(".incbin"); /* skip it */
+    args = strip(args); /* skip spaces */
+
+    /* The first operand is the quoted file name */
+    nameColumn = (int) (args - line) + 1;
+    if (*args != '\"' || (fileName = strchr(args + 1, '\"')) == NULL || fileName == args + 1) {
+        errorCode = INCBIN_OPERANDS_INVALID;
+        errorColumn = nameColumn;
+        return;
+    }
+    *fileName = '\0';
+    fileName = args + 1;
+    args += strlen(fileName) + 2;
+
+    /* Read the numbers after it, each one preceded by a comma */
+    while (!isEmpty(args)) {
+        args = strip(args);
+        if (*args != ',' || operandCount == MAX_INCBIN_OPERANDS) {
+            errorCode = INCBIN_OPERANDS_INVALID;
+            errorColumn = (int) (args - line) + 1;
+            return;
+        }
+        args = strip(args + 1);
+        if ((next = readNumber(args, &number)) == NULL || number < 0) {
+            errorCode = INCBIN_OPERANDS_INVALID;
+            errorColumn = (int) (args - line) + 1;
+            return;
+        }
+        if (operandCount == 0)
+            numbersColumn = (int) (args - line) + 1;
+        operands[operandCount++] = number;
+        args = next;
+    }
+
+    /* Map the file, its path is relative to the source */
+    path = getSourceRelativePath(fileName);
+    content = mapBinaryFile(path, &size);
+    free(path);
+    if (content == NULL) {
+        errorCode = INCBIN_FILE_INVALID;
+        errorColumn = nameColumn;
+        return;
+    }
+
+    /* By default, take the file from the offset to its end */
+    if (operands[1] < 0)
+        operands[1] = operands[0] <= (long) size ? (long) size - operands[0] : 0;
+
+    /* The bytes must be inside the file, and make whole words */
+    if (operands[2] < 1 || operands[2] > MAX_INCBIN_WIDTH || operands[0] + operands[1] > (long) size ||
+        operands[1] % operands[2] != 0) {
+        unmapBinaryFile(content, size);
+        errorCode = INCBIN_OPERANDS_INVALID;
+        errorColumn = numbersColumn;
+        return;
+    }
+
+    /* The words must fit in the data image (before any room is taken for them) */
+    if (operands[1] / operands[2] > (long) (MEMORY_SIZE - dc)) {
+        unmapBinaryFile(content, size);
+        errorCode = DATA_IMAGE_OVERFLOW;
+        return;
+    }
+
+    /* Make a word of every #width bytes (the first byte is the lowest), a check only validates them */
+    count = (unsigned) (operands[1] / operands[2]);
+    if (!isCheckMode && (words = (Word *) malloc((count ? count : 1) * sizeof(Word))) == NULL) {
+        perror("installBinaryFromLine");
+        exit(EXIT_FAILURE);
+    }
+    for (w = 0, byte = (size_t) operands[0]; w < count; ++w) {
+        value = 0;
+        for (i = 0; i < operands[2]; ++i, ++byte)
+            value |= (Word) content[byte] << (i * BITS_IN_BYTE);
+        if (value > WORD_MASK) { /* The highest bit of two bytes doesn't fit in a word */
+            free(words);
+            unmapBinaryFile(content, size);
+            errorCode = INCBIN_WORD_TOO_WIDE;
+            errorColumn = numbersColumn;
+            return;
+        }
+        if (words != NULL)
+            words[w] = value;
+    }
+
+    /* install them all at once */
+    installWordsInData(words, count);
+    free(words);
+    unmapBinaryFile(content, size);
+}
+
 void installExternLabelFromLine(char *line) {
     char *labelArg; /* Will hold the name of the label */
     LabelPointer retVal;
@@ -83,12 +209,14 @@ void installExternLabelFromLine(char *line) {
     /* if the operand is an illegal label */
     if (!isLegalLabelNoColon(labelArg)) {
         errorCode = EXTERN_OPERAND_INVALID;
+        errorColumn = (int) (labelArg - line) + 1;
         return;
     }
 
     if ((retVal = searchByName(&symbolTable, labelArg)) != NULL) { /* If the label already exists */
         if (retVal->feature != EXTERN_FEATURE) { /* if the label exists non-externally */
             errorCode = EXTERN_OPERAND_ALREADY_EXIST;
+            errorColumn = (int) (labelArg - line) + 1;
         }
         else /* if it was already defined as extern */
             return;
@@ -228,6 +356,11 @@ void analyzeLineFirstPass(char *line) {
     Boolean hasLabel = FALSE; /* hold if a label exists */
     AddressingMode srcMode, destMode; /* addressing modes */
     char *label, *firstOperand = NULL, *secondOperand = NULL; /* label, operands */
+    int words; /* the data words a directive put */
+    unsigned dataStart = dc; /* where the data words of the line start */
+
+    if (shouldCollectStats) /* Every line is counted, even the ones that hold nothing */
+        countLine(line);
 
     /* If the line is ignorable */
     if (isIgnorable(line))
@@ -236,6 +369,7 @@ void analyzeLineFirstPass(char *line) {
     /* If the line has two consecutive commas */
     if (hasTwoCommas(line)) {
         errorCode = INVALID_COMMAS;
+        errorColumn = (int) (strstr(line, ",,") - line) + 1;
         return;
     }
 
@@ -249,43 +383,72 @@ void analyzeLineFirstPass(char *line) {
 
     /* if the label needs to be installed in the symbol table */
     dir = getDirective(line);
-    if ((dir == DATA_DIR || dir == STRING_DIR) && hasLabel) {
-        if (searchByName(&symbolTable, label) == NULL)
+    if ((dir == DATA_DIR || dir == STRING_DIR || dir == INCBIN_DIR) && hasLabel) {
+        if (searchByName(&symbolTable, label) == NULL) {
             insertLabel(&symbolTable, dc, label, DATA_FEATURE, FALSE);
-        else
+            if (shouldPoolData) /* The label starts a new data item */
+                beginPooledItem(searchByName(&symbolTable, label));
+            if (shouldCollectStats)
+                countLabelDefinition();
+        } else
             errorCode = LABEL_NAME_ALREADY_EXIST;
     }
 
     /* Handle different directives, entry will be taken care of in the second pass */
     if (dir == DATA_DIR) { /* If a .data directive was found */
-        if (installNumbersFromLine(line) == 0)
+        if ((words = installNumbersFromLine(line)) == 0) {
             errorCode = INVALID_OPERANDS_DATA_DIR;
+            errorColumn = getInstructionColumn(line);
+        }
+        if (shouldCollectStats && words > 0)
+            countDirective(dir, (unsigned) words);
         return;
     }
     else if (dir == STRING_DIR) { /* If a .string directive was found */
-        installStringFromLine(line);
+        words = installStringFromLine(line);
+        if (shouldCollectStats && words > 0)
+            countDirective(dir, (unsigned) words);
+        return;
+    }
+    else if (dir == INCBIN_DIR) { /* If an .incbin directive was found */
+        installBinaryFromLine(line);
+        if (shouldCollectStats && errorCode == NO_ERROR)
+            countDirective(dir, dc - dataStart);
         return;
     }
     else if (dir == EXTERN_DIR) { /* If an .extern directive was found */
         installExternLabelFromLine(line);
+        if (shouldCollectStats && errorCode == NO_ERROR)
+            countDirective(dir, 0);
+        return;
+    }
+    else if (dir == ENTRY_DIR) { /* If a .entry directive was found */
+        if (shouldCollectStats)
+            countDirective(dir, 0);
         return;
     }
-    else if (dir == ENTRY_DIR)  /* If a .entry directive was found */
+
+    else if (dir == INCLUDE_DIR) /* The lines it includes were put after it by the line reader (includeCache.h) */
         return;
 
     else if (dir == UNKNOWN_DIRECTIVE && startWithDot(line)) { /* If a non-existing directive appears */
         errorCode = INVALID_DIR_NAME;
+        errorColumn = getInstructionColumn(line);
         return;
     }
 
 
     /* If the line dose'nt have a directive, it's an instruction line */
     /* Add the label as code */
-    if (hasLabel)
+    if (hasLabel) {
         insertLabel(&symbolTable, ic + MEMORY_OFFSET, label, CODE_FEATURE, FALSE);
+        if (shouldCollectStats)
+            countLabelDefinition();
+    }
 
     if ((inst = getInstruction(line)) == UNKNOWN_INST) {
         errorCode = INVALID_CMD_NAME;
+        errorColumn = getInstructionColumn(line);
         return;
     }
 
@@ -302,6 +465,9 @@ void analyzeLineFirstPass(char *line) {
     /* if the umber of actual operands does not match, alert */
     if (numberOfActualOps != getNumberOfOperands(inst)) {
         errorCode = INVALID_OPERAND_NUMBER_CMD;
+        /* At the first extra operand, or where the first missing one should be */
+        errorColumn = getOperandColumn(line, numberOfActualOps < getNumberOfOperands(inst) ?
+                                             numberOfActualOps : getNumberOfOperands(inst));
         return;
     }
 
@@ -318,63 +484,164 @@ void analyzeLineFirstPass(char *line) {
     /* If the addressing modes dose'nt match */
     if (!hasCorrectAddressingModes(inst, srcMode, destMode)) {
         errorCode = INVALID_ADDR_MODES;
+        /* At the source operand if it is the wrong one (any instruction with operands takes a direct dest) */
+        errorColumn = getOperandColumn(line, numberOfActualOps == 2 &&
+                                             !hasCorrectAddressingModes(inst, srcMode, DIRECT) ? 0 : numberOfActualOps - 1);
         return;
     }
 
     /* Get the width of the instruction */
     L = getOperandInstructionWidth(srcMode, destMode);
 
-    /* Install the first word */
-    instructionWord = makeFirstWord(inst, srcMode, destMode);
-    installWordInCode(instructionWord);
+    /* Install the first word (a check only counts it) */
+    if (isCheckMode)
+        ++ic;
+    else {
+        instructionWord = makeFirstWord(inst, srcMode, destMode);
+        installWordInCode(instructionWord);
+    }
+
+    if (shouldCollectStats) /* The instruction mix of the run */
+        countInstruction(inst, srcMode, destMode);
 
     /* Increment IC by the count of the words needed by the operands */
     ic += L;
 }
 
-void firstPass(char *fileName, FILE *fp) {
-    int lineNum = 1;
+void analyzeIncludedLine(IncludedLine *included, char *line) {
+    LabelPointer label;
+    DecodedWord decoded;
+
+    if (shouldCollectStats)
+        countLine(line);
+
+    switch (included->kind) {
+        case INCLUDE_STATEMENT: /* The outcome of the include */
+            errorCode = included->err;
+            if (shouldCollectStats && errorCode == NO_ERROR)
+                countDirective(INCLUDE_DIR, 0);
+            break;
+
+        case MACRO_STATEMENT: /* A macro definition that has an error */
+            errorCode = included->err;
+            if (errorCode == MACRO_NAME_INVALID || errorCode == MACRO_NAME_ALREADY_EXIST) /* At the name */
+                errorColumn = getOperandColumn(line, 0);
+            break;
+
+        case INSTRUCTION_STATEMENT: /* Its first word, then the room for its operand words */
+            decodeFirstWord(included->words[0], &decoded);
+            if (isCheckMode)
+                ++ic;
+            else
+                installWordInCode(included->words[0]);
+            if (shouldCollectStats)
+                countInstruction(decoded.inst, decoded.srcMode, decoded.destMode);
+            ic += decoded.width - 1;
+            break;
+
+        case EXTERN_STATEMENT: /* Like installExternLabelFromLine */
+            if ((label = searchByName(&symbolTable, included->label)) == NULL)
+                insertLabel(&symbolTable, (unsigned int) 0, included->label, EXTERN_FEATURE, FALSE);
+            else if (label->feature != EXTERN_FEATURE)
+                errorCode = EXTERN_OPERAND_ALREADY_EXIST;
+            shouldOutputExtern = TRUE;
+            if (shouldCollectStats && errorCode == NO_ERROR)
+                countDirective(EXTERN_DIR, 0);
+            break;
+
+        case DATA_STATEMENT: /* Its label at the current dc, then its words */
+            if (included->label[0] != '\0') {
+                if (searchByName(&symbolTable, included->label) == NULL) {
+                    insertLabel(&symbolTable, dc, included->label, DATA_FEATURE, FALSE);
+                    if (shouldPoolData)
+                        beginPooledItem(searchByName(&symbolTable, included->label));
+                    if (shouldCollectStats)
+                        countLabelDefinition();
+                } else
+                    errorCode = LABEL_NAME_ALREADY_EXIST;
+            }
+            if (installWordsInData(included->words, included->wordCount) && shouldCollectStats)
+                countDirective(included->dir, included->wordCount);
+            break;
+
+        case BLANK_STATEMENT:
+        case PLAIN_STATEMENT:
+        default:
+            break;
+    }
+}
+
+void firstPass(SourceFile *source) {
+    unsigned i;
     LabelPointer label;
     Boolean hadError = FALSE;
     char line[MAX_LINE_LENGTH];
 
-    printf("\n******************************************\n");
-    printf("STARTED FIRST PASS ON FILE %s.\n", fileName);
-    printf("******************************************\n");
+    reportText("\n******************************************\n");
+    reportText("STARTED FIRST PASS ON FILE ");
+    reportText(source->name);
+    reportText(".\n******************************************\n");
     /* Set ic, dc to 0 */
     ic = 0, dc = 0;
-
-    /* Read fp line by line */
-    while (fgets(line, MAX_LINE_LENGTH, fp)) {
+    sourceName = source->name;
+    enterMemoryPhase(FIRST_PASS_PHASE);
+    traceBegin("firstPass", source->name);
+    if (shouldCollectStats)
+        countSourceFile();
+
+    /* Go through the source line by line (on a copy, the analysis changes the line) */
+    for (i = 0; i < source->count && !reachedErrorLimit(); ++i) {
+        strcpy(line, source->lines[i].text);
+        currentLineNum = source->lines[i].lineNum;
         errorCode = NO_ERROR;
-        analyzeLineFirstPass(line);
+        errorColumn = 0;
+        if (shouldOutputDebug) /* The words installed by the line are attributed to it */
+            beginDebugLine(currentLineNum, getStatementColumn(source->lines[i].text));
+        if (source->lines[i].included != NULL && source->lines[i].included->kind != PLAIN_STATEMENT)
+            analyzeIncludedLine(source->lines[i].included, line); /* It was analyzed once, where it's written */
+        else
+            analyzeLineFirstPass(line);
 
         if (errorCode != NO_ERROR) { /* If an error was encountered */
-            alertLineError(lineNum, errorCode);
+            alertLineError(source->lines[i].lineNum,
+                           errorColumn ? errorColumn : getStatementColumn(source->lines[i].text), errorCode);
             hadError = TRUE;
         }
-        ++lineNum;
     }
 
+    endDebugLines();
+
     /* If an error was encountered in the first pass, there's no need to continue to the second pass */
      if (hadError) {
-        printf("\n**********************************************************************\n");
-        printf("ERRORS WERE ENCOUNTERED DURING THE FIRST PASS, SECOND PASS "
+        if (reachedErrorLimit() && i < source->count)
+            reportText("\nTHE MAXIMAL NUMBER OF ERRORS WAS REACHED, THE REST OF THE FILE WASN'T CHECKED\n");
+        reportText("\n**********************************************************************\n");
+        reportText("ERRORS WERE ENCOUNTERED DURING THE FIRST PASS, SECOND PASS "
                "WON'T BEGIN\n");
-        printf("**********************************************************************\n");
+        reportText("**********************************************************************\n");
+        traceEnd("firstPass");
         return;
     }
 
+    /* The last data item is complete */
+    if (shouldPoolData) {
+        endPooledItem();
+        sprintf(line, "\nDATA POOLING SAVED %u WORDS\n", getPooledWordsSaved());
+        reportText(line);
+    }
+
     /* Add ic + 100 to all data labels */
+    traceBegin("relocateSymbols", source->name);
     for (label = symbolTable; label; label = label->next)
         if (label->feature == DATA_FEATURE)
             label->value += (ic + MEMORY_OFFSET);
+    traceEnd("relocateSymbols");
 
-    printf("\n******************************\n");
-    printf("FIRST PASS ENDED SUCCESSFULLY \n"  );
-    printf("******************************\n"  );
+    reportText("\n******************************\n");
+    reportText("FIRST PASS ENDED SUCCESSFULLY \n"  );
+    reportText("******************************\n"  );
+    traceEnd("firstPass");
 
-    /* Begin the second pass */
-    rewind(fp); /* Return the file cursor to position 0 */
-    secondPass(fileName, fp);
+    /* Begin the second pass (the source is held in memory, there's nothing to rewind) */
+    secondPass(source);
 }
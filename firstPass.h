@@ -9,6 +9,7 @@
 
 /*Imports */
 #include <stdio.h>
+#include "sourceFile.h"
 
 /* Definitions */
 #define BITS_IN_OPCODE (4)
@@ -19,6 +20,9 @@
 
 #define MAX_OPERAND_LENGTH (32)
 #define MEMORY_OFFSET (100)
+#define MAX_INCBIN_OPERANDS (3)  /* The offset, length and width that may follow the file name of .incbin */
+#define MAX_INCBIN_WIDTH (2)     /* The most bytes of the file that make a word (a word has 15 bits) */
+#define BITS_IN_BYTE (8)
 
 
 /* Type Definitions */
@@ -34,6 +38,11 @@ int installStringFromLine(char *line);
  * **/
 int installNumbersFromLine(char *line);
 
+/**
+ * This function treats an incbin directive
+ * **/
+void installBinaryFromLine(char *line);
+
 /**
  * This function treats a extern directive
  * **/
@@ -59,6 +68,11 @@ void setOpcodeFirstWord(Word *w, Instruction inst);
  * **/
 Word makeFirstWord(Instruction inst, AddressingMode srcMode, AddressingMode destMode);
 
+/**
+ * This function returns whether if the addressing modes #srcMode, #destMode are legal for #inst
+ * **/
+Boolean hasCorrectAddressingModes(Instruction inst, AddressingMode srcMode, AddressingMode destMode);
+
 /**
  * This function makes an operand word of type immediate
  * **/
@@ -75,13 +89,19 @@ Word makeOperandWordSingleRegister(Register reg, Boolean isSource);
 Word makeOperandWordDoubleRegisters(Register srcReg, Register destReg);
 
 /**
- * This functions treats the first pass on file #fp
+ * This functions treats a line in the first pass
  * **/
 void analyzeLineFirstPass(char *line);
 
 /**
- * This functions treats a line in the first pass
+ * This functions treats the line #line of an included file or a macro body in the first pass, from its analysis
+ * #included (made once, see includeCache.h): what it defines and installs is added without analyzing it again
+ * **/
+void analyzeIncludedLine(struct IncludedLine *included, char *line);
+
+/**
+ * This functions treats the first pass on #source
  * **/
-void firstPass(char *fileName, FILE *fp);
+void firstPass(SourceFile *source);
 
 #endif
@@ -0,0 +1,514 @@
+/*****************************************
+* Include Cache Operations               *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "includeCache.h"
+#include "firstPass.h"
+#include "externalVariables.h"
+#include "fileHandling.h"
+#include "symbolHash.h"
+#include "utils.h"
+
+/* Definitions */
+#define INITIAL_INCLUDED_CAPACITY 16
+#define MAX_CACHE_KEY_PREFIX 48 /* The hash and the size before the path in a cache key */
+
+/* Type Definitions */
+/* A file that was included, kept until no source includes it */
+typedef struct IncludedFile {
+    char *key;                      /* Its key in the index                                                          */
+    char *path;                     /* The path of the file                                                          */
+    unsigned long hash;             /* The hash of its content when it was read                                      */
+    size_t size;                    /* The size of its content when it was read                                      */
+    SourceFile lines;               /* Its lines, with the lines of the files it includes after their .include lines */
+    IncludedLine *statements;       /* The analysis of its own lines                                                 */
+    unsigned statementCount;        /* The number of #statements                                                     */
+    struct IncludedFile **includes; /* The files its .include lines include, their lines are in #lines              */
+    unsigned includeCount;          /* The number of #includes                                                       */
+    Boolean isComplete;             /* If every file it includes was expanded (an unreadable file or a cycle is      */
+                                    /* looked for again by every source including it)                                */
+    Boolean isUsed;                 /* If a source included it since the cache was last trimmed                      */
+} IncludedFile;
+
+/* The included files, and their indices by "hash:size:path" */
+static IncludedFile **includedFiles = NULL;
+static unsigned includedCount = 0, includedCapacity = 0;
+static SymbolHash includedIndices = {NULL, 0, 0};
+
+/* The paths of the files the last expansion included */
+static char **includedPaths = NULL;
+static unsigned includedPathCount = 0, includedPathCapacity = 0;
+
+/* The analysis of the .include lines, by the outcome of the include */
+static IncludedLine includedFileLine = {INCLUDE_STATEMENT, INCLUDE_DIR, "", NULL, 0, NO_ERROR};
+static IncludedLine invalidOperandLine = {INCLUDE_STATEMENT, INCLUDE_DIR, "", NULL, 0, INCLUDE_OPERAND_INVALID};
+static IncludedLine invalidFileLine = {INCLUDE_STATEMENT, INCLUDE_DIR, "", NULL, 0, INCLUDE_FILE_INVALID};
+static IncludedLine cycleLine = {INCLUDE_STATEMENT, INCLUDE_DIR, "", NULL, 0, INCLUDE_CYCLE};
+
+/* Function Prototypes */
+static void expandIncludeLines(SourceFile *source, char *base, char **stack, int depth, IncludedFile *parent);
+
+/* Functions */
+/**
+ * This function keeps a copy of the #count words of #words in #statement
+ * **/
+static void keepWords(IncludedLine *statement, Word *words, unsigned count) {
+    if ((statement->words = (Word *) malloc(count * sizeof(Word))) == NULL) {
+        perror("keepWords");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(statement->words, words, count * sizeof(Word));
+    statement->wordCount = count;
+}
+
+/**
+ * This function returns the hash (FNV-1a) of the #size bytes of #content
+ * **/
+static unsigned long hashContent(unsigned char *content, size_t size) {
+    unsigned long hash = 2166136261UL;
+    size_t i;
+
+    for (i = 0; i < size; ++i)
+        hash = ((hash ^ content[i]) * 16777619UL) & 0xFFFFFFFFUL;
+
+    return hash;
+}
+
+/**
+ * This function returns the path of #fileName, relative to the directory of the file #base (a new string)
+ * **/
+static char *getIncludedPath(char *base, char *fileName) {
+    char *separator = strrchr(base, PATH_SEPARATOR);
+    size_t directoryLength = (*fileName == PATH_SEPARATOR || separator == NULL) ? 0 : separator - base + 1;
+    char *path = (char *) malloc(directoryLength + strlen(fileName) + 1);
+
+    if (path == NULL) {
+        perror("getIncludedPath");
+        exit(EXIT_FAILURE);
+    }
+
+    memcpy(path, base, directoryLength);
+    strcpy(path + directoryLength, fileName);
+    return path;
+}
+
+void preanalyzeLine(char *text, IncludedLine *statement) {
+    char line[MAX_LINE_LENGTH];
+    LabelList savedTable = symbolTable;
+    unsigned savedIc = ic, savedDc = dc, savedCodeWords = codeWordsInstalled, savedDataWords = dataWordsInstalled;
+    Boolean savedStats = shouldCollectStats, savedDebug = shouldOutputDebug, savedPool = shouldPoolData;
+    Boolean savedCheck = isCheckMode, savedExtern = shouldOutputExtern;
+    Directive dir;
+
+    statement->kind = PLAIN_STATEMENT;
+    statement->label[0] = '\0';
+    statement->words = NULL;
+    statement->wordCount = 0;
+    statement->err = NO_ERROR;
+
+    strcpy(line, text);
+    if (isIgnorable(line)) {
+        statement->kind = BLANK_STATEMENT;
+        return;
+    }
+    dir = getDirective(line);
+    strcpy(line, text);
+    if (dir != DATA_DIR && dir != STRING_DIR && dir != EXTERN_DIR &&
+        (dir != UNKNOWN_DIRECTIVE || getInstruction(line) == UNKNOWN_INST))
+        return;
+
+    /* The line on its own: nothing is counted, marked or pooled, and the words are built even in a check */
+    symbolTable = NULL;
+    ic = dc = 0;
+    errorCode = NO_ERROR;
+    errorColumn = 0;
+    shouldCollectStats = shouldOutputDebug = shouldPoolData = isCheckMode = FALSE;
+    strcpy(line, text);
+    analyzeLineFirstPass(line);
+
+    if (errorCode == NO_ERROR && dir == UNKNOWN_DIRECTIVE) {
+        if (symbolTable == NULL) { /* A label is put at the IC of the source, the line is left to the first pass */
+            statement->kind = INSTRUCTION_STATEMENT;
+            keepWords(statement, machineCodeImage, 1);
+        }
+    } else if (errorCode == NO_ERROR) {
+        statement->kind = dir == EXTERN_DIR ? EXTERN_STATEMENT : DATA_STATEMENT;
+        statement->dir = dir;
+        if (symbolTable != NULL)
+            strcpy(statement->label, symbolTable->labelName);
+        if (dc > 0) /* The data words are kept with the line */
+            keepWords(statement, dataImage, dc);
+    }
+
+    /* Everything goes back the way it was */
+    freeSymbolTable(&symbolTable);
+    memset(dataImage, 0, dc * sizeof(Word));
+    machineCodeImage[0] = 0;
+    symbolTable = savedTable;
+    ic = savedIc, dc = savedDc;
+    codeWordsInstalled = savedCodeWords, dataWordsInstalled = savedDataWords;
+    shouldCollectStats = savedStats, shouldOutputDebug = savedDebug, shouldPoolData = savedPool;
+    isCheckMode = savedCheck, shouldOutputExtern = savedExtern;
+    errorCode = NO_ERROR;
+    errorColumn = 0;
+}
+
+/**
+ * This function notes that the file #path was included by the expansion (once, however many times it is included)
+ * **/
+static void noteIncludedPath(char *path) {
+    char **tmp;
+    unsigned i;
+
+    for (i = 0; i < includedPathCount; ++i)
+        if (strcmp(includedPaths[i], path) == 0)
+            return;
+
+    /* Grow the paths (by doubling) if needed */
+    if (includedPathCount == includedPathCapacity) {
+        includedPathCapacity = includedPathCapacity ? includedPathCapacity * 2 : INITIAL_INCLUDED_CAPACITY;
+        if ((tmp = (char **) realloc(includedPaths, includedPathCapacity * sizeof(char *))) == NULL) {
+            perror("noteIncludedPath");
+            exit(EXIT_FAILURE);
+        }
+        includedPaths = tmp;
+    }
+
+    if ((includedPaths[includedPathCount] = (char *) malloc(strlen(path) + 1)) == NULL) {
+        perror("noteIncludedPath");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(includedPaths[includedPathCount++], path);
+}
+
+/**
+ * This function frees the paths noted by the last expansion
+ * **/
+static void freeIncludedPaths() {
+    unsigned i;
+
+    for (i = 0; i < includedPathCount; ++i)
+        free(includedPaths[i]);
+    includedPathCount = 0;
+}
+
+/**
+ * This function adds #file to the included files, under #key (a file kept under #key before is expanded from other
+ * contents, it is replaced in the index)
+ * **/
+static void cacheIncludedFile(char *key, IncludedFile *file) {
+    IncludedFile **tmp;
+    SymbolHashNode *node;
+
+    /* Grow the included files (by doubling) if needed */
+    if (includedCount == includedCapacity) {
+        includedCapacity = includedCapacity ? includedCapacity * 2 : INITIAL_INCLUDED_CAPACITY;
+        if ((tmp = (IncludedFile **) realloc(includedFiles, includedCapacity * sizeof(IncludedFile *))) == NULL) {
+            perror("cacheIncludedFile");
+            exit(EXIT_FAILURE);
+        }
+        includedFiles = tmp;
+    }
+
+    if (includedIndices.buckets == NULL)
+        initSymbolHash(&includedIndices, MIN_HASH_BUCKETS);
+    if ((node = insertSymbol(&includedIndices, key, includedCount, 0)) != NULL)
+        node->value = includedCount;
+    includedFiles[includedCount++] = file;
+}
+
+/**
+ * This function adds #file to the files #parent includes
+ * **/
+static void addInclude(IncludedFile *parent, IncludedFile *file) {
+    IncludedFile **tmp;
+
+    if ((tmp = (IncludedFile **) realloc(parent->includes, (parent->includeCount + 1) * sizeof(IncludedFile *))) ==
+        NULL) {
+        perror("addInclude");
+        exit(EXIT_FAILURE);
+    }
+    parent->includes = tmp;
+    parent->includes[parent->includeCount++] = file;
+}
+
+/**
+ * This function checks that the lines of the files #file includes (through any number of files) are still the ones
+ * its lines were expanded with: every one of them has the content it had when it was read, and none of them is one
+ * of the #depth files in #stack (the ones including #file, such a cycle is reported by expanding #file again).
+ * The files it goes through are noted as included.
+ * @return TRUE if they are, else FALSE
+ * **/
+static Boolean isExpansionCurrent(IncludedFile *file, char **stack, int depth) {
+    IncludedFile *nested;
+    unsigned char *content;
+    size_t size;
+    unsigned i;
+    int j;
+    Boolean isCurrent;
+
+    if (!file->isComplete || depth == MAX_INCLUDE_DEPTH)
+        return FALSE;
+    file->isUsed = TRUE;
+    stack[depth] = file->path;
+
+    for (i = 0; i < file->includeCount; ++i) {
+        nested = file->includes[i];
+        noteIncludedPath(nested->path);
+        for (j = 0; j <= depth; ++j)
+            if (strcmp(stack[j], nested->path) == 0)
+                return FALSE;
+
+        if ((content = mapBinaryFile(nested->path, &size)) == NULL)
+            return FALSE;
+        isCurrent = BOOLEANIZE(size == nested->size && hashContent(content, size) == nested->hash);
+        unmapBinaryFile(content, size);
+        if (!isCurrent || !isExpansionCurrent(nested, stack, depth + 1))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * This function returns the included file at #path: the kept one if a file with its path and content was
+ * included before and the files it includes didn't change since, else it is read and analyzed (with the files it
+ * includes) and kept.
+ * #stack holds the #depth files being expanded, the ones that include it.
+ * @return The file, or NULL (with the error in #err) if it can't be read or it includes itself
+ * **/
+static IncludedFile *loadIncludedFile(char *path, char **stack, int depth, Error *err) {
+    IncludedFile *file;
+    SymbolHashNode *node;
+    unsigned char *content;
+    unsigned long hash;
+    char *key;
+    size_t size;
+    unsigned i;
+
+    noteIncludedPath(path);
+
+    /* A file that includes itself (through any number of files) */
+    for (i = 0; i < (unsigned) depth; ++i)
+        if (strcmp(stack[i], path) == 0) {
+            *err = INCLUDE_CYCLE;
+            return NULL;
+        }
+    if (depth == MAX_INCLUDE_DEPTH) {
+        *err = INCLUDE_CYCLE;
+        return NULL;
+    }
+
+    if ((content = mapBinaryFile(path, &size)) == NULL) {
+        *err = INCLUDE_FILE_INVALID;
+        return NULL;
+    }
+
+    /*
+     * The key is the content and the path, a changed file is analyzed again. The kept file holds the lines of the
+     * files it includes too, it is reused only if they didn't change either
+     */
+    if ((key = (char *) malloc(MAX_CACHE_KEY_PREFIX + strlen(path))) == NULL) {
+        perror("loadIncludedFile");
+        exit(EXIT_FAILURE);
+    }
+    hash = hashContent(content, size);
+    sprintf(key, "%08lx:%lu:%s", hash, (unsigned long) size, path);
+    if (includedIndices.buckets != NULL && (node = findSymbol(&includedIndices, key)) != NULL &&
+        isExpansionCurrent(includedFiles[node->value], stack, depth)) {
+        unmapBinaryFile(content, size);
+        free(key);
+        return includedFiles[node->value];
+    }
+
+    if ((file = (IncludedFile *) malloc(sizeof(IncludedFile))) == NULL ||
+        (file->path = (char *) malloc(strlen(path) + 1)) == NULL) {
+        perror("loadIncludedFile");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(file->path, path);
+    file->key = key;
+    file->hash = hash;
+    file->size = size;
+    file->includes = NULL;
+    file->includeCount = 0;
+    file->isComplete = file->isUsed = TRUE;
+    stack[depth] = file->path;
+
+    /* Split it into lines, analyze each of them, and expand the files it includes */
+    readSourceText((char *) content, size, file->path, &file->lines);
+    unmapBinaryFile(content, size);
+    file->statementCount = file->lines.count;
+    if ((file->statements = (IncludedLine *) malloc((file->statementCount ? file->statementCount : 1) *
+                                                     sizeof(IncludedLine))) == NULL) {
+        perror("loadIncludedFile");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < file->statementCount; ++i)
+        preanalyzeLine(file->lines.lines[i].text, file->statements + i);
+    for (i = 0; i < file->statementCount; ++i)
+        file->lines.lines[i].included = file->statements + i;
+    expandIncludeLines(&file->lines, file->path, stack, depth + 1, file);
+
+    cacheIncludedFile(key, file);
+    return file;
+}
+
+/**
+ * This function appends the .include line #line of the file #base to #to, then the lines of the file it includes
+ * (all of them reported on #line). #parent is the kept file #base (NULL for a source), it notes the included file.
+ * **/
+static void appendIncludeLine(SourceFile *to, SourceLine *line, char *base, char **stack, int depth,
+                              IncludedFile *parent) {
+    char text[MAX_LINE_LENGTH], *fileName, *end, *path;
+    IncludedFile *file = NULL;
+    Error err = NO_ERROR;
+    unsigned i;
+
+    /* The operand is the quoted file name, and nothing after it */
+    strcpy(text, line->text);
+    fileName = strip(strstr(text, ".include") + strlen(".include"));
+    if (*fileName != '\"' || (end = strchr(fileName + 1, '\"')) == NULL || end == fileName + 1 || !isEmpty(end + 1))
+        err = INCLUDE_OPERAND_INVALID;
+    else {
+        *end = '\0';
+        path = getIncludedPath(base, fileName + 1);
+        file = loadIncludedFile(path, stack, depth, &err);
+        free(path);
+    }
+
+    if (parent != NULL && file != NULL)
+        addInclude(parent, file);
+    else if (parent != NULL && err != INCLUDE_OPERAND_INVALID)
+        parent->isComplete = FALSE;
+
+    appendSourceLine(to, line->text, line->lineNum);
+    switch (err) {
+        case INCLUDE_OPERAND_INVALID:
+            to->lines[to->count - 1].included = &invalidOperandLine;
+            break;
+        case INCLUDE_FILE_INVALID:
+            to->lines[to->count - 1].included = &invalidFileLine;
+            break;
+        case INCLUDE_CYCLE:
+            to->lines[to->count - 1].included = &cycleLine;
+            break;
+        default:
+            to->lines[to->count - 1].included = &includedFileLine;
+            break;
+    }
+
+    if (file != NULL)
+        for (i = 0; i < file->lines.count; ++i) {
+            appendSourceLine(to, file->lines.lines[i].text, line->lineNum);
+            to->lines[to->count - 1].included = file->lines.lines[i].included;
+        }
+}
+
+/**
+ * This function puts the lines of the files the .include lines of #source include after them. #source is the file
+ * #base (kept as #parent, NULL for a source), and #stack holds the #depth files being expanded (#source is the last
+ * one).
+ * **/
+static void expandIncludeLines(SourceFile *source, char *base, char **stack, int depth, IncludedFile *parent) {
+    SourceFile expanded;
+    char line[MAX_LINE_LENGTH];
+    unsigned i;
+
+    /* Most sources include nothing */
+    for (i = 0; i < source->count && strstr(source->lines[i].text, ".include") == NULL; ++i)
+        ;
+    if (i == source->count)
+        return;
+
+    expanded.name = source->name;
+    expanded.lines = NULL;
+    expanded.count = expanded.capacity = 0;
+    for (i = 0; i < source->count; ++i) {
+        strcpy(line, source->lines[i].text);
+        if (strstr(line, ".include") != NULL && !isIgnorable(line) && getDirective(line) == INCLUDE_DIR)
+            appendIncludeLine(&expanded, source->lines + i, base, stack, depth, parent);
+        else {
+            appendSourceLine(&expanded, source->lines[i].text, source->lines[i].lineNum);
+            expanded.lines[expanded.count - 1].included = source->lines[i].included;
+        }
+    }
+
+    freeSourceFile(source);
+    *source = expanded;
+}
+
+void expandIncludes(SourceFile *source) {
+    char *stack[MAX_INCLUDE_DEPTH];
+
+    /* The files of the includes are relative to the source, and the source can't be included by them */
+    freeIncludedPaths();
+    stack[0] = appendFileSuffix(source->name, ASM);
+    expandIncludeLines(source, source->name, stack, 1, NULL);
+    free(stack[0]);
+}
+
+unsigned getIncludedPaths(char ***paths) {
+    *paths = includedPaths;
+    return includedPathCount;
+}
+
+/**
+ * This function frees the included file #file
+ * **/
+static void freeIncludedFile(IncludedFile *file) {
+    unsigned i;
+
+    for (i = 0; i < file->statementCount; ++i)
+        free(file->statements[i].words);
+    free(file->statements);
+    freeSourceFile(&file->lines);
+    free(file->includes);
+    free(file->path);
+    free(file->key);
+    free(file);
+}
+
+void trimIncludeCache() {
+    unsigned i, kept = 0;
+
+    /* A file in use is reached only through files in use, the others can go */
+    for (i = 0; i < includedCount; ++i)
+        if (includedFiles[i]->isUsed) {
+            includedFiles[i]->isUsed = FALSE;
+            includedFiles[kept++] = includedFiles[i];
+        } else
+            freeIncludedFile(includedFiles[i]);
+    includedCount = kept;
+
+    /* The index is built again, newest first: a key two kept files have leads to the one expanded last */
+    if (includedIndices.buckets != NULL)
+        freeSymbolHash(&includedIndices);
+    includedIndices.buckets = NULL;
+    if (includedCount > 0)
+        initSymbolHash(&includedIndices, MIN_HASH_BUCKETS);
+    for (i = includedCount; i-- > 0;)
+        insertSymbol(&includedIndices, includedFiles[i]->key, i, 0);
+}
+
+void freeIncludeCache() {
+    unsigned i;
+
+    for (i = 0; i < includedCount; ++i)
+        freeIncludedFile(includedFiles[i]);
+    free(includedFiles);
+    includedFiles = NULL;
+    includedCount = includedCapacity = 0;
+
+    if (includedIndices.buckets != NULL)
+        freeSymbolHash(&includedIndices);
+    includedIndices.buckets = NULL;
+
+    freeIncludedPaths();
+    free(includedPaths);
+    includedPaths = NULL;
+    includedPathCapacity = 0;
+}
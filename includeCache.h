@@ -0,0 +1,76 @@
+/*****************************************
+* Include Cache Header                   *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef INCLUDE_CACHE_H
+#define INCLUDE_CACHE_H
+
+/*Imports */
+#include "mainHeader.h"
+#include "dataTypes.h"
+#include "sourceFile.h"
+
+/* Definitions */
+#define MAX_INCLUDE_DEPTH 32   /* The deepest nesting of includes (a cycle through paths written differently ends there) */
+
+/* Type Definitions */
+/* What a line of an included file (or of a macro body) is */
+typedef enum {
+    PLAIN_STATEMENT,       /* Analyzed by the first pass in every source (it depends on the source, or has an error) */
+    BLANK_STATEMENT,       /* An empty line or a comment                                                           */
+    INCLUDE_STATEMENT,     /* An .include line, followed by the lines of the file it includes                     */
+    MACRO_STATEMENT,       /* A line of a macro definition that has an error (see macro.h)                          */
+    EXTERN_STATEMENT,      /* An .extern directive                                                                 */
+    DATA_STATEMENT,        /* A .data / .string directive (with or without a label)                               */
+    INSTRUCTION_STATEMENT  /* An instruction without a label                                                       */
+} StatementKind;
+
+/* The analysis of a line of an included file or a macro body, made once and reused wherever the line is put */
+typedef struct IncludedLine {
+    StatementKind kind;            /* What the line is                                                         */
+    Directive dir;                 /* The directive of a data statement                                        */
+    char label[MAX_LINE_LENGTH];   /* The label a data statement defines ("" if none), or the .extern operand   */
+    Word *words;                   /* The words a data statement puts in the data image, or the first word of  */
+                                   /* an instruction (its operand words are made by the second pass)           */
+    unsigned wordCount;            /* The number of #words                                                     */
+    Error err;                     /* The error of an include / macro statement (NO_ERROR if it has none)      */
+} IncludedLine;
+
+/* Function Prototypes */
+/**
+ * This function analyzes the line #text into #statement. A .extern, a data line or an instruction is run through
+ * the first pass on its own, from empty tables and images (call it before a file is assembled), and what it
+ * defines and installs is kept; a line whose analysis depends on the source it's put in is left to the first pass.
+ * **/
+void preanalyzeLine(char *text, IncludedLine *statement);
+
+/**
+ * This function expands the .include lines of #source (call it before the file is assembled, its analysis uses the
+ * tables and the images): the lines of the included file are put after every .include line, with its line number.
+ * An included file is read, split and analyzed once per run and kept by its path and the hash of its content, so
+ * another source including it (or a change to it) costs a read and a hash of it and of the files it includes, and
+ * its .extern and data lines are installed by the first pass from their analysis.
+ * **/
+void expandIncludes(SourceFile *source);
+
+/**
+ * This function returns the paths of the files the last run of expandIncludes included (through any number of
+ * files, the ones that couldn't be read too), they are kept until its next run
+ * @return The number of paths (the paths are put in #paths)
+ * **/
+unsigned getIncludedPaths(char ***paths);
+
+/**
+ * This function frees the included files that no source included since the last call (the ones left behind by a
+ * change), a run that never ends calls it between its assemblies
+ * **/
+void trimIncludeCache();
+
+/**
+ * This function frees the included files kept by the runs of expandIncludes
+ * **/
+void freeIncludeCache();
+
+#endif
@@ -0,0 +1,638 @@
+/*****************************************
+* Incremental Assembly Operations        *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "incremental.h"
+#include "firstPass.h"
+#include "secondPass.h"
+#include "externalVariables.h"
+#include "diagnostics.h"
+#include "macro.h"
+
+/* Functions */
+/**
+ * This function makes #list hold at least #count records
+ * **/
+static void reserveRecords(RecordList *list, unsigned count) {
+    SourceRecord **tmp;
+
+    /* Grow the list (by doubling) if needed */
+    if (count > list->capacity) {
+        if (list->capacity == 0)
+            list->capacity = INITIAL_RECORD_CAPACITY;
+        while (list->capacity < count)
+            list->capacity *= 2;
+        if ((tmp = (SourceRecord **) realloc(list->records, list->capacity * sizeof(SourceRecord *))) == NULL) {
+            perror("reserveRecords");
+            exit(EXIT_FAILURE);
+        }
+        list->records = tmp;
+    }
+}
+
+/**
+ * This function appends #record to #list
+ * **/
+static void addRecord(RecordList *list, SourceRecord *record) {
+    reserveRecords(list, list->count + 1);
+    list->records[list->count++] = record;
+}
+
+/**
+ * This function removes every appearance of #record from #list (the order of the rest isn't kept)
+ * **/
+static void removeRecord(RecordList *list, SourceRecord *record) {
+    unsigned i = 0;
+
+    while (i < list->count)
+        if (list->records[i] == record)
+            list->records[i] = list->records[--list->count];
+        else
+            ++i;
+}
+
+/**
+ * This function returns the symbol #name of #source, it is added if #shouldCreate is set and it's missing
+ * @return The symbol, or NULL if it's missing (and wasn't added)
+ * **/
+static IncrementalSymbol *getSymbol(IncrementalSource *source, char *name, Boolean shouldCreate) {
+    SymbolHashNode *node = findSymbol(&source->symbolIndices, name);
+    SymbolHash grown;
+    IncrementalSymbol *tmp;
+    unsigned i;
+
+    if (node != NULL)
+        return source->symbols + node->value;
+    if (!shouldCreate)
+        return NULL;
+
+    /* Keep the load factor of the index under 1/2, by moving it to twice the buckets */
+    if (2 * (source->symbolIndices.size + 1) > source->symbolIndices.bucketCount) {
+        initSymbolHash(&grown, source->symbolIndices.bucketCount);
+        for (i = 0; i < source->symbolIndices.bucketCount; ++i)
+            for (node = source->symbolIndices.buckets[i]; node; node = node->next)
+                insertSymbol(&grown, node->name, node->value, node->owner);
+        freeSymbolHash(&source->symbolIndices);
+        source->symbolIndices = grown;
+    }
+
+    /* Grow the symbols (by doubling) if needed */
+    if (source->symbolCount == source->symbolCapacity) {
+        source->symbolCapacity = source->symbolCapacity ? source->symbolCapacity * 2 : INITIAL_RECORD_CAPACITY;
+        if ((tmp = (IncrementalSymbol *) realloc(source->symbols,
+                                                 source->symbolCapacity * sizeof(IncrementalSymbol))) == NULL) {
+            perror("getSymbol");
+            exit(EXIT_FAILURE);
+        }
+        source->symbols = tmp;
+    }
+
+    insertSymbol(&source->symbolIndices, name, source->symbolCount, 0);
+    memset(source->symbols + source->symbolCount, 0, sizeof(IncrementalSymbol));
+    if ((source->symbols[source->symbolCount].name = (char *) malloc(strlen(name) + 1)) == NULL) {
+        perror("getSymbol");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(source->symbols[source->symbolCount].name, name);
+    return source->symbols + source->symbolCount++;
+}
+
+/**
+ * This function returns the line defining #symbol (the first one in the source)
+ * @return The record of the line, or NULL if #symbol isn't defined
+ * **/
+static SourceRecord *getFirstDefinition(IncrementalSymbol *symbol) {
+    SourceRecord *first = NULL;
+    unsigned i;
+
+    for (i = 0; i < symbol->definitions.count; ++i)
+        if (first == NULL || symbol->definitions.records[i]->index < first->index)
+            first = symbol->definitions.records[i];
+
+    return first;
+}
+
+/**
+ * This function returns the column (1 based) of the word #name in #line, looking from #from
+ * @return The column, or 0 if #name isn't there
+ * **/
+static int findWordColumn(char *line, char *from, char *name) {
+    size_t length = strlen(name);
+
+    for (; (from = strstr(from, name)) != NULL; ++from)
+        /* A whole word only (not the end of a longer label) */
+        if ((from == line || !isalnum(from[-1])) && !isalnum(from[length]))
+            return (int) (from - line) + 1;
+
+    return 0;
+}
+
+/**
+ * This function finds the operands of the instruction in #line, encodes the ones that don't need a symbol in the
+ * words of #record and keeps the direct ones in its operands (like the second pass does)
+ * **/
+static void lexOperands(SourceRecord *record, char *line) {
+    char copy[MAX_LINE_LENGTH], *firstOperand, *secondOperand, *operands[2], *position;
+    AddressingMode srcMode, destMode, modes[2];
+    unsigned i, word = 1;
+    SymbolOperand *operand;
+
+    strcpy(copy, line);
+    firstOperand  = getFirstOperand(copy);
+    secondOperand = getSecondOperand(copy);
+    srcMode  = getAddressingModeFirstPass(firstOperand);
+    destMode = getAddressingModeFirstPass(secondOperand);
+
+    /* If there is only one operand its the dest one */
+    operands[0] = firstOperand, operands[1] = secondOperand;
+    if (destMode == UNKNOWN_ADDRESSING_MODE && srcMode != UNKNOWN_ADDRESSING_MODE) {
+        destMode = srcMode;
+        srcMode = UNKNOWN_ADDRESSING_MODE;
+        operands[1] = firstOperand, operands[0] = NULL;
+    }
+    modes[0] = srcMode, modes[1] = destMode;
+
+    /* The operands start after the label and the instruction */
+    position = strip(line);
+    if (strchr(position, ':') != NULL && getLabel(position) != NULL)
+        position = strip(strchr(position, ':') + 1);
+    while (*position && !isspace(*position))
+        ++position;
+
+    if ((srcMode == REGISTER_DIRECT || srcMode == REGISTER_INDIRECT) &&
+        (destMode == REGISTER_DIRECT || destMode == REGISTER_INDIRECT)) /* Both registers share a word */
+        record->words[word] = makeOperandWordDoubleRegisters(getRegister(operands[0]), getRegister(operands[1]));
+    else
+        for (i = 0; i < 2; ++i) {
+            if (modes[i] == IMMEDIATE)
+                record->words[word++] = makeOperandWordImmediate(getNumber(operands[i]));
+            else if (modes[i] == REGISTER_DIRECT || modes[i] == REGISTER_INDIRECT)
+                record->words[word++] = makeOperandWordSingleRegister(getRegister(operands[i]), BOOLEANIZE(i == 0));
+            else if (modes[i] == DIRECT) { /* Resolved when the address of the symbol is known */
+                operand = record->operands + record->operandCount++;
+                strcpy(operand->name, operands[i]);
+                operand->wordIndex = word++;
+                operand->isSource = BOOLEANIZE(i == 0);
+                if (i == 1 && srcMode != UNKNOWN_ADDRESSING_MODE && strchr(position, ',') != NULL)
+                    position = strchr(position, ',') + 1; /* The destination follows the comma */
+                operand->column = findWordColumn(line, position, operand->name);
+            }
+        }
+
+    free(firstOperand);
+    free(secondOperand);
+}
+
+/**
+ * This function lexes the line of #record on its own: it runs the first pass on it, with empty tables and images,
+ * and keeps what the line defines and the words it puts in the images
+ * **/
+static void lexRecord(IncrementalSource *source, SourceRecord *record) {
+    char line[MAX_LINE_LENGTH], copy[MAX_LINE_LENGTH], *entryLabel;
+    char first[MAX_LINE_LENGTH], second[MAX_LINE_LENGTH], third[MAX_LINE_LENGTH];
+    Directive dir;
+    int words;
+
+    /* The line as read by fgets */
+    strncpy(line, record->text, MAX_LINE_LENGTH - 2);
+    line[MAX_LINE_LENGTH - 2] = '\0';
+    strcat(line, "\n");
+
+    /* Run the first pass on the line, from empty tables and images */
+    symbolTable = NULL;
+    ic = dc = 0;
+    codeWordsInstalled = dataWordsInstalled = 0;
+    errorCode = NO_ERROR;
+    errorColumn = 0;
+    currentLineNum = (int) record->index + 1;
+    sourceName = source->name;
+    strcpy(copy, line);
+    analyzeLineFirstPass(copy);
+
+    record->err = (Error) errorCode;
+    record->errorColumn = errorColumn ? errorColumn : getStatementColumn(line);
+    record->codeWidth = ic;
+    record->dataWidth = dc;
+    record->operandCount = 0;
+    record->data = NULL;
+    memcpy(record->words, machineCodeImage, MAX_STATEMENT_WORDS * sizeof(Word));
+
+    /* The data words are kept with the line */
+    if (dc > 0) {
+        if ((record->data = (Word *) malloc(dc * sizeof(Word))) == NULL) {
+            perror("lexRecord");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(record->data, dataImage, dc * sizeof(Word));
+    }
+
+    /* The symbol the line defined (a label or an .extern operand) */
+    record->definesSymbol = BOOLEANIZE(symbolTable != NULL);
+    record->symbol[0] = '\0';
+    if (symbolTable != NULL) {
+        strcpy(record->symbol, symbolTable->labelName);
+        record->feature = symbolTable->feature;
+        record->symbolColumn = symbolTable->feature == EXTERN_FEATURE ?
+                               findWordColumn(line, strstr(line, ".extern") + strlen(".extern"), record->symbol) :
+                               getStatementColumn(line);
+        freeSymbolTable(&symbolTable);
+        symbolTable = NULL;
+    }
+
+    /* What the line is */
+    strcpy(copy, line);
+    dir = getDirective(copy);
+    if (isIgnorable(line))
+        record->kind = IGNORED_LINE;
+    else if (record->err != NO_ERROR)
+        record->kind = INVALID_LINE;
+    else if (dir == DATA_DIR || dir == STRING_DIR || dir == INCBIN_DIR)
+        record->kind = DATA_LINE;
+    else if (dir == EXTERN_DIR)
+        record->kind = EXTERN_LINE;
+    else if (dir == INCLUDE_DIR) /* The language server doesn't follow includes */
+        record->kind = IGNORED_LINE;
+    else if (dir == ENTRY_DIR) { /* The operand is taken like the second pass takes it */
+        record->kind = ENTRY_LINE;
+        strcpy(copy, line);
+        entryLabel = strip(strstr(copy, ".entry") + strlen(".entry"));
+        removeNewLine(entryLabel);
+        strcpy(record->symbol, entryLabel);
+        record->symbolColumn = (int) (entryLabel - copy) + 1;
+    } else {
+        record->kind = CODE_LINE;
+        lexOperands(record, line);
+    }
+
+    /* What the line may be to a macro, the lines around it tell what it is (see markMacroLines) */
+    record->lexedKind = record->kind;
+    record->isMacroLine = FALSE;
+    record->macroMark = NO_MACRO_MARK;
+    record->macroName[0] = '\0';
+    words = sscanf(line, "%s %s %s", first, second, third);
+    if (words > 0 && strcmp(first, MACRO_START) == 0) {
+        record->macroMark = MACRO_START_MARK;
+        if (words == 2)
+            strcpy(record->macroName, second);
+    }
+    else if (words > 0 && strcmp(first, MACRO_END) == 0)
+        record->macroMark = MACRO_END_MARK;
+    else if (words == 1) {
+        record->macroMark = SINGLE_WORD_MARK;
+        strcpy(record->macroName, first);
+    }
+
+    ++source->linesLexed;
+}
+
+/**
+ * This function adds #record to the definitions and the uses of the symbols it defines and refers to
+ * **/
+static void linkRecord(IncrementalSource *source, SourceRecord *record) {
+    unsigned i;
+
+    if (record->isMacroLine)
+        return;
+    if (record->definesSymbol)
+        addRecord(&getSymbol(source, record->symbol, TRUE)->definitions, record);
+    if (record->kind == ENTRY_LINE)
+        addRecord(&getSymbol(source, record->symbol, TRUE)->uses, record);
+    for (i = 0; i < record->operandCount; ++i)
+        addRecord(&getSymbol(source, record->operands[i].name, TRUE)->uses, record);
+}
+
+/**
+ * This function removes #record from the definitions and the uses of the symbols it defines and refers to
+ * **/
+static void unlinkRecord(IncrementalSource *source, SourceRecord *record) {
+    unsigned i;
+
+    if (record->isMacroLine)
+        return;
+    if (record->definesSymbol)
+        removeRecord(&getSymbol(source, record->symbol, FALSE)->definitions, record);
+    if (record->kind == ENTRY_LINE)
+        removeRecord(&getSymbol(source, record->symbol, FALSE)->uses, record);
+    for (i = 0; i < record->operandCount; ++i)
+        removeRecord(&getSymbol(source, record->operands[i].name, FALSE)->uses, record);
+}
+
+/**
+ * This function computes the operand word of #symbol (the address of its definition, and its ARE)
+ * @return TRUE if #symbol is defined, else FALSE
+ * **/
+static Boolean resolveSymbol(IncrementalSource *source, IncrementalSymbol *symbol, Word *word) {
+    SourceRecord *definition = getFirstDefinition(symbol);
+    unsigned value;
+
+    if (definition == NULL)
+        return FALSE;
+
+    /* Data follows the code in memory, like the end of the first pass relocates it */
+    if (definition->feature == EXTERN_FEATURE)
+        value = 0;
+    else if (definition->feature == CODE_FEATURE)
+        value = definition->codeOffset + MEMORY_OFFSET;
+    else
+        value = definition->dataOffset + source->codeSize + MEMORY_OFFSET;
+
+    *word = value << ARE_OFFSET;
+    setARE(word, definition->feature == EXTERN_FEATURE ? EXTERNAL : RELOCATABLE);
+    return TRUE;
+}
+
+/**
+ * This function resolves the words of the operands of #record referring to #name (all of them if #name is NULL)
+ * **/
+static void resolveOperands(IncrementalSource *source, SourceRecord *record, char *name) {
+    IncrementalSymbol *symbol;
+    unsigned i;
+
+    for (i = 0; i < record->operandCount; ++i)
+        if (name == NULL || strcmp(record->operands[i].name, name) == 0) {
+            symbol = getSymbol(source, record->operands[i].name, FALSE);
+            record->words[record->operands[i].wordIndex] = symbol->isDefined ? symbol->word : 0;
+            ++source->wordsResolved;
+        }
+}
+
+/**
+ * This function marks the macro lines of #source like expandMacros finds them: the "mcr" and "endmcr" lines, the
+ * lines between them, and the lines holding only the name of a macro defined above. A line that became a macro
+ * line is unlinked, and a line that stopped being one is linked and its operands are resolved
+ * **/
+static void markMacroLines(IncrementalSource *source) {
+    SymbolHash names;
+    SourceRecord *record;
+    Boolean isInDefinition = FALSE, isMacroLine;
+    unsigned i;
+
+    initSymbolHash(&names, 0);
+    for (i = 0; i < source->lines.count; ++i) {
+        record = source->lines.records[i];
+        isMacroLine = TRUE;
+        if (record->macroMark == MACRO_START_MARK) { /* A definition inside a definition defines nothing */
+            if (!isInDefinition && isLegalMacroName(record->macroName))
+                insertSymbol(&names, record->macroName, 0, 0);
+            isInDefinition = TRUE;
+        }
+        else if (record->macroMark == MACRO_END_MARK)
+            isInDefinition = FALSE;
+        else if (!isInDefinition &&
+                 (record->macroMark != SINGLE_WORD_MARK || findSymbol(&names, record->macroName) == NULL))
+            isMacroLine = FALSE;
+
+        if (isMacroLine == record->isMacroLine)
+            continue;
+        if (isMacroLine)
+            unlinkRecord(source, record);
+        record->isMacroLine = isMacroLine;
+        record->kind = isMacroLine ? IGNORED_LINE : record->lexedKind;
+        if (!isMacroLine) {
+            linkRecord(source, record);
+            resolveOperands(source, record, NULL);
+        }
+    }
+    freeSymbolHash(&names);
+}
+
+/**
+ * This function frees #record
+ * **/
+static void freeRecord(SourceRecord *record) {
+    free(record->text);
+    free(record->data);
+    free(record);
+}
+
+void initIncrementalSource(IncrementalSource *source, char *name) {
+    source->name = name;
+    source->lines.records = NULL;
+    source->lines.count = source->lines.capacity = 0;
+    initSymbolHash(&source->symbolIndices, 0);
+    source->symbols = NULL;
+    source->symbolCount = source->symbolCapacity = 0;
+    source->codeSize = source->dataSize = 0;
+    source->linesLexed = source->wordsResolved = 0;
+}
+
+void replaceSourceLines(IncrementalSource *source, unsigned first, unsigned removed, char **texts, unsigned count) {
+    LabelList savedSymbolTable = symbolTable;
+    char *savedSourceName = sourceName;
+    SourceRecord *record, **lines;
+    IncrementalSymbol *symbol;
+    unsigned i, j, codeOffset = 0, dataOffset = 0;
+    Boolean isDefined;
+    Word word = 0;
+
+    source->linesLexed = source->wordsResolved = 0;
+    if (first > source->lines.count)
+        first = source->lines.count;
+    if (removed > source->lines.count - first)
+        removed = source->lines.count - first;
+
+    /* Remove the replaced lines */
+    for (i = first; i < first + removed; ++i) {
+        unlinkRecord(source, source->lines.records[i]);
+        freeRecord(source->lines.records[i]);
+    }
+
+    /* Make room for the new lines (the lines after them move, their records stay) */
+    reserveRecords(&source->lines, source->lines.count - removed + count);
+    lines = source->lines.records;
+    memmove(lines + first + count, lines + first + removed, (source->lines.count - first - removed) *
+                                                            sizeof(SourceRecord *));
+    source->lines.count = source->lines.count - removed + count;
+
+    /* Lex the new lines, on their own */
+    for (i = first; i < first + count; ++i) {
+        if ((record = (SourceRecord *) malloc(sizeof(SourceRecord))) == NULL ||
+            (record->text = (char *) malloc(strlen(texts[i - first]) + 1)) == NULL) {
+            perror("replaceSourceLines");
+            exit(EXIT_FAILURE);
+        }
+        strcpy(record->text, texts[i - first]);
+        record->index = i;
+        lexRecord(source, record);
+        lines[i] = record;
+        linkRecord(source, record);
+    }
+    symbolTable = savedSymbolTable;
+    sourceName = savedSourceName;
+
+    /* The edit can start or end a macro definition, it changes only the lines from the first new one */
+    markMacroLines(source);
+
+    /* Shift the lines from the first new one (IC / DC before a line are the sums of the widths before it) */
+    if (first > 0 && !lines[first - 1]->isMacroLine) {
+        codeOffset = lines[first - 1]->codeOffset + lines[first - 1]->codeWidth;
+        dataOffset = lines[first - 1]->dataOffset + lines[first - 1]->dataWidth;
+    }
+    else if (first > 0) {
+        codeOffset = lines[first - 1]->codeOffset;
+        dataOffset = lines[first - 1]->dataOffset;
+    }
+    for (i = first; i < source->lines.count; ++i) {
+        lines[i]->index = i;
+        lines[i]->codeOffset = codeOffset;
+        lines[i]->dataOffset = dataOffset;
+        if (!lines[i]->isMacroLine) {
+            codeOffset += lines[i]->codeWidth;
+            dataOffset += lines[i]->dataWidth;
+        }
+    }
+    source->codeSize = codeOffset;
+    source->dataSize = dataOffset;
+
+    /* Resolve again only the operands referring to a symbol whose word changed */
+    for (i = 0; i < source->symbolCount; ++i) {
+        symbol = source->symbols + i;
+        isDefined = resolveSymbol(source, symbol, &word);
+        if (isDefined != symbol->isDefined || (isDefined && word != symbol->word)) {
+            symbol->isDefined = isDefined;
+            symbol->word = isDefined ? word : 0;
+            for (j = 0; j < symbol->uses.count; ++j)
+                resolveOperands(source, symbol->uses.records[j], symbol->name);
+        }
+    }
+
+    /* And the operands of the new lines */
+    for (i = first; i < first + count; ++i)
+        resolveOperands(source, lines[i], NULL);
+}
+
+void reportIncrementalDiagnostics(IncrementalSource *source) {
+    SourceRecord *record, *definition;
+    IncrementalSymbol *symbol;
+    unsigned i, j;
+
+    for (i = 0; i < source->lines.count; ++i) {
+        record = source->lines.records[i];
+        if (record->isMacroLine) /* The assembler reports the errors of the macros */
+            continue;
+        definition = record->definesSymbol ? getFirstDefinition(getSymbol(source, record->symbol, FALSE)) : NULL;
+
+        if (record->err != NO_ERROR) /* The error of the line on its own comes first, like in the first pass */
+            alertLineError((int) i + 1, record->errorColumn, record->err);
+        else if (definition != NULL && definition != record &&
+                 !(record->kind == EXTERN_LINE && definition->feature == EXTERN_FEATURE)) /* Defined before */
+            alertLineError((int) i + 1, record->symbolColumn,
+                           record->kind == EXTERN_LINE ? EXTERN_OPERAND_ALREADY_EXIST : LABEL_NAME_ALREADY_EXIST);
+        else if (record->dataOffset + record->dataWidth > MEMORY_SIZE)
+            alertLineError((int) i + 1, getStatementColumn(record->text), DATA_IMAGE_OVERFLOW);
+        else if (record->kind == ENTRY_LINE && !getSymbol(source, record->symbol, FALSE)->isDefined)
+            alertLineError((int) i + 1, record->symbolColumn, ENTRY_LABEL_DOSENT_EXIST);
+
+        /* The second pass leaves out an operand whose label isn't defined, warn about it */
+        for (j = 0; j < record->operandCount; ++j) {
+            symbol = getSymbol(source, record->operands[j].name, FALSE);
+            if (!symbol->isDefined)
+                reportDiagnostic(SEVERITY_WARNING, (int) i + 1, record->operands[j].column, OPERAND_LABEL_UNDEFINED);
+        }
+    }
+}
+
+char *getSymbolAt(IncrementalSource *source, unsigned index, int column, int *start) {
+    SourceRecord *record;
+    unsigned i;
+
+    if (index >= source->lines.count)
+        return NULL;
+    record = source->lines.records[index];
+    if (record->isMacroLine)
+        return NULL;
+
+    /* The label defined by the line, or the operand of .extern / .entry */
+    if ((record->definesSymbol || record->kind == ENTRY_LINE) && column >= record->symbolColumn &&
+        column <= record->symbolColumn + (int) strlen(record->symbol)) {
+        *start = record->symbolColumn;
+        return record->symbol;
+    }
+
+    /* A direct operand */
+    for (i = 0; i < record->operandCount; ++i)
+        if (record->operands[i].column && column >= record->operands[i].column &&
+            column <= record->operands[i].column + (int) strlen(record->operands[i].name)) {
+            *start = record->operands[i].column;
+            return record->operands[i].name;
+        }
+
+    return NULL;
+}
+
+SourceRecord *getSymbolDefinition(IncrementalSource *source, char *name) {
+    IncrementalSymbol *symbol = getSymbol(source, name, FALSE);
+
+    return symbol ? getFirstDefinition(symbol) : NULL;
+}
+
+/**
+ * This function compares two uses by their line and column (for qsort)
+ * **/
+static int compareUses(const void *first, const void *second) {
+    const SymbolUse *a = (const SymbolUse *) first, *b = (const SymbolUse *) second;
+
+    if (a->site.lineNum != b->site.lineNum)
+        return a->site.lineNum < b->site.lineNum ? -1 : 1;
+    return a->column < b->column ? -1 : a->column > b->column;
+}
+
+unsigned getSymbolUses(IncrementalSource *source, char *name, SymbolUse **uses) {
+    IncrementalSymbol *symbol = getSymbol(source, name, FALSE);
+    SourceRecord *record;
+    unsigned i, j, count = 0;
+
+    *uses = NULL;
+    if (symbol == NULL || symbol->uses.count == 0)
+        return 0;
+
+    if ((*uses = (SymbolUse *) malloc(symbol->uses.count * sizeof(SymbolUse))) == NULL) {
+        perror("getSymbolUses");
+        exit(EXIT_FAILURE);
+    }
+
+    /* A line is in the uses once per operand referring to the symbol, take each of its operands once */
+    for (i = 0; i < symbol->uses.count; ++i) {
+        record = symbol->uses.records[i];
+        for (j = 0; j < i && symbol->uses.records[j] != record; ++j)
+            ;
+        if (j < i) /* Already taken */
+            continue;
+
+        if (record->kind == ENTRY_LINE) {
+            (*uses)[count].site.address = 0;
+            (*uses)[count].site.lineNum = (int) record->index + 1;
+            (*uses)[count].site.isSource = FALSE;
+            (*uses)[count++].column = record->symbolColumn;
+        }
+        for (j = 0; j < record->operandCount; ++j)
+            if (strcmp(record->operands[j].name, name) == 0) {
+                (*uses)[count].site.address = record->codeOffset + record->operands[j].wordIndex + MEMORY_OFFSET;
+                (*uses)[count].site.lineNum = (int) record->index + 1;
+                (*uses)[count].site.isSource = record->operands[j].isSource;
+                (*uses)[count++].column = record->operands[j].column;
+            }
+    }
+
+    qsort(*uses, count, sizeof(SymbolUse), compareUses);
+    return count;
+}
+
+void freeIncrementalSource(IncrementalSource *source) {
+    unsigned i;
+
+    for (i = 0; i < source->lines.count; ++i)
+        freeRecord(source->lines.records[i]);
+    free(source->lines.records);
+
+    for (i = 0; i < source->symbolCount; ++i) {
+        free(source->symbols[i].name);
+        free(source->symbols[i].definitions.records);
+        free(source->symbols[i].uses.records);
+    }
+    free(source->symbols);
+    freeSymbolHash(&source->symbolIndices);
+}
@@ -0,0 +1,140 @@
+/*****************************************
+* Incremental Assembly Header            *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+/*Imports */
+#include "mainHeader.h"
+#include "dataTypes.h"
+#include "symbolHash.h"
+#include "crossReference.h"
+#include "utils.h"
+
+/* Definitions */
+#define MAX_STATEMENT_WORDS 3            /* The first word of an instruction and up to two operand words */
+#define MAX_SYMBOL_OPERANDS 2            /* The direct operands of an instruction                        */
+#define MAX_SYMBOL_LENGTH (MAX_LABEL_SIZE_WITH_COLON + 1)
+#define INITIAL_RECORD_CAPACITY 64
+
+/* Type Definitions */
+/* What a line of the source is, as the first pass saw it */
+typedef enum {IGNORED_LINE, CODE_LINE, DATA_LINE, EXTERN_LINE, ENTRY_LINE, INVALID_LINE} LineKind;
+
+/* What a line may be to a macro, as seen on its own (see macro.h) */
+typedef enum {NO_MACRO_MARK, MACRO_START_MARK, MACRO_END_MARK, SINGLE_WORD_MARK} MacroMark;
+
+/* A direct operand of an instruction, its word is resolved from the address of its symbol */
+typedef struct {
+    char name[MAX_SYMBOL_LENGTH];  /* The symbol                                    Example: LIST */
+    int column;                    /* The column of the operand in the line (1 based)            */
+    unsigned wordIndex;            /* The word of the statement it is encoded in   (1 / 2)       */
+    Boolean isSource;              /* If it is the source operand, else the destination          */
+} SymbolOperand;
+
+/* The parse results of a line, kept until the line is edited */
+typedef struct {
+    char *text;                             /* The text of the line (without the newline)               */
+    unsigned index;                         /* The index of the line in the source (0 based)            */
+    LineKind kind;                          /* What the line is                                         */
+    Error err;                              /* The error of the line on its own (NO_ERROR if none)      */
+    int errorColumn;                        /* The column of #err (1 based)                             */
+    char symbol[MAX_LINE_LENGTH];           /* The label defined by the line, or the .extern / .entry operand */
+    int symbolColumn;                       /* The column of #symbol (1 based)                          */
+    LabelFeature feature;                   /* The feature of #symbol when the line defines it          */
+    Boolean definesSymbol;                  /* If the line defines #symbol (a label or an .extern)      */
+    unsigned codeWidth, dataWidth;          /* The number of words the line puts in each image          */
+    unsigned codeOffset, dataOffset;        /* Where they start (IC / DC before the line)               */
+    Word words[MAX_STATEMENT_WORDS];        /* The words of an instruction                              */
+    Word *data;                             /* The words of a data directive                            */
+    SymbolOperand operands[MAX_SYMBOL_OPERANDS]; /* The direct operands of an instruction              */
+    unsigned operandCount;                  /* The number of #operands                                  */
+    LineKind lexedKind;                     /* What the line is on its own (#kind, unless it's a macro line) */
+    MacroMark macroMark;                    /* What the line may be to a macro                          */
+    char macroName[MAX_LINE_LENGTH];        /* The macro it defines ("mcr NAME"), or its only word      */
+    Boolean isMacroLine;                    /* If it's a part of a macro definition or a use of a macro: */
+                                            /* its kind is IGNORED_LINE, it defines, refers to and puts  */
+                                            /* nothing (the language server doesn't expand macros)      */
+} SourceRecord;
+
+/* A place where a symbol is referred to */
+typedef struct {
+    ReferenceSite site;  /* The operand word and its line (the address of an .entry line is 0)  */
+    int column;          /* The column of the symbol in the line (1 based)                      */
+} SymbolUse;
+
+/* A growable list of records */
+typedef struct {
+    SourceRecord **records;  /* The records                          */
+    unsigned count;          /* The number of records in #records   */
+    unsigned capacity;       /* The number of records #records holds */
+} RecordList;
+
+/* A symbol of an incremental source, with the lines defining it and the lines referring to it */
+typedef struct {
+    char *name;              /* The name of the symbol                                                */
+    RecordList definitions;  /* The lines defining it (the first one in the source is the definition) */
+    RecordList uses;         /* The lines referring to it (once per operand, and the .entry lines)    */
+    Word word;               /* The operand word its uses were last resolved with                     */
+    Boolean isDefined;       /* If it was defined when its uses were last resolved                    */
+} IncrementalSymbol;
+
+/* A source assembled incrementally: every line keeps its parse results, so an edit re-lexes only the edited lines */
+typedef struct {
+    char *name;                      /* The name of the source (files it refers to are relative to it) */
+    RecordList lines;                /* The lines of the source, in order                              */
+    SymbolHash symbolIndices;        /* Maps a symbol name to its index in #symbols                    */
+    IncrementalSymbol *symbols;      /* The symbols (a symbol stays after its last line is removed)    */
+    unsigned symbolCount, symbolCapacity;
+    unsigned codeSize, dataSize;     /* The number of words in each image                              */
+    unsigned linesLexed;             /* The number of lines the last edit re-lexed                     */
+    unsigned wordsResolved;          /* The number of operand words the last edit re-resolved          */
+} IncrementalSource;
+
+/* Function Prototypes */
+/**
+ * This function initializes #source to an empty source named #name
+ * **/
+void initIncrementalSource(IncrementalSource *source, char *name);
+
+/**
+ * This function replaces #removed lines of #source from line #first with the #count lines in #texts.
+ * Only the new lines are lexed, the lines after them are shifted, and only the operand words referring to a
+ * symbol whose address changed are resolved again.
+ * **/
+void replaceSourceLines(IncrementalSource *source, unsigned first, unsigned removed, char **texts, unsigned count);
+
+/**
+ * This function reports the diagnostics of #source to the diagnostics of the current file (see diagnostics.h)
+ * **/
+void reportIncrementalDiagnostics(IncrementalSource *source);
+
+/**
+ * This function returns the symbol at column #column (1 based) of line #index, with the column it starts at
+ * in #start
+ * @return The name of the symbol, or NULL if there's no symbol there
+ * **/
+char *getSymbolAt(IncrementalSource *source, unsigned index, int column, int *start);
+
+/**
+ * This function returns the line defining the symbol #name
+ * @return The record of the line, or NULL if #name isn't defined
+ * **/
+SourceRecord *getSymbolDefinition(IncrementalSource *source, char *name);
+
+/**
+ * This function puts the places referring to the symbol #name (operands and .entry lines, in line order) in
+ * a new array in #uses (free it when done)
+ * @return The number of places
+ * **/
+unsigned getSymbolUses(IncrementalSource *source, char *name, SymbolUse **uses);
+
+/**
+ * This function frees the memory held by #source
+ * **/
+void freeIncrementalSource(IncrementalSource *source);
+
+#endif
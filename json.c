@@ -0,0 +1,369 @@
+/*****************************************
+* JSON Operations                        *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include <ctype.h>
+#include "json.h"
+
+/* The text being parsed */
+typedef struct {
+    char *position;  /* The next character                       */
+    char *end;       /* The character after the last one         */
+    int depth;       /* The number of arrays / objects entered   */
+} JsonParser;
+
+/* Function Prototypes */
+static JsonValue *parseValue(JsonParser *parser);
+
+/* Functions */
+/**
+ * This function skips the white space at the position of #parser
+ * **/
+static void skipSpaces(JsonParser *parser) {
+    while (parser->position < parser->end && isspace((unsigned char) *parser->position))
+        ++parser->position;
+}
+
+/**
+ * This function returns a new value of type #type
+ * **/
+static JsonValue *newValue(JsonType type) {
+    JsonValue *value = (JsonValue *) calloc(1, sizeof(JsonValue));
+
+    if (value == NULL) {
+        perror("newValue");
+        exit(EXIT_FAILURE);
+    }
+    value->type = type;
+    return value;
+}
+
+/**
+ * This function returns the value of the hexadecimal digits at #digits (4 of them), or -1 if they're invalid
+ * **/
+static long readHexDigits(char *digits) {
+    long value = 0;
+    int i;
+
+    for (i = 0; i < 4; ++i) {
+        if (!isxdigit((unsigned char) digits[i]))
+            return -1;
+        value = value * 16 + (isdigit((unsigned char) digits[i]) ? digits[i] - '0' :
+                              tolower((unsigned char) digits[i]) - 'a' + 10);
+    }
+    return value;
+}
+
+/**
+ * This function parses the string at the position of #parser (after its opening quote)
+ * @return The unescaped string (UTF-8), or NULL if it is invalid
+ * **/
+static char *parseString(JsonParser *parser) {
+    TextBuffer buffer;
+    char encoded[4];
+    long code, low;
+
+    initTextBuffer(&buffer);
+    while (parser->position < parser->end && *parser->position != '\"') {
+        if (*parser->position != '\\') { /* A plain character */
+            appendChars(&buffer, parser->position++, 1);
+            continue;
+        }
+
+        if (++parser->position == parser->end)
+            break;
+        switch (*parser->position++) {
+            case '\"': appendChars(&buffer, "\"", 1); break;
+            case '\\': appendChars(&buffer, "\\", 1); break;
+            case '/':  appendChars(&buffer, "/", 1);  break;
+            case 'b':  appendChars(&buffer, "\b", 1); break;
+            case 'f':  appendChars(&buffer, "\f", 1); break;
+            case 'n':  appendChars(&buffer, "\n", 1); break;
+            case 'r':  appendChars(&buffer, "\r", 1); break;
+            case 't':  appendChars(&buffer, "\t", 1); break;
+            case 'u': /* A UTF-16 unit (a pair of them for the characters after U+FFFF) */
+                if (parser->end - parser->position < 4 || (code = readHexDigits(parser->position)) < 0) {
+                    freeTextBuffer(&buffer);
+                    return NULL;
+                }
+                parser->position += 4;
+                if (code >= 0xD800 && code < 0xDC00 && parser->end - parser->position >= 6 &&
+                    parser->position[0] == '\\' && parser->position[1] == 'u' &&
+                    (low = readHexDigits(parser->position + 2)) >= 0xDC00 && low < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    parser->position += 6;
+                }
+
+                /* Encode it in UTF-8 */
+                if (code < 0x80)
+                    encoded[0] = (char) code, appendChars(&buffer, encoded, 1);
+                else if (code < 0x800) {
+                    encoded[0] = (char) (0xC0 | (code >> 6));
+                    encoded[1] = (char) (0x80 | (code & 0x3F));
+                    appendChars(&buffer, encoded, 2);
+                } else if (code < 0x10000) {
+                    encoded[0] = (char) (0xE0 | (code >> 12));
+                    encoded[1] = (char) (0x80 | ((code >> 6) & 0x3F));
+                    encoded[2] = (char) (0x80 | (code & 0x3F));
+                    appendChars(&buffer, encoded, 3);
+                } else {
+                    encoded[0] = (char) (0xF0 | (code >> 18));
+                    encoded[1] = (char) (0x80 | ((code >> 12) & 0x3F));
+                    encoded[2] = (char) (0x80 | ((code >> 6) & 0x3F));
+                    encoded[3] = (char) (0x80 | (code & 0x3F));
+                    appendChars(&buffer, encoded, 4);
+                }
+                break;
+            default:
+                freeTextBuffer(&buffer);
+                return NULL;
+        }
+    }
+
+    /* The closing quote */
+    if (parser->position == parser->end) {
+        freeTextBuffer(&buffer);
+        return NULL;
+    }
+    ++parser->position;
+
+    appendChars(&buffer, "", 1);
+    return buffer.data;
+}
+
+/**
+ * This function parses the elements of an array, or the members of an object, into #value (after its opening
+ * bracket)
+ * @return TRUE on success, else FALSE
+ * **/
+static Boolean parseChildren(JsonParser *parser, JsonValue *value) {
+    JsonValue **last = &value->children;
+    char closing = value->type == JSON_ARRAY ? ']' : '}', *key = NULL;
+
+    if (++parser->depth > MAX_JSON_DEPTH)
+        return FALSE;
+
+    skipSpaces(parser);
+    if (parser->position < parser->end && *parser->position == closing) { /* Empty */
+        ++parser->position;
+        --parser->depth;
+        return TRUE;
+    }
+
+    while (parser->position < parser->end) {
+        /* The key of a member, and its colon */
+        if (value->type == JSON_OBJECT) {
+            skipSpaces(parser);
+            if (parser->position == parser->end || *parser->position++ != '\"' ||
+                (key = parseString(parser)) == NULL)
+                return FALSE;
+            skipSpaces(parser);
+            if (parser->position == parser->end || *parser->position++ != ':') {
+                free(key);
+                return FALSE;
+            }
+        }
+
+        if ((*last = parseValue(parser)) == NULL) {
+            free(key);
+            return FALSE;
+        }
+        (*last)->key = key;
+        last = &(*last)->next;
+
+        /* A comma before the next child, or the end */
+        skipSpaces(parser);
+        if (parser->position == parser->end)
+            return FALSE;
+        if (*parser->position == closing) {
+            ++parser->position;
+            --parser->depth;
+            return TRUE;
+        }
+        if (*parser->position++ != ',')
+            return FALSE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * This function parses the value at the position of #parser
+ * @return The value, or NULL if it is invalid
+ * **/
+static JsonValue *parseValue(JsonParser *parser) {
+    JsonValue *value;
+    char *start;
+    size_t length;
+
+    skipSpaces(parser);
+    if (parser->position == parser->end)
+        return NULL;
+
+    start = parser->position;
+    switch (*parser->position) {
+        case '{':
+        case '[':
+            value = newValue(*parser->position++ == '{' ? JSON_OBJECT : JSON_ARRAY);
+            if (!parseChildren(parser, value)) {
+                freeJson(value);
+                return NULL;
+            }
+            return value;
+
+        case '\"':
+            ++parser->position;
+            value = newValue(JSON_STRING);
+            if ((value->text = parseString(parser)) == NULL) {
+                freeJson(value);
+                return NULL;
+            }
+            return value;
+
+        default:
+            break;
+    }
+
+    /* The literals */
+    length = (size_t) (parser->end - parser->position);
+    if (length >= 4 && strncmp(start, "null", 4) == 0)
+        return parser->position += 4, newValue(JSON_NULL);
+    if (length >= 4 && strncmp(start, "true", 4) == 0)
+        return parser->position += 4, newValue(JSON_TRUE);
+    if (length >= 5 && strncmp(start, "false", 5) == 0)
+        return parser->position += 5, newValue(JSON_FALSE);
+
+    /* A number, kept as it was written (and its integer part) */
+    if (*start == '-')
+        ++parser->position;
+    if (parser->position == parser->end || !isdigit((unsigned char) *parser->position))
+        return NULL;
+    while (parser->position < parser->end && (isdigit((unsigned char) *parser->position) ||
+                                              strchr(".eE+-", *parser->position) != NULL))
+        ++parser->position;
+
+    value = newValue(JSON_NUMBER);
+    length = (size_t) (parser->position - start);
+    if ((value->text = (char *) malloc(length + 1)) == NULL) {
+        perror("parseValue");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(value->text, start, length);
+    value->text[length] = '\0';
+    value->number = strtol(value->text, NULL, 10);
+    return value;
+}
+
+JsonValue *parseJson(char *text, size_t length) {
+    JsonParser parser;
+    JsonValue *value;
+
+    parser.position = text;
+    parser.end = text + length;
+    parser.depth = 0;
+
+    /* Nothing but white space may follow the value */
+    if ((value = parseValue(&parser)) != NULL) {
+        skipSpaces(&parser);
+        if (parser.position != parser.end) {
+            freeJson(value);
+            value = NULL;
+        }
+    }
+
+    return value;
+}
+
+JsonValue *getJsonMember(JsonValue *value, char *path) {
+    JsonValue *child;
+    size_t length;
+
+    while (value != NULL && *path) {
+        /* The key up to the next dot */
+        length = strchr(path, '.') ? (size_t) (strchr(path, '.') - path) : strlen(path);
+        if (value->type != JSON_OBJECT)
+            return NULL;
+
+        for (child = value->children; child; child = child->next)
+            if (strlen(child->key) == length && strncmp(child->key, path, length) == 0)
+                break;
+
+        value = child;
+        path += length;
+        if (*path == '.')
+            ++path;
+    }
+
+    return value;
+}
+
+char *getJsonString(JsonValue *value, char *path) {
+    value = getJsonMember(value, path);
+    return value != NULL && value->type == JSON_STRING ? value->text : NULL;
+}
+
+long getJsonNumber(JsonValue *value, char *path, long fallback) {
+    value = getJsonMember(value, path);
+    return value != NULL && value->type == JSON_NUMBER ? value->number : fallback;
+}
+
+void appendJsonString(TextBuffer *buffer, char *str) {
+    char escaped[8];
+
+    appendChars(buffer, "\"", 1);
+    for (; *str; ++str) {
+        if (*str == '\"' || *str == '\\') {
+            escaped[0] = '\\', escaped[1] = *str;
+            appendChars(buffer, escaped, 2);
+        } else if ((unsigned char) *str < 0x20) { /* A control character */
+            sprintf(escaped, "\\u%04x", (unsigned) *str);
+            appendString(buffer, escaped);
+        } else
+            appendChars(buffer, str, 1);
+    }
+    appendChars(buffer, "\"", 1);
+}
+
+void appendJsonValue(TextBuffer *buffer, JsonValue *value) {
+    JsonValue *child;
+
+    switch (value->type) {
+        case JSON_NULL:   appendString(buffer, "null");  break;
+        case JSON_FALSE:  appendString(buffer, "false"); break;
+        case JSON_TRUE:   appendString(buffer, "true");  break;
+        case JSON_NUMBER: appendString(buffer, value->text); break;
+        case JSON_STRING: appendJsonString(buffer, value->text); break;
+        case JSON_ARRAY:
+        case JSON_OBJECT:
+            appendString(buffer, value->type == JSON_ARRAY ? "[" : "{");
+            for (child = value->children; child; child = child->next) {
+                if (value->type == JSON_OBJECT) {
+                    appendJsonString(buffer, child->key);
+                    appendString(buffer, ":");
+                }
+                appendJsonValue(buffer, child);
+                if (child->next)
+                    appendString(buffer, ",");
+            }
+            appendString(buffer, value->type == JSON_ARRAY ? "]" : "}");
+            break;
+    }
+}
+
+void freeJson(JsonValue *value) {
+    JsonValue *child, *next;
+
+    if (value == NULL)
+        return;
+
+    for (child = value->children; child; child = next) {
+        next = child->next;
+        freeJson(child);
+    }
+    free(value->text);
+    free(value->key);
+    free(value);
+}
@@ -0,0 +1,72 @@
+/*****************************************
+* JSON Header                            *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef JSON_H
+#define JSON_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "textBuffer.h"
+
+/* Definitions */
+#define MAX_JSON_DEPTH 64
+
+/* Type Definitions */
+/* The types of JSON values */
+typedef enum {JSON_NULL, JSON_FALSE, JSON_TRUE, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT} JsonType;
+
+/* A parsed JSON value, the elements of an array and the members of an object are its children */
+typedef struct JsonValue {
+    JsonType type;                /* The type of the value                                          */
+    char *text;                   /* A string (unescaped), or a number as it was written           */
+    long number;                  /* The integer part of a number                                   */
+    char *key;                    /* The key of an object member (NULL otherwise)                   */
+    struct JsonValue *children;   /* The first element / member                                     */
+    struct JsonValue *next;       /* The next element / member of the parent                        */
+} JsonValue;
+
+/* Function Prototypes */
+/**
+ * This function parses the JSON text #text of #length characters
+ * @return The value, or NULL if #text isn't valid JSON
+ * **/
+JsonValue *parseJson(char *text, size_t length);
+
+/**
+ * This function returns the value at #path in #value, a path is the keys of nested members separated by dots
+ * ("params.textDocument.uri")
+ * @return The value, or NULL if it's missing
+ * **/
+JsonValue *getJsonMember(JsonValue *value, char *path);
+
+/**
+ * This function returns the string at #path in #value
+ * @return The string, or NULL if it's missing or isn't a string
+ * **/
+char *getJsonString(JsonValue *value, char *path);
+
+/**
+ * This function returns the number at #path in #value
+ * @return The number, or #fallback if it's missing or isn't a number
+ * **/
+long getJsonNumber(JsonValue *value, char *path, long fallback);
+
+/**
+ * This function appends #str to #buffer as a JSON string (quoted and escaped)
+ * **/
+void appendJsonString(TextBuffer *buffer, char *str);
+
+/**
+ * This function appends #value to #buffer as JSON text
+ * **/
+void appendJsonValue(TextBuffer *buffer, JsonValue *value);
+
+/**
+ * This function frees #value and everything in it
+ * **/
+void freeJson(JsonValue *value);
+
+#endif
@@ -0,0 +1,486 @@
+/*****************************************
+* Language Server Operations             *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "languageServer.h"
+#include "json.h"
+#include "textBuffer.h"
+#include "diagnostics.h"
+#include "utils.h"
+
+/* The open documents */
+static Document *documents = NULL;
+
+/* Functions */
+/**
+ * This function reads a message (its headers, then its content) from #in
+ * @return The content (#length characters, free it when done), or NULL when #in ends
+ * **/
+static char *readMessage(FILE *in, size_t *length) {
+    char header[MAX_HEADER_LENGTH], *content;
+    Boolean hasLength = FALSE;
+
+    /* The headers end with an empty line */
+    while (fgets(header, MAX_HEADER_LENGTH, in) != NULL) {
+        if (strcmp(header, "\r\n") == 0 || strcmp(header, "\n") == 0) {
+            if (hasLength)
+                break;
+            continue;
+        }
+        if (strncmp(header, CONTENT_LENGTH_HEADER, strlen(CONTENT_LENGTH_HEADER)) == 0) {
+            *length = (size_t) strtoul(header + strlen(CONTENT_LENGTH_HEADER), NULL, 10);
+            hasLength = TRUE;
+        }
+    }
+    if (!hasLength || feof(in))
+        return NULL;
+
+    if ((content = (char *) malloc(*length + 1)) == NULL) {
+        perror("readMessage");
+        exit(EXIT_FAILURE);
+    }
+    if (fread(content, 1, *length, in) != *length) {
+        free(content);
+        return NULL;
+    }
+    content[*length] = '\0';
+    return content;
+}
+
+/**
+ * This function writes #content to #out as a message
+ * **/
+static void sendMessage(FILE *out, TextBuffer *content) {
+    fprintf(out, "%s %lu\r\n\r\n", CONTENT_LENGTH_HEADER, (unsigned long) content->length);
+    writeTextBuffer(content, out);
+    fflush(out);
+}
+
+/**
+ * This function begins a response to the request #id in #content
+ * **/
+static void beginResponse(TextBuffer *content, JsonValue *id) {
+    appendString(content, "{\"jsonrpc\":\"2.0\",\"id\":");
+    if (id != NULL)
+        appendJsonValue(content, id);
+    else
+        appendString(content, "null");
+}
+
+/**
+ * This function sends the error #code with #message as the response to the request #id
+ * **/
+static void sendError(FILE *out, JsonValue *id, int code, char *message) {
+    TextBuffer content;
+    char number[MAX_HEADER_LENGTH];
+
+    initTextBuffer(&content);
+    beginResponse(&content, id);
+    sprintf(number, ",\"error\":{\"code\":%d,\"message\":", code);
+    appendString(&content, number);
+    appendJsonString(&content, message);
+    appendString(&content, "}}");
+    sendMessage(out, &content);
+    freeTextBuffer(&content);
+}
+
+/**
+ * This function appends a range on line #line (0 based) from column #start to column #end (1 based) to #content
+ * **/
+static void appendRange(TextBuffer *content, unsigned line, int start, int end) {
+    char range[MAX_HEADER_LENGTH];
+
+    sprintf(range, "{\"start\":{\"line\":%u,\"character\":%d},\"end\":{\"line\":%u,\"character\":%d}}",
+            line, start - 1, line, end - 1);
+    appendString(content, range);
+}
+
+/**
+ * This function appends the location of #length characters from column #column (1 based) of line #line
+ * (0 based) of #document to #content
+ * **/
+static void appendLocation(TextBuffer *content, Document *document, unsigned line, int column, int length) {
+    appendString(content, "{\"uri\":");
+    appendJsonString(content, document->uri);
+    appendString(content, ",\"range\":");
+    appendRange(content, line, column, column + length);
+    appendString(content, "}");
+}
+
+/**
+ * This function returns the open document #uri
+ * @return The document, or NULL if it isn't open
+ * **/
+static Document *findDocument(char *uri) {
+    Document *document;
+
+    for (document = documents; document && uri; document = document->next)
+        if (strcmp(document->uri, uri) == 0)
+            return document;
+
+    return NULL;
+}
+
+/**
+ * This function returns the path of the file #uri ("file:///src/a%20b.as" => "/src/a b.as")
+ * **/
+static char *getUriPath(char *uri) {
+    char *path = (char *) malloc(strlen(uri) + 1), *next = path, hex[3] = {0, 0, 0};
+
+    if (path == NULL) {
+        perror("getUriPath");
+        exit(EXIT_FAILURE);
+    }
+
+    if (strncmp(uri, FILE_URI_PREFIX, strlen(FILE_URI_PREFIX)) == 0)
+        uri += strlen(FILE_URI_PREFIX);
+
+    /* Decode the escaped characters */
+    for (; *uri; ++next)
+        if (*uri == '%' && isxdigit((unsigned char) uri[1]) && isxdigit((unsigned char) uri[2])) {
+            hex[0] = uri[1], hex[1] = uri[2];
+            *next = (char) strtol(hex, NULL, 16);
+            uri += 3;
+        } else
+            *next = *uri++;
+    *next = '\0';
+
+    return path;
+}
+
+/**
+ * This function replaces lines #first .. #last of #document (0 based, #last may be past the end) with the lines
+ * of #prefix, #text and #suffix put together
+ * **/
+static void replaceDocumentText(Document *document, unsigned first, unsigned last, char *prefix, char *text,
+                                char *suffix) {
+    TextBuffer joined;
+    char **lines, *line;
+    unsigned count = 1, i;
+
+    /* Put the text together, and split it into lines (without their '\r' / '\n') */
+    initTextBuffer(&joined);
+    appendString(&joined, prefix);
+    appendString(&joined, text);
+    appendString(&joined, suffix);
+    appendChars(&joined, "", 1);
+
+    for (line = joined.data; (line = strchr(line, '\n')) != NULL; ++line)
+        ++count;
+    if ((lines = (char **) malloc(count * sizeof(char *))) == NULL) {
+        perror("replaceDocumentText");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0, line = joined.data; i < count; ++i) {
+        lines[i] = line;
+        if ((line = strchr(line, '\n')) != NULL)
+            *line++ = '\0';
+        if (*lines[i] && lines[i][strlen(lines[i]) - 1] == '\r')
+            lines[i][strlen(lines[i]) - 1] = '\0';
+    }
+
+    replaceSourceLines(&document->source, first, last - first + 1, lines, count);
+
+    free(lines);
+    freeTextBuffer(&joined);
+}
+
+/**
+ * This function applies the change #change to #document (a range replaced by a text, or the whole text)
+ * **/
+static void applyChange(Document *document, JsonValue *change) {
+    char *text = getJsonString(change, "text"), *prefix, *suffix, *firstText;
+    long startLine, startCharacter, endLine, endCharacter;
+    RecordList *lines = &document->source.lines;
+
+    if (text == NULL)
+        return;
+
+    if (getJsonMember(change, "range") == NULL) { /* The whole text */
+        replaceDocumentText(document, 0, lines->count ? lines->count - 1 : 0, "", text, "");
+        return;
+    }
+
+    startLine = getJsonNumber(change, "range.start.line", 0);
+    startCharacter = getJsonNumber(change, "range.start.character", 0);
+    endLine = getJsonNumber(change, "range.end.line", 0);
+    endCharacter = getJsonNumber(change, "range.end.character", 0);
+    if (startLine < 0 || (unsigned long) startLine > lines->count || endLine < startLine || startCharacter < 0 ||
+        endCharacter < 0)
+        return;
+
+    /* The text before the range on its first line, and after it on its last line */
+    firstText = (unsigned long) startLine < lines->count ? lines->records[startLine]->text : "";
+    suffix = (unsigned long) endLine < lines->count ? lines->records[endLine]->text : "";
+    if ((size_t) startCharacter > strlen(firstText))
+        startCharacter = (long) strlen(firstText);
+    if ((size_t) endCharacter > strlen(suffix))
+        endCharacter = (long) strlen(suffix);
+    suffix += endCharacter;
+    if ((prefix = (char *) malloc((size_t) startCharacter + 1)) == NULL) {
+        perror("applyChange");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(prefix, firstText, (size_t) startCharacter);
+    prefix[startCharacter] = '\0';
+
+    replaceDocumentText(document, (unsigned) startLine, (unsigned) endLine, prefix, text, suffix);
+    free(prefix);
+}
+
+/**
+ * This function sends the diagnostics of #document
+ * **/
+static void publishDiagnostics(FILE *out, Document *document) {
+    TextBuffer content;
+    Diagnostic *diagnostics;
+    unsigned count, i;
+    char severity[MAX_HEADER_LENGTH];
+
+    /* The diagnostics module collects them, like it does for a file */
+    resetDiagnostics();
+    reportIncrementalDiagnostics(&document->source);
+    diagnostics = getDiagnostics(&count);
+
+    initTextBuffer(&content);
+    appendString(&content, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+    appendJsonString(&content, document->uri);
+    appendString(&content, ",\"diagnostics\":[");
+    for (i = 0; i < count; ++i) {
+        appendString(&content, i ? ",{\"range\":" : "{\"range\":");
+        appendRange(&content, (unsigned) diagnostics[i].lineNum - 1, diagnostics[i].column,
+                    (int) strlen(document->source.lines.records[diagnostics[i].lineNum - 1]->text) + 1);
+        sprintf(severity, ",\"severity\":%d,\"source\":\"assembler\",\"message\":",
+                diagnostics[i].severity == SEVERITY_ERROR ? DIAGNOSTIC_ERROR_SEVERITY : DIAGNOSTIC_WARNING_SEVERITY);
+        appendString(&content, severity);
+        appendJsonString(&content, getErrorMessage(diagnostics[i].err));
+        appendString(&content, "}");
+    }
+    appendString(&content, "]}}");
+    sendMessage(out, &content);
+    freeTextBuffer(&content);
+    resetDiagnostics();
+}
+
+/**
+ * This function logs how much a change re-assembled (#linesLexed lines lexed, #wordsResolved words resolved)
+ * **/
+static void logChange(FILE *out, unsigned linesLexed, unsigned wordsResolved) {
+    TextBuffer content;
+    char message[MAX_HEADER_LENGTH];
+
+    initTextBuffer(&content);
+    sprintf(message, "{\"jsonrpc\":\"2.0\",\"method\":\"window/logMessage\",\"params\":{\"type\":%d,\"message\":",
+            LOG_MESSAGE_TYPE);
+    appendString(&content, message);
+    sprintf(message, "%u lines lexed, %u operand words resolved", linesLexed, wordsResolved);
+    appendJsonString(&content, message);
+    appendString(&content, "}}");
+    sendMessage(out, &content);
+    freeTextBuffer(&content);
+}
+
+/**
+ * This function opens the document in #params
+ * **/
+static void openDocument(FILE *out, JsonValue *params) {
+    char *uri = getJsonString(params, "textDocument.uri"), *text = getJsonString(params, "textDocument.text");
+    Document *document;
+
+    if (uri == NULL || text == NULL || findDocument(uri) != NULL)
+        return;
+
+    if ((document = (Document *) malloc(sizeof(Document))) == NULL ||
+        (document->uri = (char *) malloc(strlen(uri) + 1)) == NULL) {
+        perror("openDocument");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(document->uri, uri);
+    document->path = getUriPath(uri);
+    initIncrementalSource(&document->source, document->path);
+    document->next = documents;
+    documents = document;
+
+    replaceDocumentText(document, 0, 0, "", text, "");
+    publishDiagnostics(out, document);
+}
+
+/**
+ * This function closes the document in #params (its diagnostics are cleared)
+ * **/
+static void closeDocument(FILE *out, JsonValue *params) {
+    Document **link, *document;
+    TextBuffer content;
+
+    for (link = &documents; *link; link = &(*link)->next)
+        if (strcmp((*link)->uri, getJsonString(params, "textDocument.uri") ?
+                                 getJsonString(params, "textDocument.uri") : "") == 0)
+            break;
+    if ((document = *link) == NULL)
+        return;
+    *link = document->next;
+
+    initTextBuffer(&content);
+    appendString(&content, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+    appendJsonString(&content, document->uri);
+    appendString(&content, ",\"diagnostics\":[]}}");
+    sendMessage(out, &content);
+    freeTextBuffer(&content);
+
+    freeIncrementalSource(&document->source);
+    free(document->path);
+    free(document->uri);
+    free(document);
+}
+
+/**
+ * This function answers a definition request (#isReferences off) or a references request (#isReferences on)
+ * about the symbol at the position in #params
+ * **/
+static void answerSymbolRequest(FILE *out, JsonValue *id, JsonValue *params, Boolean isReferences) {
+    Document *document = findDocument(getJsonString(params, "textDocument.uri"));
+    long line = getJsonNumber(params, "position.line", -1);
+    SourceRecord *definition = NULL;
+    SymbolUse *uses = NULL;
+    TextBuffer content;
+    unsigned count = 0, i;
+    JsonValue *includeDeclaration;
+    char *name = NULL;
+    int start;
+
+    if (document != NULL && line >= 0)
+        name = getSymbolAt(&document->source, (unsigned) line,
+                           (int) getJsonNumber(params, "position.character", -1) + 1, &start);
+    if (name != NULL) {
+        definition = getSymbolDefinition(&document->source, name);
+        if (isReferences)
+            count = getSymbolUses(&document->source, name, &uses);
+    }
+
+    initTextBuffer(&content);
+    beginResponse(&content, id);
+    appendString(&content, ",\"result\":");
+    if (!isReferences) { /* The location of the definition, or null */
+        if (definition != NULL)
+            appendLocation(&content, document, definition->index, definition->symbolColumn,
+                           (int) strlen(definition->symbol));
+        else
+            appendString(&content, "null");
+    } else { /* The locations of the uses, after the definition if it was asked for */
+        appendString(&content, "[");
+        includeDeclaration = getJsonMember(params, "context.includeDeclaration");
+        if (definition != NULL && includeDeclaration != NULL && includeDeclaration->type == JSON_TRUE) {
+            appendLocation(&content, document, definition->index, definition->symbolColumn,
+                           (int) strlen(definition->symbol));
+            if (count)
+                appendString(&content, ",");
+        }
+        for (i = 0; i < count; ++i) {
+            appendLocation(&content, document, (unsigned) uses[i].site.lineNum - 1, uses[i].column,
+                           (int) strlen(name));
+            if (i + 1 < count)
+                appendString(&content, ",");
+        }
+        appendString(&content, "]");
+    }
+    appendString(&content, "}");
+    sendMessage(out, &content);
+    freeTextBuffer(&content);
+    free(uses);
+}
+
+/**
+ * This function answers the initialize request #id with the capabilities of the server
+ * **/
+static void answerInitialize(FILE *out, JsonValue *id) {
+    TextBuffer content;
+    char capabilities[MAX_HEADER_LENGTH];
+
+    sprintf(capabilities, ",\"result\":{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":%d},"
+                          "\"definitionProvider\":true,\"referencesProvider\":true},"
+                          "\"serverInfo\":{\"name\":\"assembler\"}}}", INCREMENTAL_SYNC_KIND);
+    initTextBuffer(&content);
+    beginResponse(&content, id);
+    appendString(&content, capabilities);
+    sendMessage(out, &content);
+    freeTextBuffer(&content);
+}
+
+int runLanguageServer(FILE *in, FILE *out) {
+    JsonValue *message, *id, *params, *change;
+    TextBuffer content;
+    Document *document;
+    Boolean isShutDown = FALSE, hasExited = FALSE;
+    unsigned linesLexed, wordsResolved;
+    size_t length;
+    char *body, *method;
+
+    while (!hasExited && (body = readMessage(in, &length)) != NULL) {
+        message = parseJson(body, length);
+        free(body);
+        if (message == NULL) {
+            sendError(out, NULL, PARSE_ERROR_CODE, "Parse Error");
+            continue;
+        }
+
+        method = getJsonString(message, "method");
+        id = getJsonMember(message, "id");
+        params = getJsonMember(message, "params");
+
+        if (method == NULL) /* A response from the client, nothing was asked */
+            ;
+        else if (strcmp(method, "initialize") == 0)
+            answerInitialize(out, id);
+        else if (strcmp(method, "shutdown") == 0) {
+            isShutDown = TRUE;
+            initTextBuffer(&content);
+            beginResponse(&content, id);
+            appendString(&content, ",\"result\":null}");
+            sendMessage(out, &content);
+            freeTextBuffer(&content);
+        }
+        else if (strcmp(method, "exit") == 0)
+            hasExited = TRUE;
+        else if (strcmp(method, "textDocument/didOpen") == 0)
+            openDocument(out, params);
+        else if (strcmp(method, "textDocument/didChange") == 0) {
+            /* The changes are applied in order, only the lines they touch are lexed again */
+            if ((document = findDocument(getJsonString(params, "textDocument.uri"))) != NULL) {
+                change = getJsonMember(params, "contentChanges");
+                for (linesLexed = wordsResolved = 0, change = change ? change->children : NULL; change;
+                     change = change->next) {
+                    applyChange(document, change);
+                    linesLexed += document->source.linesLexed;
+                    wordsResolved += document->source.wordsResolved;
+                }
+                logChange(out, linesLexed, wordsResolved);
+                publishDiagnostics(out, document);
+            }
+        }
+        else if (strcmp(method, "textDocument/didClose") == 0)
+            closeDocument(out, params);
+        else if (strcmp(method, "textDocument/definition") == 0)
+            answerSymbolRequest(out, id, params, FALSE);
+        else if (strcmp(method, "textDocument/references") == 0)
+            answerSymbolRequest(out, id, params, TRUE);
+        else if (id != NULL) /* A request the server doesn't know (notifications are ignored) */
+            sendError(out, id, METHOD_NOT_FOUND_CODE, "Method Not Found");
+
+        freeJson(message);
+    }
+
+    /* Close what the client left open */
+    while (documents != NULL) {
+        document = documents;
+        documents = document->next;
+        freeIncrementalSource(&document->source);
+        free(document->path);
+        free(document->uri);
+        free(document);
+    }
+
+    return isShutDown && hasExited ? EXIT_SUCCESS : EXIT_FAILURE;
+}
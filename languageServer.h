@@ -0,0 +1,46 @@
+/*****************************************
+* Language Server Header                 *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef LANGUAGE_SERVER_H
+#define LANGUAGE_SERVER_H
+
+/*Imports */
+#include <stdio.h>
+#include "dataTypes.h"
+#include "incremental.h"
+
+/* Definitions */
+#define MAX_HEADER_LENGTH 256
+#define CONTENT_LENGTH_HEADER "Content-Length:"
+#define FILE_URI_PREFIX "file://"
+
+/* JSON-RPC / LSP codes */
+#define PARSE_ERROR_CODE (-32700)
+#define METHOD_NOT_FOUND_CODE (-32601)
+#define INCREMENTAL_SYNC_KIND 2
+#define DIAGNOSTIC_ERROR_SEVERITY 1
+#define DIAGNOSTIC_WARNING_SEVERITY 2
+#define LOG_MESSAGE_TYPE 4
+
+/* Type Definitions */
+/* A document opened in the editor */
+typedef struct Document {
+    char *uri;                  /* The URI of the document                   Example: file:///src/ps.as */
+    char *path;                 /* Its path (its .incbin files are relative to it)                      */
+    IncrementalSource source;   /* Its lines, assembled incrementally                                   */
+    struct Document *next;      /* A pointer to the next open document                                  */
+} Document;
+
+/* Function Prototypes */
+/**
+ * This function serves the Language Server Protocol on #in and #out: diagnostics (after every change),
+ * go to definition and find references, on documents synchronized incrementally.
+ * It returns when the client exits (or #in ends).
+ * @return The exit status (EXIT_SUCCESS if the client shut the server down before it exited)
+ * **/
+int runLanguageServer(FILE *in, FILE *out);
+
+#endif
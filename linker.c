@@ -0,0 +1,197 @@
+/*****************************************
+* Linker                                 *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "dataTypes.h"
+#include "objectFile.h"
+#include "symbolHash.h"
+#include "fileHandling.h"
+#include "firstPass.h"
+#include "secondPass.h"
+
+/* Definitions */
+#define DEFAULT_LINKED_NAME "linked"
+/* The highest address that fits in the value field of an operand word */
+#define MAX_LINKED_ADDRESS ((1U << (BITS_IN_WORD - ARE_OFFSET)) - 1)
+
+/* Functions */
+/**
+ * This function returns the address #address of #module after the module's code was moved to #codeBase
+ * and its data was moved to #dataBase
+ * **/
+unsigned relocateAddress(ObjectModule *module, unsigned address, unsigned codeBase, unsigned dataBase) {
+    /* Code addresses come first in a module, data addresses follow them */
+    if (address < module->codeWords + MEMORY_OFFSET)
+        return codeBase + (address - MEMORY_OFFSET);
+
+    return dataBase + (address - MEMORY_OFFSET - module->codeWords);
+}
+
+/**
+ * This function makes a relocatable operand word that points to #address
+ * **/
+Word makeRelocatableWord(unsigned address) {
+    Word w = (address << ARE_OFFSET) & WORD_MASK;
+
+    setARE(&w, RELOCATABLE);
+    return w;
+}
+
+int main(int argc, char **argv) {
+    char *outputName = DEFAULT_LINKED_NAME;
+    ObjectModule *modules;
+    unsigned *codeBases, *dataBases;
+    unsigned i, j, moduleCount = 0, totalCode = 0, totalData = 0, errors = 0;
+    unsigned codeOffset, dataOffset, address;
+    Word *linkedImage, *w;
+    SymbolHash globals;
+    SymbolHashNode *node;
+    long index;
+    FILE *file;
+
+    if (argc > 2 && strcmp(argv[1], "-o") == 0) { /* If an output name was given */
+        outputName = argv[2];
+        argc -= 2, argv += 2;
+    }
+
+    if (argc == 1) { /* If no module was given */
+        printf("No Module Was Given, Try The Command \"linker [-o out] x y\", Where x.obj and y.obj "
+               "Are Existing Object Files.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    modules   = (ObjectModule *) calloc(argc - 1, sizeof(ObjectModule));
+    codeBases = (unsigned *) calloc(argc - 1, sizeof(unsigned));
+    dataBases = (unsigned *) calloc(argc - 1, sizeof(unsigned));
+    if (modules == NULL || codeBases == NULL || dataBases == NULL) {
+        perror("linker");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Load all modules */
+    while (--argc > 0) {
+        if (loadObjectModule(*++argv, &modules[moduleCount])) {
+            totalCode += modules[moduleCount].codeWords;
+            totalData += modules[moduleCount].dataWords;
+            ++moduleCount;
+        } else
+            ++errors;
+    }
+
+    if (errors) {
+        printf("\nERRORS WERE ENCOUNTERED WHILE LOADING THE MODULES, NOTHING WAS LINKED\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* The linked image holds the code of all modules followed by the data of all modules */
+    if (totalCode + totalData + MEMORY_OFFSET > MAX_LINKED_ADDRESS + 1) {
+        printf("ERROR: The Linked Image Needs %u Words, But Only %u Are Addressable.\n",
+               totalCode + totalData, MAX_LINKED_ADDRESS + 1 - MEMORY_OFFSET);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Assign a base address to the code and the data of every module */
+    codeOffset = MEMORY_OFFSET, dataOffset = MEMORY_OFFSET + totalCode;
+    for (i = 0; i < moduleCount; ++i) {
+        codeBases[i] = codeOffset, dataBases[i] = dataOffset;
+        codeOffset += modules[i].codeWords, dataOffset += modules[i].dataWords;
+    }
+
+    /* Build the global symbol table from the entry symbols of all modules */
+    initSymbolHash(&globals, totalCode + totalData);
+    for (i = 0; i < moduleCount; ++i)
+        for (j = 0; j < modules[i].entryCount; ++j) {
+            address = relocateAddress(&modules[i], modules[i].entries[j].address, codeBases[i], dataBases[i]);
+            if ((node = insertSymbol(&globals, modules[i].entries[j].name, address, i)) != NULL) {
+                printf("ERROR: Duplicate Symbol %s, Defined In Module %s And In Module %s.\n",
+                       node->name, modules[node->owner].name, modules[i].name);
+                ++errors;
+            }
+        }
+
+    if ((linkedImage = (Word *) calloc(totalCode + totalData + 1, sizeof(Word))) == NULL) {
+        perror("linker");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < moduleCount; ++i) {
+        /* Copy the images of the module to their place */
+        memcpy(linkedImage + (codeBases[i] - MEMORY_OFFSET), modules[i].image, modules[i].codeWords * sizeof(Word));
+        memcpy(linkedImage + (dataBases[i] - MEMORY_OFFSET), modules[i].image + modules[i].codeWords,
+               modules[i].dataWords * sizeof(Word));
+
+        /* Relocate the relocatable words in the code image (data words have no ARE field) */
+        for (j = 0; j < modules[i].codeWords; ++j) {
+            w = &linkedImage[codeBases[i] - MEMORY_OFFSET + j];
+            if (getWordARE(*w) == RELOCATABLE)
+                *w = makeRelocatableWord(relocateAddress(&modules[i], *w >> ARE_OFFSET, codeBases[i], dataBases[i]));
+        }
+
+        /* Patch the words that use external symbols */
+        for (j = 0; j < modules[i].externCount; ++j) {
+            index = getImageIndex(&modules[i], modules[i].externs[j].address);
+            if (index < 0 || (unsigned) index >= modules[i].codeWords ||
+                getWordARE(modules[i].image[index]) != EXTERNAL) {
+                printf("ERROR: Module %s Has An Extern Record For %s In Address %u Which Is Not An External Word.\n",
+                       modules[i].name, modules[i].externs[j].name, modules[i].externs[j].address);
+                ++errors;
+                continue;
+            }
+
+            if ((node = findSymbol(&globals, modules[i].externs[j].name)) == NULL) {
+                printf("ERROR: Undefined Symbol %s, Referenced In Module %s In Address %u.\n",
+                       modules[i].externs[j].name, modules[i].name, modules[i].externs[j].address);
+                ++errors;
+                /* Nothing will be written, only mark the word as handled */
+                linkedImage[codeBases[i] - MEMORY_OFFSET + index] = makeRelocatableWord(0);
+                continue;
+            }
+
+            linkedImage[codeBases[i] - MEMORY_OFFSET + index] = makeRelocatableWord(node->value);
+        }
+
+        /* Every external word must have been patched */
+        for (j = 0; j < modules[i].codeWords; ++j)
+            if (getWordARE(linkedImage[codeBases[i] - MEMORY_OFFSET + j]) == EXTERNAL) {
+                printf("ERROR: Module %s Has An External Word In Address %u Without An Extern Record.\n",
+                       modules[i].name, j + MEMORY_OFFSET);
+                ++errors;
+            }
+    }
+
+    if (errors) {
+        printf("\n%u ERRORS WERE ENCOUNTERED WHILE LINKING, OUTPUT FILES WON'T BE CREATED\n", errors);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Create the linked object file */
+    if ((file = openFile(outputName, OBJ, "w")) == NULL) {
+        printf("ERROR: Couldn't Create The Object File Of %s.\n", outputName);
+        exit(EXIT_FAILURE);
+    }
+    writeObjectImage(file, linkedImage, totalCode, totalData);
+    fclose(file);
+
+    /* Create the entry file of the linked image (all global symbols) */
+    if (globals.size && (file = openFile(outputName, ENT, "w")) != NULL) {
+        for (i = 0; i < moduleCount; ++i)
+            for (j = 0; j < modules[i].entryCount; ++j)
+                fprintf(file, "%s\t%d\n", modules[i].entries[j].name,
+                        findSymbol(&globals, modules[i].entries[j].name)->value);
+        fclose(file);
+    }
+
+    printf("Linked %u Modules Into %s (%u Code Words, %u Data Words, %u Global Symbols).\n",
+           moduleCount, outputName, totalCode, totalData, globals.size);
+
+    /* Free everything */
+    for (i = 0; i < moduleCount; ++i)
+        freeObjectModule(&modules[i]);
+    freeSymbolHash(&globals);
+    free(linkedImage), free(modules), free(codeBases), free(dataBases);
+
+    return EXIT_SUCCESS;
+}
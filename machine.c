@@ -0,0 +1,315 @@
+/*****************************************
+* Machine Emulation Operations           *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "dataTypes.h"
+#include "machine.h"
+#include "decoder.h"
+#include "firstPass.h"
+#include "secondPass.h"
+
+/* Functions */
+/**
+ * This function resolves an operand of mode #mode held in #operandWord into the fields of #record
+ * @return TRUE on success, FALSE if the operand points outside the memory
+ * **/
+static Boolean resolveOperand(Machine *machine, DispatchRecord *record, AddressingMode mode, Word operandWord,
+                              Boolean isSource) {
+    unsigned char kind = OPERAND_FIXED, reg = 0;
+    Word *cell = NULL;
+    unsigned address = 0;
+
+    switch (mode) {
+        case IMMEDIATE: /* The operand is a constant kept in the record */
+            if (isSource) {
+                record->srcValue = (Word) decodeOperandValue(operandWord) & WORD_MASK;
+                cell = &record->srcValue;
+            } else {
+                record->destValue = (Word) decodeOperandValue(operandWord) & WORD_MASK;
+                cell = &record->destValue;
+            }
+            break;
+
+        case DIRECT: /* The operand is a memory cell */
+            address = (operandWord & WORD_MASK) >> ARE_OFFSET;
+            if (address >= MEMORY_SIZE)
+                return FALSE;
+            cell = &machine->memory[address];
+            break;
+
+        case REGISTER_INDIRECT: /* The operand is found through a register at run time */
+            kind = OPERAND_INDIRECT;
+            reg = (unsigned char) decodeRegister(operandWord, isSource);
+            break;
+
+        case REGISTER_DIRECT: /* The operand is a register */
+            cell = &machine->registers[decodeRegister(operandWord, isSource)];
+            break;
+
+        case UNKNOWN_ADDRESSING_MODE:
+        default:
+            kind = OPERAND_NONE;
+            break;
+    }
+
+    if (isSource) {
+        record->srcKind = kind, record->src = cell, record->srcReg = reg;
+        record->srcAddress = (unsigned short) address;
+    } else {
+        record->destKind = kind, record->dest = cell, record->destReg = reg;
+        record->destAddress = (unsigned short) address;
+        record->destInCode = BOOLEANIZE(record->writesDest && mode == DIRECT && address < machine->codeEnd);
+    }
+    return TRUE;
+}
+
+Boolean decodeDispatchRecord(Machine *machine, unsigned address) {
+    DecodedWord decoded;
+    DispatchRecord *record = &machine->records[address];
+    Boolean isSrcRegister, isDestRegister;
+    Word srcWord, destWord;
+
+    record->isValid = FALSE;
+    if (address >= MEMORY_SIZE || !decodeFirstWord(machine->memory[address], &decoded) ||
+        address + decoded.width > MEMORY_SIZE)
+        return FALSE;
+
+    record->inst  = (unsigned char) decoded.inst;
+    record->width = (unsigned char) decoded.width;
+    record->writesDest = BOOLEANIZE(decoded.inst != CMP_INST && decoded.inst != JMP_INST &&
+                                    decoded.inst != BNE_INST && decoded.inst != PRN_INST &&
+                                    decoded.inst != JSR_INST && decoded.inst != RTS_INST &&
+                                    decoded.inst != STOP_INST);
+
+    /* Find the word of each operand (two register operands share a single word) */
+    isSrcRegister  = BOOLEANIZE(decoded.srcMode  == REGISTER_INDIRECT || decoded.srcMode  == REGISTER_DIRECT);
+    isDestRegister = BOOLEANIZE(decoded.destMode == REGISTER_INDIRECT || decoded.destMode == REGISTER_DIRECT);
+    if (isSrcRegister && isDestRegister)
+        srcWord = destWord = machine->memory[address + 1];
+    else if (decoded.srcMode != UNKNOWN_ADDRESSING_MODE)
+        srcWord = machine->memory[address + 1], destWord = machine->memory[address + 2];
+    else
+        srcWord = 0, destWord = machine->memory[address + 1];
+
+    if (!resolveOperand(machine, record, decoded.srcMode, srcWord, TRUE) ||
+        !resolveOperand(machine, record, decoded.destMode, destWord, FALSE))
+        return FALSE;
+
+    record->isValid = TRUE;
+    return TRUE;
+}
+
+Boolean loadMachine(Machine *machine, ObjectModule *module) {
+    unsigned i, address;
+
+    if (module->codeWords + module->dataWords + MEMORY_OFFSET > MEMORY_SIZE) {
+        printf("ERROR: Module %s Doesn't Fit In The Memory.\n", module->name);
+        return FALSE;
+    }
+
+    /* Copy the image to its place in the memory */
+    memset(machine->loadedImage, 0, sizeof(machine->loadedImage));
+    memcpy(machine->loadedImage + MEMORY_OFFSET, module->image,
+           (module->codeWords + module->dataWords) * sizeof(Word));
+    machine->codeEnd = MEMORY_OFFSET + module->codeWords;
+
+    /* Only linked images can run */
+    if (module->externCount) {
+        printf("ERROR: Module %s Uses External Symbols, Link It Before Running It.\n", module->name);
+        return FALSE;
+    }
+
+    /* An external word without an extern record can't be resolved either */
+    for (i = 0; i < module->codeWords; ++i)
+        if (getState(module->image[i], EXTERNAL)) {
+            printf("ERROR: Module %s Has An Unresolved External Word In Address %u.\n", module->name,
+                   i + MEMORY_OFFSET);
+            return FALSE;
+        }
+
+    machine->codeModified = FALSE;
+    resetMachine(machine);
+
+    /* Pre-decode the code image, instruction after instruction */
+    memset(machine->records, 0, sizeof(machine->records));
+    for (address = MEMORY_OFFSET; address < machine->codeEnd; address += machine->records[address].width)
+        if (!decodeDispatchRecord(machine, address)) {
+            printf("ERROR: Module %s Has An Illegal Instruction In Address %u.\n", module->name, address);
+            return FALSE;
+        }
+
+    return TRUE;
+}
+
+void resetMachine(Machine *machine) {
+    unsigned address;
+
+    memcpy(machine->memory, machine->loadedImage, sizeof(machine->memory));
+    memset(machine->registers, 0, sizeof(machine->registers));
+    machine->pc = MEMORY_OFFSET;
+    machine->stackTop = 0;
+    machine->zeroFlag = FALSE;
+    machine->executed = 0;
+
+    /* Records decoded from code the program overwrote are stale now */
+    if (machine->codeModified)
+        for (address = MEMORY_OFFSET; address < machine->codeEnd; ++address)
+            machine->records[address].isValid = FALSE;
+    machine->codeModified = FALSE;
+}
+
+/**
+ * This function marks the records that may hold the code word in #address as stale
+ * **/
+static void invalidateCode(Machine *machine, unsigned address) {
+    unsigned first = address >= MAX_INSTRUCTION_WIDTH - 1 ? address - (MAX_INSTRUCTION_WIDTH - 1) : 0;
+
+    for (; first <= address; ++first)
+        machine->records[first].isValid = FALSE;
+    machine->codeModified = TRUE;
+}
+
+MachineState runMachine(Machine *machine, unsigned long maxSteps) {
+    Word *src, *dest, *memory = machine->memory, *registers = machine->registers;
+    DispatchRecord *record;
+    unsigned pc = machine->pc, address;
+    unsigned long steps;
+    MachineState state = MACHINE_RUNNING;
+    int c;
+
+    for (steps = 0; state == MACHINE_RUNNING; ++steps) {
+        if (maxSteps && steps == maxSteps) {
+            state = MACHINE_STEP_LIMIT;
+            break;
+        }
+
+        /* Fetch the dispatch record (decode it if it was never decoded or went stale) */
+        record = &machine->records[pc];
+        if (!record->isValid && !decodeDispatchRecord(machine, pc)) {
+            state = MACHINE_ILLEGAL_INSTRUCTION;
+            break;
+        }
+
+        /* Reach the operands */
+        src = record->src, dest = record->dest;
+        if (record->srcKind == OPERAND_INDIRECT) {
+            if ((address = registers[record->srcReg]) >= MEMORY_SIZE) {
+                state = MACHINE_BAD_ADDRESS;
+                break;
+            }
+            src = &memory[address];
+        }
+        if (record->destKind == OPERAND_INDIRECT) {
+            if ((address = registers[record->destReg]) >= MEMORY_SIZE) {
+                state = MACHINE_BAD_ADDRESS;
+                break;
+            }
+            dest = &memory[address];
+            if (record->writesDest && address < machine->codeEnd)
+                invalidateCode(machine, address);
+        } else if (record->destInCode)
+            invalidateCode(machine, record->destAddress);
+
+        pc += record->width;
+
+        /* Dispatch */
+        switch (record->inst) {
+            case MOV_INST:
+                *dest = *src;
+                break;
+            case CMP_INST:
+                machine->zeroFlag = BOOLEANIZE(((*src - *dest) & WORD_MASK) == 0);
+                break;
+            case ADD_INST:
+                *dest = (*dest + *src) & WORD_MASK;
+                break;
+            case SUB_INST:
+                *dest = (*dest - *src) & WORD_MASK;
+                break;
+            case LEA_INST:
+                *dest = record->srcAddress;
+                break;
+            case CLR_INST:
+                *dest = 0;
+                break;
+            case NOT_INST:
+                *dest = ~*dest & WORD_MASK;
+                break;
+            case INC_INST:
+                *dest = (*dest + 1) & WORD_MASK;
+                break;
+            case DEC_INST:
+                *dest = (*dest - 1) & WORD_MASK;
+                break;
+            case BNE_INST:
+                if (machine->zeroFlag)
+                    break;
+                /* Fall through (the branch is taken) */
+            case JMP_INST:
+                pc = record->destKind == OPERAND_INDIRECT ? registers[record->destReg] : record->destAddress;
+                break;
+            case RED_INST:
+                c = machine->input ? getc(machine->input) : EOF;
+                *dest = (Word) c & WORD_MASK;
+                break;
+            case PRN_INST:
+                if (machine->output)
+                    putc((int) (*dest & 0xFF), machine->output);
+                break;
+            case JSR_INST:
+                if (machine->stackTop == MAX_CALL_DEPTH) {
+                    state = MACHINE_STACK_OVERFLOW;
+                    pc -= record->width;
+                    break;
+                }
+                machine->stack[machine->stackTop++] = pc;
+                pc = record->destKind == OPERAND_INDIRECT ? registers[record->destReg] : record->destAddress;
+                break;
+            case RTS_INST:
+                if (machine->stackTop == 0) {
+                    state = MACHINE_STACK_UNDERFLOW;
+                    pc -= record->width;
+                    break;
+                }
+                pc = machine->stack[--machine->stackTop];
+                break;
+            case STOP_INST:
+            default:
+                state = MACHINE_HALTED;
+                break;
+        }
+
+        if (pc >= MEMORY_SIZE && state == MACHINE_RUNNING) {
+            state = MACHINE_BAD_ADDRESS;
+            ++steps;
+            break;
+        }
+    }
+
+    machine->pc = pc;
+    machine->executed += steps;
+    return state;
+}
+
+char *getMachineStateDescription(MachineState state) {
+    switch (state) {
+        case MACHINE_RUNNING:
+            return "Running";
+        case MACHINE_HALTED:
+            return "Halted";
+        case MACHINE_ILLEGAL_INSTRUCTION:
+            return "Illegal Instruction";
+        case MACHINE_BAD_ADDRESS:
+            return "Address Out Of Memory";
+        case MACHINE_STACK_OVERFLOW:
+            return "Call Stack Overflow";
+        case MACHINE_STACK_UNDERFLOW:
+            return "Return Without A Call";
+        case MACHINE_STEP_LIMIT:
+        default:
+            return "Step Limit Reached";
+    }
+}
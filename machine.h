@@ -0,0 +1,99 @@
+/*****************************************
+* Machine Emulation Header               *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef MACHINE_H
+#define MACHINE_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "objectFile.h"
+#include "externalVariables.h"
+
+/* Definitions */
+#define NUMBER_OF_REGISTERS 8
+#define MAX_CALL_DEPTH 1024
+
+/* Type Definitions */
+/* How an operand of a dispatch record is reached at run time */
+typedef enum {
+    OPERAND_NONE,     /* The instruction has no such operand                               */
+    OPERAND_FIXED,    /* The operand is always the same cell (a constant / memory / register) */
+    OPERAND_INDIRECT  /* The operand is the memory cell pointed to by a register            */
+} OperandKind;
+
+/* The state the machine stopped in */
+typedef enum {
+    MACHINE_RUNNING, MACHINE_HALTED, MACHINE_ILLEGAL_INSTRUCTION, MACHINE_BAD_ADDRESS,
+    MACHINE_STACK_OVERFLOW, MACHINE_STACK_UNDERFLOW, MACHINE_STEP_LIMIT
+} MachineState;
+
+/*
+ * A pre-decoded instruction. Every field of the first word and of the operand words is extracted once,
+ * and fixed operands are resolved to the cell they live in, so the interpreter loop only dispatches.
+ */
+typedef struct {
+    Word *src;                 /* The cell of a fixed source operand                  */
+    Word *dest;                /* The cell of a fixed destination operand             */
+    Word srcValue, destValue;  /* The values of immediate operands                    */
+    unsigned short srcAddress; /* The address of a direct source operand (for lea)    */
+    unsigned short destAddress;/* The address of a direct dest operand (for jumps)    */
+    unsigned char inst;        /* The instruction                                     */
+    unsigned char width;       /* The number of words of the instruction              */
+    unsigned char srcKind;     /* The OperandKind of the source operand               */
+    unsigned char destKind;    /* The OperandKind of the destination operand          */
+    unsigned char srcReg;      /* The register of an indirect source operand          */
+    unsigned char destReg;     /* The register of an indirect destination operand     */
+    unsigned char writesDest;  /* Whether if the instruction writes its destination   */
+    unsigned char destInCode;  /* Whether if a fixed destination written is in code   */
+    unsigned char isValid;     /* Whether if the record was decoded                   */
+} DispatchRecord;
+
+/* The state of the emulated machine */
+typedef struct {
+    Word memory[MEMORY_SIZE];               /* The memory of the machine                    */
+    Word loadedImage[MEMORY_SIZE];          /* The memory as it was loaded (for resetting)  */
+    Word registers[NUMBER_OF_REGISTERS];    /* r0 - r7                                      */
+    DispatchRecord records[MEMORY_SIZE];    /* The dispatch record of every code address    */
+    unsigned stack[MAX_CALL_DEPTH];         /* The return addresses of jsr                  */
+    unsigned stackTop;                      /* The number of return addresses in #stack     */
+    unsigned pc;                            /* The program counter                          */
+    unsigned codeEnd;                       /* The first address after the code image       */
+    Boolean zeroFlag;                       /* The Z flag of the PSW (set by cmp)           */
+    Boolean codeModified;                   /* Whether if the program wrote into its code   */
+    unsigned long executed;                 /* The number of instructions executed          */
+    FILE *input, *output;                   /* For red / prn (NULL to disable)              */
+} Machine;
+
+/* Function Prototypes */
+/**
+ * This function loads #module into #machine and pre-decodes its code image
+ * @return TRUE on success, FALSE if #module doesn't fit in memory or still has external words (an explanation is printed)
+ * **/
+Boolean loadMachine(Machine *machine, ObjectModule *module);
+
+/**
+ * This function returns #machine to the state it was right after loading
+ * **/
+void resetMachine(Machine *machine);
+
+/**
+ * This function decodes the instruction in #address into its dispatch record
+ * @return TRUE if the instruction is legal, else FALSE
+ * **/
+Boolean decodeDispatchRecord(Machine *machine, unsigned address);
+
+/**
+ * This function runs #machine until it stops, or until #maxSteps instructions were executed (0 for no limit)
+ * @return The state the machine stopped in
+ * **/
+MachineState runMachine(Machine *machine, unsigned long maxSteps);
+
+/**
+ * This function returns a description of a machine state
+ * **/
+char *getMachineStateDescription(MachineState state);
+
+#endif
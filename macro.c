@@ -0,0 +1,221 @@
+/*****************************************
+* Macro Operations                       *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "macro.h"
+#include "includeCache.h"
+#include "externalVariables.h"
+#include "symbolHash.h"
+#include "utils.h"
+
+/* Type Definitions */
+/* A macro of the source */
+typedef struct {
+    SourceFile body;            /* The lines of its body (with their line numbers and analyses)           */
+    IncludedLine *statements;   /* The analysis of the lines of the body, for the ones that had none yet  */
+} Macro;
+
+/* The macros of the source, and their indices by name */
+static Macro *macros = NULL;
+static unsigned macroCount = 0, macroCapacity = 0;
+static SymbolHash macroIndices = {NULL, 0, 0};
+
+/* The analysis of the definition lines that have an error, by the error */
+static IncludedLine invalidNameLine = {MACRO_STATEMENT, UNKNOWN_DIRECTIVE, "", NULL, 0, MACRO_NAME_INVALID};
+static IncludedLine existingNameLine = {MACRO_STATEMENT, UNKNOWN_DIRECTIVE, "", NULL, 0, MACRO_NAME_ALREADY_EXIST};
+static IncludedLine nestedLine = {MACRO_STATEMENT, UNKNOWN_DIRECTIVE, "", NULL, 0, MACRO_NESTED};
+static IncludedLine notEndedLine = {MACRO_STATEMENT, UNKNOWN_DIRECTIVE, "", NULL, 0, MACRO_NOT_ENDED};
+static IncludedLine invalidEndLine = {MACRO_STATEMENT, UNKNOWN_DIRECTIVE, "", NULL, 0, MACRO_END_INVALID};
+
+/* Functions */
+/**
+ * This function reads the first two words of #text into #first and #second
+ * @return The number of words of #text (up to 3, the rest aren't counted)
+ * **/
+static int readWords(char *text, char *first, char *second) {
+    char third[MAX_LINE_LENGTH];
+    int count = sscanf(text, "%s %s %s", first, second, third);
+
+    return count < 0 ? 0 : count;
+}
+
+/**
+ * This function appends the line #line to #to, with the analysis #included
+ * **/
+static void appendLine(SourceFile *to, SourceLine *line, IncludedLine *included) {
+    appendSourceLine(to, line->text, line->lineNum);
+    to->lines[to->count - 1].included = included;
+}
+
+/**
+ * This function appends the lines of the body of #macro to #to
+ * **/
+static void appendBody(SourceFile *to, Macro *macro) {
+    unsigned i;
+
+    for (i = 0; i < macro->body.count; ++i)
+        appendLine(to, macro->body.lines + i, macro->body.lines[i].included);
+}
+
+/**
+ * This function returns the macro named #name
+ * @return The macro, or NULL if no macro named #name was defined
+ * **/
+static Macro *findMacro(char *name) {
+    SymbolHashNode *node;
+
+    if (macroIndices.buckets == NULL || (node = findSymbol(&macroIndices, name)) == NULL)
+        return NULL;
+    return macros + node->value;
+}
+
+Boolean isLegalMacroName(char *name) {
+    int savedErrorCode = errorCode;
+    Boolean isLegal;
+
+    isLegal = BOOLEANIZE(isLegalLabelNoColon(name) && strcmp(name, MACRO_START) != 0 && strcmp(name, MACRO_END) != 0);
+    errorCode = savedErrorCode;
+    return isLegal;
+}
+
+/**
+ * This function starts the definition of the macro #name
+ * @return The error of the name (NO_ERROR if the macro was added)
+ * **/
+static Error beginMacro(char *name) {
+    Macro *tmp;
+
+    if (!isLegalMacroName(name))
+        return MACRO_NAME_INVALID;
+    if (findMacro(name) != NULL)
+        return MACRO_NAME_ALREADY_EXIST;
+
+    /* Grow the macros (by doubling) if needed */
+    if (macroCount == macroCapacity) {
+        macroCapacity = macroCapacity ? macroCapacity * 2 : INITIAL_MACRO_CAPACITY;
+        if ((tmp = (Macro *) realloc(macros, macroCapacity * sizeof(Macro))) == NULL) {
+            perror("beginMacro");
+            exit(EXIT_FAILURE);
+        }
+        macros = tmp;
+    }
+
+    if (macroIndices.buckets == NULL)
+        initSymbolHash(&macroIndices, MIN_HASH_BUCKETS);
+    insertSymbol(&macroIndices, name, macroCount, 0);
+    macros[macroCount].body.name = findSymbol(&macroIndices, name)->name; /* The name is kept by the index */
+    macros[macroCount].body.lines = NULL;
+    macros[macroCount].body.count = macros[macroCount].body.capacity = 0;
+    macros[macroCount].statements = NULL;
+    ++macroCount;
+    return NO_ERROR;
+}
+
+/**
+ * This function ends the definition of #macro: the lines of its body are analyzed, once for all its uses
+ * **/
+static void endMacro(Macro *macro) {
+    unsigned i;
+
+    if ((macro->statements = (IncludedLine *) malloc((macro->body.count ? macro->body.count : 1) *
+                                                     sizeof(IncludedLine))) == NULL) {
+        perror("endMacro");
+        exit(EXIT_FAILURE);
+    }
+
+    /* The lines of an included file were analyzed already */
+    for (i = 0; i < macro->body.count; ++i) {
+        macro->statements[i].words = NULL;
+        if (macro->body.lines[i].included == NULL) {
+            preanalyzeLine(macro->body.lines[i].text, macro->statements + i);
+            macro->body.lines[i].included = macro->statements + i;
+        }
+    }
+}
+
+void expandMacros(SourceFile *source) {
+    SourceFile expanded;
+    SourceLine *definition = NULL; /* The "mcr" line of the definition being read */
+    Macro *current = NULL;         /* The macro being defined (NULL while a definition with an error is skipped) */
+    Macro *used;
+    char first[MAX_LINE_LENGTH], second[MAX_LINE_LENGTH];
+    unsigned i;
+    int words;
+    Error err;
+
+    freeMacros();
+
+    /* Most sources have no macros */
+    for (i = 0; i < source->count && strstr(source->lines[i].text, MACRO_START) == NULL; ++i)
+        ;
+    if (i == source->count)
+        return;
+
+    expanded.name = source->name;
+    expanded.lines = NULL;
+    expanded.count = expanded.capacity = 0;
+    for (i = 0; i < source->count; ++i) {
+        words = readWords(source->lines[i].text, first, second);
+
+        if (words > 0 && strcmp(first, MACRO_START) == 0) { /* A definition starts */
+            if (definition != NULL) { /* Inside a definition, the line is dropped */
+                appendLine(&expanded, source->lines + i, &nestedLine);
+                continue;
+            }
+            definition = source->lines + i;
+            if ((err = words == 2 ? beginMacro(second) : MACRO_NAME_INVALID) == NO_ERROR)
+                current = macros + macroCount - 1;
+            else /* Its body is skipped */
+                appendLine(&expanded, source->lines + i, err == MACRO_NAME_INVALID ? &invalidNameLine :
+                                                                                    &existingNameLine);
+        }
+        else if (words > 0 && strcmp(first, MACRO_END) == 0) { /* A definition ends */
+            if (definition == NULL || words > 1)
+                appendLine(&expanded, source->lines + i, &invalidEndLine);
+            if (current != NULL)
+                endMacro(current);
+            definition = NULL;
+            current = NULL;
+        }
+        else if (words == 1 && (used = findMacro(first)) != NULL) { /* A use, in the source or in a body */
+            if (definition == NULL)
+                appendBody(&expanded, used);
+            else if (current != NULL)
+                appendBody(&current->body, used);
+        }
+        else if (definition == NULL)
+            appendLine(&expanded, source->lines + i, source->lines[i].included);
+        else if (current != NULL)
+            appendLine(&current->body, source->lines + i, source->lines[i].included);
+    }
+
+    /* A definition that never ended is reported, its lines are dropped */
+    if (definition != NULL) {
+        appendLine(&expanded, definition, &notEndedLine);
+        if (current != NULL)
+            endMacro(current);
+    }
+
+    freeSourceFile(source);
+    *source = expanded;
+}
+
+void freeMacros() {
+    unsigned i, j;
+
+    for (i = 0; i < macroCount; ++i) {
+        for (j = 0; j < macros[i].body.count; ++j)
+            free(macros[i].statements[j].words);
+        free(macros[i].statements);
+        freeSourceFile(&macros[i].body);
+    }
+    free(macros);
+    macros = NULL;
+    macroCount = macroCapacity = 0;
+
+    if (macroIndices.buckets != NULL)
+        freeSymbolHash(&macroIndices);
+}
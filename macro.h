@@ -0,0 +1,41 @@
+/*****************************************
+* Macro Header                           *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef MACRO_H
+#define MACRO_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "sourceFile.h"
+
+/* Definitions */
+#define MACRO_START "mcr"        /* Starts a definition: "mcr NAME"   */
+#define MACRO_END "endmcr"       /* Ends it                           */
+#define INITIAL_MACRO_CAPACITY 16
+
+/* Function Prototypes */
+/**
+ * This function expands the macros of #source (call it before the file is assembled, after its includes are
+ * expanded): a definition, from a "mcr NAME" line to an "endmcr" line, is taken out of the lines, and every line
+ * holding only the name of a macro defined above it is replaced by the lines of its body. The lines of a body keep
+ * their own line numbers, so errors in them are reported where they are written. A body is kept once, with the
+ * analysis of its lines (see includeCache.h), so putting it again costs a copy of its lines.
+ * **/
+void expandMacros(SourceFile *source);
+
+/**
+ * This function checks if #name can name a macro: a legal label that isn't a reserved word (the words of the
+ * definition are reserved too). #errorCode is left as it was
+ * @return TRUE if it can, else FALSE
+ * **/
+Boolean isLegalMacroName(char *name);
+
+/**
+ * This function frees the macros of the last source expanded (the lines they were put in must not be used anymore)
+ * **/
+void freeMacros();
+
+#endif
@@ -0,0 +1,326 @@
+/*****************************************
+* Memory Tracker Operations              *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#define MEMORY_TRACKER_IMPLEMENTATION /* The allocations here are the standard ones */
+#include <string.h>
+#include "memoryTracker.h"
+
+#ifdef TRACK_MEMORY
+
+/* Definitions */
+#define UNCOUNTED_SITE MAX_MEMORY_SITES /* The site of a block allocated before the report started */
+
+/* Type Definitions */
+/* The header before every tracked block */
+typedef union {
+    struct {
+        size_t size;      /* The bytes asked for             */
+        unsigned site;    /* The index of the allocation site */
+    } block;
+    long double alignment; /* The block after it must be aligned for anything */
+} MemoryHeader;
+
+/* A line that allocates */
+typedef struct {
+    char *file;                  /* The source file of the line (NULL if the site is unused) */
+    int line;                    /* The line                                                 */
+    unsigned long allocations;   /* The blocks it allocated                                  */
+    unsigned long bytes;         /* The bytes it allocated                                   */
+    unsigned long liveBlocks;    /* The blocks it allocated that weren't freed yet           */
+    unsigned long liveBytes;     /* Their bytes                                              */
+} MemorySite;
+
+/* The memory of a file that was assembled */
+typedef struct {
+    char *name;                  /* The name of the file                                          */
+    unsigned long startBytes;    /* The live bytes when it started                                */
+    unsigned long peakBytes;     /* The most live bytes while it was assembled                    */
+    unsigned long endBytes;      /* The live bytes when it ended                                  */
+    unsigned long allocations;   /* The blocks allocated while it was assembled                   */
+    unsigned long bytes;         /* Their bytes                                                   */
+} MemoryFile;
+
+/* The sites (the first one counts the allocations that aren't told apart) */
+static MemorySite sites[MAX_MEMORY_SITES];
+static int isReporting = 0; /* Set before any thread starts, nothing is counted (or locked) until then */
+
+/* The totals */
+static unsigned long liveBytes = 0, liveBlocks = 0, peakBytes = 0;
+static unsigned long phasePeaks[MEMORY_PHASE_COUNT];
+static MemoryPhase currentPhase = READ_PHASE;
+
+/* The files */
+static MemoryFile *files = NULL;
+static unsigned fileCount = 0, fileCapacity = 0;
+static int isInFile = 0;
+
+/* The allocations of threads are accounted one at a time */
+static volatile int lock = 0;
+
+/* The names of the phases, ordered like MemoryPhase */
+static char *phaseNames[MEMORY_PHASE_COUNT] = {"read", "optimize", "first pass", "second pass", "output"};
+
+/* Functions */
+/**
+ * This function returns the index of the site of #line in #file (adding it if it's new)
+ * **/
+static unsigned findSite(char *file, int line) {
+    unsigned hash = (unsigned) line * 2654435761U, index, probes;
+    char *c;
+
+    for (c = file; *c; ++c)
+        hash = hash * 31 + (unsigned char) *c;
+
+    /* Open addressing, the first site is never probed */
+    for (probes = 0, index = hash & (MAX_MEMORY_SITES - 1); probes < MAX_MEMORY_SITES;
+         ++probes, index = (index + 1) & (MAX_MEMORY_SITES - 1)) {
+        if (index == 0)
+            continue;
+        if (sites[index].file == NULL) {
+            sites[index].file = file;
+            sites[index].line = line;
+            return index;
+        }
+        if (sites[index].line == line && strcmp(sites[index].file, file) == 0)
+            return index;
+    }
+
+    return 0; /* The table is full */
+}
+
+/**
+ * This function accounts #size bytes in a new block #header to the site of #line in #file (a block allocated
+ * before the report started is left uncounted, without taking the lock)
+ * **/
+static void addBlock(MemoryHeader *header, size_t size, char *file, int line) {
+    header->block.size = size;
+    header->block.site = UNCOUNTED_SITE;
+    if (!isReporting)
+        return;
+
+    while (__sync_lock_test_and_set(&lock, 1))
+        ;
+
+    header->block.site = findSite(file, line);
+    ++sites[header->block.site].allocations;
+    sites[header->block.site].bytes += size;
+    ++sites[header->block.site].liveBlocks;
+    sites[header->block.site].liveBytes += size;
+
+    /* The peaks: of the run, of the current phase and of the current file */
+    ++liveBlocks;
+    liveBytes += size;
+    if (liveBytes > peakBytes)
+        peakBytes = liveBytes;
+    if (liveBytes > phasePeaks[currentPhase])
+        phasePeaks[currentPhase] = liveBytes;
+    if (isInFile) {
+        ++files[fileCount - 1].allocations;
+        files[fileCount - 1].bytes += size;
+        if (liveBytes > files[fileCount - 1].peakBytes)
+            files[fileCount - 1].peakBytes = liveBytes;
+    }
+
+    __sync_lock_release(&lock);
+}
+
+/**
+ * This function removes the block #header from the accounting
+ * **/
+static void removeBlock(MemoryHeader *header) {
+    if (header->block.site == UNCOUNTED_SITE)
+        return;
+
+    while (__sync_lock_test_and_set(&lock, 1))
+        ;
+
+    --sites[header->block.site].liveBlocks;
+    sites[header->block.site].liveBytes -= header->block.size;
+    --liveBlocks;
+    liveBytes -= header->block.size;
+
+    __sync_lock_release(&lock);
+}
+
+void *trackedMalloc(size_t size, char *file, int line) {
+    MemoryHeader *header = (MemoryHeader *) malloc(sizeof(MemoryHeader) + size);
+
+    if (header == NULL)
+        return NULL;
+    addBlock(header, size, file, line);
+    return header + 1;
+}
+
+void *trackedCalloc(size_t count, size_t size, char *file, int line) {
+    MemoryHeader *header;
+
+    /* The total must not overflow */
+    if (size && count > ((size_t) -1 - sizeof(MemoryHeader)) / size)
+        return NULL;
+    if ((header = (MemoryHeader *) calloc(1, sizeof(MemoryHeader) + count * size)) == NULL)
+        return NULL;
+    addBlock(header, count * size, file, line);
+    return header + 1;
+}
+
+void *trackedRealloc(void *pointer, size_t size, char *file, int line) {
+    MemoryHeader *header, old;
+
+    if (pointer == NULL)
+        return trackedMalloc(size, file, line);
+
+    /* The block keeps its accounting until it's really moved (a failed realloc leaves it as it was) */
+    old = *((MemoryHeader *) pointer - 1);
+    if ((header = (MemoryHeader *) realloc((MemoryHeader *) pointer - 1, sizeof(MemoryHeader) + size)) == NULL)
+        return NULL;
+
+    /* A resized block counts as a new allocation of its new size, made by the line that resized it */
+    removeBlock(&old);
+    addBlock(header, size, file, line);
+    return header + 1;
+}
+
+void trackedFree(void *pointer) {
+    if (pointer == NULL)
+        return;
+
+    removeBlock((MemoryHeader *) pointer - 1);
+    free((MemoryHeader *) pointer - 1);
+}
+
+void startMemoryReport() {
+    isReporting = 1;
+}
+
+void enterMemoryPhase(MemoryPhase phase) {
+    if (!isReporting)
+        return;
+
+    while (__sync_lock_test_and_set(&lock, 1))
+        ;
+
+    /* The memory live when the phase starts is a part of its peak */
+    currentPhase = phase;
+    if (liveBytes > phasePeaks[phase])
+        phasePeaks[phase] = liveBytes;
+
+    __sync_lock_release(&lock);
+}
+
+void beginMemoryFile(char *name) {
+    MemoryFile *tmp;
+
+    if (!isReporting)
+        return;
+
+    while (__sync_lock_test_and_set(&lock, 1))
+        ;
+
+    /* Grow the files (by doubling) if needed */
+    if (fileCount == fileCapacity) {
+        fileCapacity = fileCapacity ? fileCapacity * 2 : 16;
+        if ((tmp = (MemoryFile *) realloc(files, fileCapacity * sizeof(MemoryFile))) == NULL) {
+            perror("beginMemoryFile");
+            exit(EXIT_FAILURE);
+        }
+        files = tmp;
+    }
+
+    memset(files + fileCount, 0, sizeof(MemoryFile));
+    if ((files[fileCount].name = (char *) malloc(strlen(name) + 1)) == NULL) {
+        perror("beginMemoryFile");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(files[fileCount].name, name);
+    files[fileCount].startBytes = files[fileCount].peakBytes = liveBytes;
+    ++fileCount;
+    isInFile = 1;
+
+    __sync_lock_release(&lock);
+}
+
+void endMemoryFile() {
+    if (isInFile)
+        files[fileCount - 1].endBytes = liveBytes;
+    isInFile = 0;
+}
+
+/**
+ * This function compares the sites #a and #b by the bytes they allocated, the most first (for qsort)
+ * **/
+static int compareSitesByBytes(const void *a, const void *b) {
+    const MemorySite *first = *(const MemorySite * const *) a, *second = *(const MemorySite * const *) b;
+
+    return (first->bytes < second->bytes) - (first->bytes > second->bytes);
+}
+
+/**
+ * This function writes the name of #site ("file:line") into #name
+ * **/
+static void getSiteName(MemorySite *site, char *name) {
+    if (site->file == NULL)
+        strcpy(name, "(other)");
+    else
+        sprintf(name, "%.*s:%d", MEMORY_SITE_NAME_LENGTH - 16, site->file, site->line);
+}
+
+void writeMemoryReport(FILE *file) {
+    MemorySite **sorted;
+    char name[MEMORY_SITE_NAME_LENGTH];
+    unsigned i, count = 0;
+    long growth;
+
+    if ((sorted = (MemorySite **) malloc(MAX_MEMORY_SITES * sizeof(MemorySite *))) == NULL) {
+        perror("writeMemoryReport");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < MAX_MEMORY_SITES; ++i)
+        if (sites[i].allocations > 0)
+            sorted[count++] = sites + i;
+    qsort(sorted, count, sizeof(MemorySite *), compareSitesByBytes);
+
+    fprintf(file, "\n******************************************\n");
+    fprintf(file, "MEMORY REPORT\n");
+    fprintf(file, "******************************************\n");
+    fprintf(file, "PEAK LIVE MEMORY: %lu BYTES\n", peakBytes);
+
+    fprintf(file, "\nPEAK LIVE MEMORY BY PHASE:\n");
+    for (i = 0; i < MEMORY_PHASE_COUNT; ++i)
+        fprintf(file, "  %-24s %12lu BYTES\n", phaseNames[i], phasePeaks[i]);
+
+    fprintf(file, "\nPEAK LIVE MEMORY BY FILE:\n");
+    fprintf(file, "  %-24s %12s %12s %10s %12s\n", "FILE", "PEAK BYTES", "ALLOCATED", "BLOCKS", "LEFT LIVE");
+    for (i = 0; i < fileCount; ++i) {
+        growth = (long) files[i].endBytes - (long) files[i].startBytes;
+        fprintf(file, "  %-24s %12lu %12lu %10lu %12ld\n", files[i].name, files[i].peakBytes, files[i].bytes,
+                files[i].allocations, growth);
+    }
+
+    fprintf(file, "\nALLOCATIONS BY SITE:\n");
+    fprintf(file, "  %-24s %10s %12s\n", "SITE", "BLOCKS", "BYTES");
+    for (i = 0; i < count; ++i) {
+        getSiteName(sorted[i], name);
+        fprintf(file, "  %-24s %10lu %12lu\n", name, sorted[i]->allocations, sorted[i]->bytes);
+    }
+
+    /* What is still allocated now was never freed */
+    fprintf(file, "\nLEAKS: %lu BLOCKS, %lu BYTES STILL ALLOCATED\n", liveBlocks, liveBytes);
+    for (i = 0; i < count; ++i)
+        if (sorted[i]->liveBlocks > 0) {
+            getSiteName(sorted[i], name);
+            fprintf(file, "  %-24s %10lu %12lu\n", name, sorted[i]->liveBlocks, sorted[i]->liveBytes);
+        }
+
+    free(sorted);
+}
+
+#else
+
+/* ISO C needs a declaration in every translation unit, even one that tracks nothing */
+typedef int MemoryTrackingIsOff;
+
+#endif
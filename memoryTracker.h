@@ -0,0 +1,83 @@
+/*****************************************
+* Memory Tracker Header                  *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+/*Imports */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Definitions */
+#define MAX_MEMORY_SITES 1024      /* The allocation sites told apart, a power of 2 (the rest are counted together) */
+#define MEMORY_SITE_NAME_LENGTH 64 /* The longest "file:line" of a site in the report                              */
+
+/* Type Definitions */
+/* The phases of assembling a file, the peak live memory of each one is reported */
+typedef enum {
+    READ_PHASE, OPTIMIZE_PHASE, FIRST_PASS_PHASE, SECOND_PASS_PHASE, OUTPUT_PHASE, MEMORY_PHASE_COUNT
+} MemoryPhase;
+
+#ifdef TRACK_MEMORY
+
+/* Function Prototypes */
+/**
+ * These functions allocate / free like the standard ones, and account the blocks to the line #line of #file
+ * that asked for them (the allocation macros below pass them)
+ * **/
+void *trackedMalloc(size_t size, char *file, int line);
+void *trackedCalloc(size_t count, size_t size, char *file, int line);
+void *trackedRealloc(void *pointer, size_t size, char *file, int line);
+void trackedFree(void *pointer);
+
+/**
+ * This function starts the accounting (call it before any thread starts). Until it's called, the tracked calls
+ * only keep the size of a block before it, they count nothing and take no lock, and the blocks they allocate are
+ * never counted
+ * **/
+void startMemoryReport();
+
+/**
+ * This function makes #phase the current phase, the allocations from now on are accounted to it
+ * **/
+void enterMemoryPhase(MemoryPhase phase);
+
+/**
+ * This function starts accounting the allocations to the file #name (until endMemoryFile)
+ * **/
+void beginMemoryFile(char *name);
+
+/**
+ * This function ends the accounting to the current file
+ * **/
+void endMemoryFile();
+
+/**
+ * This function writes the report to #file: the peak live memory in total, by phase and by file, the allocations
+ * by site, and the blocks that are still allocated (the leaks, when called at exit)
+ * **/
+void writeMemoryReport(FILE *file);
+
+/* Every allocation of a file that includes this header is tracked, by the line that makes it */
+#ifndef MEMORY_TRACKER_IMPLEMENTATION
+#define malloc(size) trackedMalloc((size), __FILE__, __LINE__)
+#define calloc(count, size) trackedCalloc((count), (size), __FILE__, __LINE__)
+#define realloc(pointer, size) trackedRealloc((pointer), (size), __FILE__, __LINE__)
+#define free(pointer) trackedFree(pointer)
+#endif
+
+#else
+
+/* Without TRACK_MEMORY the allocations are the standard ones, and the calls compile to nothing */
+#define startMemoryReport()
+#define enterMemoryPhase(phase)
+#define beginMemoryFile(name)
+#define endMemoryFile()
+#define writeMemoryReport(file)
+
+#endif
+
+#endif
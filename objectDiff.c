@@ -0,0 +1,581 @@
+/*****************************************
+* Object Output Comparison               *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#define _POSIX_C_SOURCE 200112L /* For sysconf, stat */
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "dataTypes.h"
+#include "objectFile.h"
+#include "decoder.h"
+#include "textBuffer.h"
+#include "firstPass.h"
+
+/* Definitions */
+#define MAX_DIFF_THREADS 64
+#define MAX_DIFF_LINE_LENGTH 512
+#define MAX_FIELDS_LENGTH 256
+#define MAX_FIELD_TEXT_LENGTH 48
+#define OBJECT_FILE_SUFFIX ".obj"
+#define INITIAL_NAME_CAPACITY 64
+
+/* Type Definitions */
+/* What a word of a code image holds, its changes are described by the fields it has */
+typedef enum {
+    FIRST_WORD,             /* The first word of an instruction                     */
+    VALUE_WORD,             /* An immediate / a direct operand                      */
+    SOURCE_REGISTER_WORD,   /* The register of the source operand                   */
+    DEST_REGISTER_WORD,     /* The register of the dest operand                     */
+    REGISTERS_WORD,         /* The registers of both operands, sharing a word       */
+    CODE_WORD,              /* A code word that isn't a part of a legal instruction */
+    DATA_WORD               /* A word of the data image                             */
+} WordRole;
+
+/* A growable list of module names */
+typedef struct {
+    char **names;        /* The names (each one allocated)    */
+    unsigned count;      /* The number of names in #names     */
+    unsigned capacity;   /* The number of names #names holds  */
+} NameList;
+
+/* The comparison of a module of the expected outputs with the same module of the actual outputs */
+typedef struct {
+    char *name;           /* The name of the module, as reported        Example: sub/ps */
+    char *expectedName;   /* The module in the expected outputs (NULL if it isn't there) */
+    char *actualName;     /* The module in the actual outputs (NULL if it isn't there)   */
+    TextBuffer report;    /* The differences found, a line for each one                  */
+    unsigned differences; /* The number of lines in #report                              */
+} ModuleComparison;
+
+/* The comparisons, taken by the threads one at a time */
+typedef struct {
+    ModuleComparison *comparisons;  /* The comparisons                              */
+    unsigned count;                 /* The number of comparisons                    */
+    unsigned next;                  /* The first comparison that wasn't taken yet   */
+    pthread_mutex_t lock;           /* Guards #next                                 */
+} ComparisonQueue;
+
+/* The name of every role of a word, ordered like WordRole */
+static char *roleNames[] = {
+    "first word", "operand", "source register", "dest register", "registers", "code word", "data word"
+};
+
+/* Functions */
+/**
+ * This function adds a difference to the report of #comparison: a line of #marker ("- ", "+ " or ""), the name of
+ * the module and #details (the name is appended as it is, it can be a path of any length)
+ * **/
+void reportDifference(ModuleComparison *comparison, char *marker, char *details) {
+    appendString(&comparison->report, marker);
+    appendString(&comparison->report, comparison->name);
+    appendString(&comparison->report, details);
+    appendChars(&comparison->report, "\n", 1);
+    ++comparison->differences;
+}
+
+/**
+ * This function puts the role of every code word of #module in #roles, by going over its instructions
+ * **/
+void getWordRoles(ObjectModule *module, unsigned char *roles) {
+    unsigned i, next;
+    Boolean isSrcRegister, isDestRegister;
+    DecodedWord decoded;
+
+    for (i = 0; i < module->codeWords; i += decoded.width) {
+        if (!decodeFirstWord(module->image[i], &decoded) || i + decoded.width > module->codeWords) {
+            roles[i] = CODE_WORD;
+            decoded.width = 1;
+            continue;
+        }
+        roles[i] = FIRST_WORD;
+
+        /* The operand words follow the first word as getOperandInstructionWidth defines them */
+        isSrcRegister  = BOOLEANIZE(decoded.srcMode  == REGISTER_INDIRECT || decoded.srcMode  == REGISTER_DIRECT);
+        isDestRegister = BOOLEANIZE(decoded.destMode == REGISTER_INDIRECT || decoded.destMode == REGISTER_DIRECT);
+        if (isSrcRegister && isDestRegister)
+            roles[i + 1] = REGISTERS_WORD;
+        else {
+            next = i + 1;
+            if (decoded.srcMode != UNKNOWN_ADDRESSING_MODE)
+                roles[next++] = isSrcRegister ? SOURCE_REGISTER_WORD : VALUE_WORD;
+            if (decoded.destMode != UNKNOWN_ADDRESSING_MODE)
+                roles[next] = isDestRegister ? DEST_REGISTER_WORD : VALUE_WORD;
+        }
+    }
+}
+
+/**
+ * This function appends "#field #expected -> #actual" to the list of changed fields #fields, if they differ
+ * **/
+void appendFieldChange(char *fields, char *field, char *expected, char *actual) {
+    if (strcmp(expected, actual) == 0)
+        return;
+
+    sprintf(fields + strlen(fields), "%s%s %s -> %s", *fields ? ", " : "", field, expected, actual);
+}
+
+/**
+ * This function appends the change of the register of #isSource from #expected to #actual to #fields
+ * **/
+void appendRegisterChange(char *fields, Word expected, Word actual, Boolean isSource) {
+    char expectedText[MAX_FIELD_TEXT_LENGTH], actualText[MAX_FIELD_TEXT_LENGTH];
+
+    sprintf(expectedText, "r%d", decodeRegister(expected, isSource));
+    sprintf(actualText, "r%d", decodeRegister(actual, isSource));
+    appendFieldChange(fields, isSource ? "source register" : "dest register", expectedText, actualText);
+}
+
+/**
+ * This function describes the change of a word with the role #role from #expected to #actual, field by field,
+ * in #fields
+ * **/
+void describeWordChange(WordRole role, Word expected, Word actual, char *fields) {
+    char expectedText[MAX_FIELD_TEXT_LENGTH], actualText[MAX_FIELD_TEXT_LENGTH];
+    DecodedWord expectedFields, actualFields;
+
+    *fields = '\0';
+    switch (role) {
+        case FIRST_WORD:
+            decodeFirstWord(expected, &expectedFields);
+            decodeFirstWord(actual, &actualFields);
+            appendFieldChange(fields, "opcode", getInstructionMnemonic(expectedFields.inst),
+                              getInstructionMnemonic(actualFields.inst));
+            appendFieldChange(fields, "source mode", getAddressingModeName(expectedFields.srcMode),
+                              getAddressingModeName(actualFields.srcMode));
+            appendFieldChange(fields, "dest mode", getAddressingModeName(expectedFields.destMode),
+                              getAddressingModeName(actualFields.destMode));
+            break;
+        case VALUE_WORD:
+            sprintf(expectedText, "%d", decodeOperandValue(expected));
+            sprintf(actualText, "%d", decodeOperandValue(actual));
+            appendFieldChange(fields, "value", expectedText, actualText);
+            break;
+        case REGISTERS_WORD:
+        case SOURCE_REGISTER_WORD:
+        case DEST_REGISTER_WORD:
+            if (role != DEST_REGISTER_WORD)
+                appendRegisterChange(fields, expected, actual, TRUE);
+            if (role != SOURCE_REGISTER_WORD)
+                appendRegisterChange(fields, expected, actual, FALSE);
+            break;
+        case DATA_WORD:
+            sprintf(expectedText, "%d", signExtendWord(expected));
+            sprintf(actualText, "%d", signExtendWord(actual));
+            appendFieldChange(fields, "value", expectedText, actualText);
+            break;
+        case CODE_WORD:
+        default:
+            break;
+    }
+
+    /* Every code word has an ARE field (data words are plain numbers) */
+    if (role != DATA_WORD)
+        appendFieldChange(fields, "ARE", getAREName(getWordARE(expected)), getAREName(getWordARE(actual)));
+
+    /* A change no field shows (or of a word without fields) is shown by the whole words */
+    if (*fields == '\0') {
+        sprintf(expectedText, "%05o", expected & WORD_MASK);
+        sprintf(actualText, "%05o", actual & WORD_MASK);
+        appendFieldChange(fields, "word", expectedText, actualText);
+    }
+}
+
+/**
+ * This function compares #count words of the images of #expected and #actual, from the indexes #expectedFirst
+ * and #actualFirst, and reports every word that changed (#roles holds the roles of the code words of #expected,
+ * NULL for data words)
+ * **/
+void compareWords(ModuleComparison *comparison, ObjectModule *expected, ObjectModule *actual,
+                  unsigned expectedFirst, unsigned actualFirst, unsigned count, unsigned char *roles) {
+    char line[MAX_DIFF_LINE_LENGTH], fields[MAX_FIELDS_LENGTH];
+    WordRole role;
+    unsigned i;
+
+    for (i = 0; i < count; ++i) {
+        if (expected->image[expectedFirst + i] == actual->image[actualFirst + i])
+            continue;
+
+        role = roles ? (WordRole) roles[expectedFirst + i] : DATA_WORD;
+        describeWordChange(role, expected->image[expectedFirst + i], actual->image[actualFirst + i], fields);
+        sprintf(line, ".obj %04u (%s): %s", expectedFirst + i + MEMORY_OFFSET, roleNames[role], fields);
+        reportDifference(comparison, "", line);
+    }
+}
+
+/**
+ * This function reports the words of a segment that only one of the images has (the #extra words after the
+ * #common words the segments share, from the address #address)
+ * **/
+void reportExtraWords(ModuleComparison *comparison, char *segment, unsigned address, unsigned extra,
+                      Boolean isExpected) {
+    char line[MAX_DIFF_LINE_LENGTH];
+
+    if (extra == 0)
+        return;
+
+    sprintf(line, ".obj %04u-%04u: %u %s words only in the %s outputs", address, address + extra - 1, extra, segment,
+            isExpected ? "expected" : "actual");
+    reportDifference(comparison, isExpected ? "- " : "+ ", line);
+}
+
+/**
+ * This function compares the images of #expected and #actual: the code images word by word, then the data images
+ * word by word (so a change in the size of the code image doesn't shift the data words that follow it)
+ * **/
+void compareImages(ModuleComparison *comparison, ObjectModule *expected, ObjectModule *actual) {
+    unsigned commonCode = expected->codeWords < actual->codeWords ? expected->codeWords : actual->codeWords;
+    unsigned commonData = expected->dataWords < actual->dataWords ? expected->dataWords : actual->dataWords;
+    unsigned char *roles = (unsigned char *) calloc(expected->codeWords + 1, 1); /* A byte for every code word */
+    char line[MAX_DIFF_LINE_LENGTH];
+
+    if (roles == NULL) {
+        perror("compareImages");
+        exit(EXIT_FAILURE);
+    }
+
+    if (expected->codeWords != actual->codeWords || expected->dataWords != actual->dataWords) {
+        sprintf(line, ".obj: %u code words, %u data words -> %u code words, %u data words", expected->codeWords,
+                expected->dataWords, actual->codeWords, actual->dataWords);
+        reportDifference(comparison, "", line);
+    }
+
+    getWordRoles(expected, roles);
+    compareWords(comparison, expected, actual, 0, 0, commonCode, roles);
+    reportExtraWords(comparison, "code", MEMORY_OFFSET + commonCode, expected->codeWords - commonCode, TRUE);
+    reportExtraWords(comparison, "code", MEMORY_OFFSET + commonCode, actual->codeWords - commonCode, FALSE);
+
+    compareWords(comparison, expected, actual, expected->codeWords, actual->codeWords, commonData, NULL);
+    reportExtraWords(comparison, "data", MEMORY_OFFSET + expected->codeWords + commonData,
+                     expected->dataWords - commonData, TRUE);
+    reportExtraWords(comparison, "data", MEMORY_OFFSET + actual->codeWords + commonData,
+                     actual->dataWords - commonData, FALSE);
+
+    free(roles);
+}
+
+/**
+ * This function compares two symbol records by their names, then by their addresses (for qsort)
+ * **/
+int compareSymbolRecords(const void *a, const void *b) {
+    const SymbolRecord *first = (const SymbolRecord *) a, *second = (const SymbolRecord *) b;
+    int result = strcmp(first->name, second->name);
+
+    return result ? result : (first->address > second->address) - (first->address < second->address);
+}
+
+/**
+ * This function compares the records of the entry / extern file #suffix of the two modules as sets, so only the
+ * records themselves matter and not their order. Entries are keyed by their names (an entry whose address
+ * changed is a change), extern usages by their names and addresses.
+ * **/
+void compareSymbols(ModuleComparison *comparison, char *suffix, SymbolRecord *expected, unsigned expectedCount,
+                    SymbolRecord *actual, unsigned actualCount, Boolean isKeyedByName) {
+    char line[MAX_DIFF_LINE_LENGTH], *marker;
+    unsigned i = 0, j = 0;
+    int order;
+
+    qsort(expected, expectedCount, sizeof(SymbolRecord), compareSymbolRecords);
+    qsort(actual, actualCount, sizeof(SymbolRecord), compareSymbolRecords);
+
+    /* Merge the sorted records, a record only one of them has is a difference */
+    while (i < expectedCount || j < actualCount) {
+        if (i == expectedCount)
+            order = 1;
+        else if (j == actualCount)
+            order = -1;
+        else
+            order = isKeyedByName ? strcmp(expected[i].name, actual[j].name) :
+                    compareSymbolRecords(expected + i, actual + j);
+
+        marker = order < 0 ? "- " : order > 0 ? "+ " : "";
+        if (order < 0)
+            sprintf(line, "%s: %s %04u", suffix, expected[i].name, expected[i].address);
+        else if (order > 0)
+            sprintf(line, "%s: %s %04u", suffix, actual[j].name, actual[j].address);
+        else if (expected[i].address != actual[j].address)
+            sprintf(line, "%s: %s %04u -> %04u", suffix, expected[i].name, expected[i].address, actual[j].address);
+        else
+            *line = '\0';
+
+        if (*line)
+            reportDifference(comparison, marker, line);
+        i += order <= 0;
+        j += order >= 0;
+    }
+}
+
+/**
+ * This function compares the module of #comparison in the expected outputs with the one in the actual outputs
+ * **/
+void compareModules(ModuleComparison *comparison) {
+    ObjectModule expected, actual;
+
+    initTextBuffer(&comparison->report);
+    comparison->differences = 0;
+
+    if (comparison->expectedName == NULL || comparison->actualName == NULL) {
+        reportDifference(comparison, comparison->expectedName ? "- " : "+ ",
+                         comparison->expectedName ? ": only in the expected outputs" : ": only in the actual outputs");
+        return;
+    }
+
+    /*
+     * A module that can't be loaded is a difference, the explanation goes before it in the report (the modules are
+     * compared by many threads, their reports are printed in order once they are done)
+     */
+    if (!loadReportedObjectModule(comparison->expectedName, &expected, &comparison->report)) {
+        reportDifference(comparison, "", ": the expected module can't be loaded");
+        return;
+    }
+    if (!loadReportedObjectModule(comparison->actualName, &actual, &comparison->report)) {
+        reportDifference(comparison, "", ": the actual module can't be loaded");
+        freeObjectModule(&expected);
+        return;
+    }
+
+    compareImages(comparison, &expected, &actual);
+    compareSymbols(comparison, ".ent", expected.entries, expected.entryCount, actual.entries, actual.entryCount,
+                   TRUE);
+    compareSymbols(comparison, ".ext", expected.externs, expected.externCount, actual.externs, actual.externCount,
+                   FALSE);
+
+    freeObjectModule(&expected);
+    freeObjectModule(&actual);
+}
+
+/**
+ * This function compares the modules of the queue #arg, taking the next one until none is left
+ * **/
+void *compareQueuedModules(void *arg) {
+    ComparisonQueue *queue = (ComparisonQueue *) arg;
+    unsigned index;
+
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        index = queue->next < queue->count ? queue->next++ : queue->count;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (index == queue->count)
+            return NULL;
+        compareModules(queue->comparisons + index);
+    }
+}
+
+/**
+ * This function returns #directory and #name joined by a '/' (just #name if #directory is empty), in a new string
+ * **/
+char *joinPath(char *directory, char *name) {
+    char *path = (char *) malloc(strlen(directory) + strlen(name) + 2);
+
+    if (path == NULL) {
+        perror("joinPath");
+        exit(EXIT_FAILURE);
+    }
+    if (*directory)
+        sprintf(path, "%s/%s", directory, name);
+    else
+        strcpy(path, name);
+    return path;
+}
+
+/**
+ * This function appends #name (an allocated string, kept by the list) to #list
+ * **/
+void appendName(NameList *list, char *name) {
+    char **tmp;
+
+    /* Grow the names (by doubling) if needed */
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : INITIAL_NAME_CAPACITY;
+        if ((tmp = (char **) realloc(list->names, list->capacity * sizeof(char *))) == NULL) {
+            perror("appendName");
+            exit(EXIT_FAILURE);
+        }
+        list->names = tmp;
+    }
+    list->names[list->count++] = name;
+}
+
+/**
+ * This function returns whether if #path is a directory
+ * **/
+Boolean isDirectory(char *path) {
+    struct stat info;
+
+    return BOOLEANIZE(stat(path, &info) == 0 && S_ISDIR(info.st_mode));
+}
+
+/**
+ * This function appends the modules (the .obj files) under the directory #relative of the tree #root to #list,
+ * by their paths relative to #root and without the suffix
+ * **/
+void collectModules(char *root, char *relative, NameList *list) {
+    char *directory = joinPath(root, relative), *child, *path;
+    size_t length, suffixLength = strlen(OBJECT_FILE_SUFFIX);
+    struct dirent *entry;
+    struct stat info;
+    DIR *dir;
+
+    if ((dir = opendir(directory)) == NULL) {
+        perror(directory);
+        free(directory);
+        return;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+
+        child = joinPath(relative, entry->d_name);
+        path = joinPath(root, child);
+        length = strlen(child);
+        if (stat(path, &info) != 0)
+            perror(path);
+        else if (S_ISDIR(info.st_mode))
+            collectModules(root, child, list);
+        else if (S_ISREG(info.st_mode) && length > suffixLength &&
+                 strcmp(child + length - suffixLength, OBJECT_FILE_SUFFIX) == 0) {
+            child[length - suffixLength] = '\0';
+            appendName(list, child);
+            child = NULL; /* Kept by the list */
+        }
+        free(child);
+        free(path);
+    }
+
+    closedir(dir);
+    free(directory);
+}
+
+/**
+ * This function compares two strings pointed to by #a and #b (for qsort)
+ * **/
+int compareNames(const void *a, const void *b) {
+    return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+/**
+ * This function pairs the modules of the trees #expectedRoot and #actualRoot by their relative paths
+ * @return The comparisons (their number is put in #count)
+ * **/
+ModuleComparison *pairModuleTrees(char *expectedRoot, char *actualRoot, unsigned *count) {
+    NameList expected = {NULL, 0, 0}, actual = {NULL, 0, 0};
+    ModuleComparison *comparisons;
+    unsigned i = 0, j = 0;
+    int order;
+
+    collectModules(expectedRoot, "", &expected);
+    collectModules(actualRoot, "", &actual);
+    qsort(expected.names, expected.count, sizeof(char *), compareNames);
+    qsort(actual.names, actual.count, sizeof(char *), compareNames);
+
+    if ((comparisons = (ModuleComparison *) calloc(expected.count + actual.count + 1,
+                                                   sizeof(ModuleComparison))) == NULL) {
+        perror("pairModuleTrees");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Merge the sorted names, a module only one of the trees has is compared with nothing */
+    for (*count = 0; i < expected.count || j < actual.count; ++*count) {
+        if (i == expected.count)
+            order = 1;
+        else if (j == actual.count)
+            order = -1;
+        else
+            order = strcmp(expected.names[i], actual.names[j]);
+
+        comparisons[*count].name = order <= 0 ? expected.names[i] : actual.names[j];
+        if (order <= 0)
+            comparisons[*count].expectedName = joinPath(expectedRoot, expected.names[i++]);
+        if (order >= 0) {
+            comparisons[*count].actualName = joinPath(actualRoot, actual.names[j]);
+            if (order == 0)
+                free(actual.names[j]); /* The name of the expected module names the comparison */
+            ++j;
+        }
+    }
+
+    free(expected.names);
+    free(actual.names);
+    return comparisons;
+}
+
+int main(int argc, char **argv) {
+    ComparisonQueue queue;
+    pthread_t threads[MAX_DIFF_THREADS];
+    long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned i, differentCount = 0;
+    Boolean isTree;
+
+    /* Read the options */
+    for (--argc, ++argv; argc > 2 && **argv == '-'; --argc, ++argv) {
+        if (strcmp(*argv, "-j") == 0)
+            threadCount = atol(*++argv), --argc;
+        else {
+            printf("Unknown Option %s.\n", *argv);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc != 2) {
+        printf("Try The Command \"objectDiff [-j threads] expected actual\", Where expected And actual Are Modules "
+               "(x For x.obj/x.ent/x.ext) Or Directories Of Them.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Two trees are compared module by module, two modules are compared alone */
+    isTree = BOOLEANIZE(isDirectory(argv[0]) && isDirectory(argv[1]));
+    if (isTree)
+        queue.comparisons = pairModuleTrees(argv[0], argv[1], &queue.count);
+    else {
+        if ((queue.comparisons = (ModuleComparison *) calloc(1, sizeof(ModuleComparison))) == NULL) {
+            perror("objectDiff");
+            exit(EXIT_FAILURE);
+        }
+        queue.comparisons->name = queue.comparisons->expectedName = argv[0];
+        queue.comparisons->actualName = argv[1];
+        queue.count = 1;
+    }
+    queue.next = 0;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    if (threadCount > MAX_DIFF_THREADS)
+        threadCount = MAX_DIFF_THREADS;
+    if (threadCount > (long) queue.count)
+        threadCount = (long) queue.count;
+    if (threadCount < 1)
+        threadCount = 1;
+
+    /* Compare (this thread takes modules too) */
+    for (i = 1; i < (unsigned) threadCount; ++i)
+        if (pthread_create(&threads[i], NULL, compareQueuedModules, &queue) != 0) {
+            perror("objectDiff");
+            exit(EXIT_FAILURE);
+        }
+    compareQueuedModules(&queue);
+    for (i = 1; i < (unsigned) threadCount; ++i)
+        pthread_join(threads[i], NULL);
+
+    /* Print the differences in the order of the modules */
+    for (i = 0; i < queue.count; ++i) {
+        writeTextBuffer(&queue.comparisons[i].report, stdout);
+        freeTextBuffer(&queue.comparisons[i].report);
+        differentCount += queue.comparisons[i].differences > 0;
+        if (isTree) {
+            free(queue.comparisons[i].name);
+            free(queue.comparisons[i].expectedName);
+            free(queue.comparisons[i].actualName);
+        }
+    }
+    printf("%u Of %u Modules Differ.\n", differentCount, queue.count);
+
+    pthread_mutex_destroy(&queue.lock);
+    free(queue.comparisons);
+
+    return differentCount ? EXIT_FAILURE : EXIT_SUCCESS;
+}
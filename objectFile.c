@@ -0,0 +1,195 @@
+/*****************************************
+* Object Module Loading Operations       *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "dataTypes.h"
+#include "objectFile.h"
+#include "fileHandling.h"
+#include "firstPass.h"
+#include "utils.h"
+
+/* Functions */
+int readSymbolRecords(FILE *file, SymbolRecord **records) {
+    char line[MAX_OBJECT_LINE_LENGTH], name[MAX_OBJECT_LINE_LENGTH];
+    unsigned address, count = 0, capacity = 0;
+    SymbolRecord *tmp;
+
+    *records = NULL;
+
+    /* Read the file line by line, each line is "<name>\t<address>" */
+    while (fgets(line, MAX_OBJECT_LINE_LENGTH, file)) {
+        if (isEmpty(line))
+            continue;
+
+        if (sscanf(line, "%80s %u", name, &address) != 2 || strlen(name) >= MAX_SYMBOL_NAME_LENGTH) {
+            free(*records);
+            *records = NULL;
+            return -1;
+        }
+
+        /* Grow the records array if needed */
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            if ((tmp = (SymbolRecord *) realloc(*records, capacity * sizeof(SymbolRecord))) == NULL) {
+                perror("readSymbolRecords");
+                exit(EXIT_FAILURE);
+            }
+            *records = tmp;
+        }
+
+        strcpy((*records)[count].name, name);
+        (*records)[count].address = address;
+        ++count;
+    }
+
+    return (int) count;
+}
+
+/**
+ * This function parses a line of the image ("<address>\t<octal word>") into #address and #value
+ * @return TRUE on success, else FALSE
+ * **/
+static Boolean parseImageLine(char *line, unsigned long *address, unsigned long *value) {
+    char *addressEnd, *valueEnd;
+
+    /* strtoul is used rather than sscanf, images can have millions of lines */
+    *address = strtoul(line, &addressEnd, 10);
+    *value = strtoul(addressEnd, &valueEnd, 8);
+
+    return BOOLEANIZE(addressEnd != line && valueEnd != addressEnd);
+}
+
+/**
+ * This function reports that the module #name can't be loaded: #before, #name and #after make the line, appended
+ * to #report (printed if #report is NULL)
+ * **/
+static void reportLoadError(TextBuffer *report, char *before, char *name, char *after) {
+    if (report == NULL) {
+        printf("%s%s%s\n", before, name, after);
+        return;
+    }
+
+    appendString(report, before);
+    appendString(report, name);
+    appendString(report, after);
+    appendChars(report, "\n", 1);
+}
+
+Boolean loadObjectModule(char *name, ObjectModule *module) {
+    return loadReportedObjectModule(name, module, NULL);
+}
+
+Boolean loadReportedObjectModule(char *name, ObjectModule *module, TextBuffer *report) {
+    FILE *file;
+    char line[MAX_OBJECT_LINE_LENGTH];
+    unsigned i, totalWords;
+    unsigned long address, value;
+    int count;
+
+    module->name = name;
+    module->image = NULL;
+    module->entries = module->externs = NULL;
+    module->entryCount = module->externCount = 0;
+
+    /* The object file is mandatory */
+    if ((file = openFile(name, OBJ, "r")) == NULL) {
+        reportLoadError(report, "ERROR: Couldn't Open The Object File Of Module ", name, ".");
+        return FALSE;
+    }
+
+    /* Read the header ("<code words>\t\t<data words>") */
+    if (!fgets(line, MAX_OBJECT_LINE_LENGTH, file) ||
+        sscanf(line, "%u %u", &module->codeWords, &module->dataWords) != 2) {
+        reportLoadError(report, "ERROR: The Object File Of Module ", name, " Has An Invalid Header.");
+        fclose(file);
+        return FALSE;
+    }
+
+    totalWords = module->codeWords + module->dataWords;
+    if ((module->image = (Word *) calloc(totalWords ? totalWords : 1, sizeof(Word))) == NULL) {
+        perror("loadObjectModule");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Read the image, each line is "<address>\t<octal word>" and addresses are consecutive */
+    for (i = 0; i < totalWords; ++i) {
+        if (!fgets(line, MAX_OBJECT_LINE_LENGTH, file) || !parseImageLine(line, &address, &value) ||
+            address != i + MEMORY_OFFSET) {
+            sprintf(line, " Is Malformed Near Word No. %u.", i + 1);
+            reportLoadError(report, "ERROR: The Object File Of Module ", name, line);
+            fclose(file);
+            freeObjectModule(module);
+            return FALSE;
+        }
+        module->image[i] = value & WORD_MASK;
+    }
+    fclose(file);
+
+    /* The entry and extern files are optional (they are not created when empty) */
+    if ((file = openFile(name, ENT, "r")) != NULL) {
+        count = readSymbolRecords(file, &module->entries);
+        fclose(file);
+        if (count < 0) {
+            reportLoadError(report, "ERROR: The Entry File Of Module ", name, " Is Malformed.");
+            freeObjectModule(module);
+            return FALSE;
+        }
+        module->entryCount = (unsigned) count;
+    }
+
+    if ((file = openFile(name, EXT, "r")) != NULL) {
+        count = readSymbolRecords(file, &module->externs);
+        fclose(file);
+        if (count < 0) {
+            reportLoadError(report, "ERROR: The Extern File Of Module ", name, " Is Malformed.");
+            freeObjectModule(module);
+            return FALSE;
+        }
+        module->externCount = (unsigned) count;
+    }
+
+    return TRUE;
+}
+
+void freeObjectModule(ObjectModule *module) {
+    free(module->image);
+    free(module->entries);
+    free(module->externs);
+
+    module->image = NULL;
+    module->entries = module->externs = NULL;
+    module->entryCount = module->externCount = 0;
+}
+
+long getImageIndex(ObjectModule *module, unsigned address) {
+    /* Addresses start at MEMORY_OFFSET */
+    if (address < MEMORY_OFFSET || address - MEMORY_OFFSET >= module->codeWords + module->dataWords)
+        return -1;
+
+    return (long) (address - MEMORY_OFFSET);
+}
+
+ARE getWordARE(Word w) {
+    /* Each ARE option is marked by its own bit */
+    if (getState(w, EXTERNAL))
+        return EXTERNAL;
+
+    if (getState(w, RELOCATABLE))
+        return RELOCATABLE;
+
+    return ABSOLUTE;
+}
+
+void writeObjectImage(FILE *file, Word *image, unsigned codeWords, unsigned dataWords) {
+    unsigned i;
+
+    /* Print the "header" of the object file */
+    fprintf(file, "%d\t\t%d\n", codeWords, dataWords);
+
+    /* Print the image, code words are followed by data words */
+    for (i = 0; i < codeWords + dataWords; ++i)
+        fprintf(file, "%04d\t%05o\n", i + MEMORY_OFFSET, image[i] & WORD_MASK);
+}
@@ -0,0 +1,78 @@
+/*****************************************
+* Object Module Loading Header           *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef OBJECT_FILE_H
+#define OBJECT_FILE_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "utils.h"
+#include "textBuffer.h"
+
+/* Definitions */
+#define MAX_OBJECT_LINE_LENGTH 81
+#define MAX_SYMBOL_NAME_LENGTH (MAX_LABEL_SIZE_WITH_COLON + 1)
+
+/* Type Definitions */
+/* A symbol record as it appears in an entry or an extern file (a name and an address) */
+typedef struct {
+    char name[MAX_SYMBOL_NAME_LENGTH]; /* The name of the symbol.                    Example: LIST */
+    unsigned address;                  /* The address of the symbol / of its usage.  Example: 137  */
+} SymbolRecord;
+
+/* An object module, as loaded from its .obj, .ent and .ext files */
+typedef struct {
+    char *name;                /* The name of the module (without a suffix)           */
+    unsigned codeWords;        /* Number of words in the code image                   */
+    unsigned dataWords;        /* Number of words in the data image                   */
+    Word *image;               /* The code image followed by the data image           */
+    SymbolRecord *entries;     /* The records of the entry file (could be NULL)       */
+    unsigned entryCount;       /* Number of records in #entries                       */
+    SymbolRecord *externs;     /* The records of the extern file (could be NULL)      */
+    unsigned externCount;      /* Number of records in #externs                       */
+} ObjectModule;
+
+/* Function Prototypes */
+/**
+ * This function loads the module #name (#name.obj, and #name.ent / #name.ext if they exist) into #module
+ * @return TRUE on success, FALSE if the object file is missing or malformed (an explanation is printed)
+ * **/
+Boolean loadObjectModule(char *name, ObjectModule *module);
+
+/**
+ * This function loads the module #name into #module like loadObjectModule, but the explanation of a failure is
+ * appended to #report (for callers on many threads, whose outputs must not interleave)
+ * @return TRUE on success, else FALSE
+ * **/
+Boolean loadReportedObjectModule(char *name, ObjectModule *module, TextBuffer *report);
+
+/**
+ * This function reads the symbol records of an entry / extern file #file into #records
+ * @return The number of records read, or -1 if the file is malformed
+ * **/
+int readSymbolRecords(FILE *file, SymbolRecord **records);
+
+/**
+ * This function frees the memory held by #module
+ * **/
+void freeObjectModule(ObjectModule *module);
+
+/**
+ * This function returns the index in the image of #module of the word in address #address (or -1 if out of range)
+ * **/
+long getImageIndex(ObjectModule *module, unsigned address);
+
+/**
+ * This function returns the ARE field of word #w
+ * **/
+ARE getWordARE(Word w);
+
+/**
+ * This function writes #count words of #image, in the object file format, to #file
+ * **/
+void writeObjectImage(FILE *file, Word *image, unsigned codeWords, unsigned dataWords);
+
+#endif
@@ -0,0 +1,411 @@
+/*****************************************
+* Peephole Optimizer Operations          *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "optimizer.h"
+#include "firstPass.h"
+#include "utils.h"
+#include "externalVariables.h"
+#include "diagnostics.h"
+#include "symbolHash.h"
+
+/* The description of each rule in the report */
+static char *ruleNames[NUMBER_OF_RULES] = {
+    "jmp / bne to the next instruction removed",
+    "mov of a register to itself removed",
+    "mov #0, x rewritten to clr x",
+    "add #1, x rewritten to inc x",
+    "sub #1, x rewritten to dec x"
+};
+
+/* Functions */
+/**
+ * This function frees the strings held by #statement
+ * **/
+static void freeStatement(Statement *statement) {
+    free(statement->label);
+    free(statement->src);
+    free(statement->dest);
+}
+
+/**
+ * This function reads the instruction statement in #text into #statement
+ * @return TRUE if #text is an instruction statement that the first pass accepts, else FALSE
+ * **/
+static Boolean readStatement(char *text, Statement *statement) {
+    char line[MAX_LINE_LENGTH];
+    Boolean isValid;
+
+    statement->label = statement->src = statement->dest = NULL;
+
+    /* Directives and lines with comma errors are left to the first pass */
+    if (isIgnorable(text) || hasTwoCommas(text) || startWithDot(text))
+        return FALSE;
+
+    /* Read the statement the way the first pass does (on a copy, the helpers may change it) */
+    strcpy(line, text);
+    errorCode = NO_ERROR;
+    statement->label = getLabel(line);
+    statement->inst = getInstruction(line);
+    statement->src = getFirstOperand(line);
+    statement->dest = getSecondOperand(line);
+    statement->srcMode = getAddressingModeFirstPass(statement->src);
+    statement->destMode = getAddressingModeFirstPass(statement->dest);
+
+    /* If there is only one operand its the dest one */
+    if (statement->dest == NULL) {
+        statement->dest = statement->src;
+        statement->destMode = statement->srcMode;
+        statement->src = NULL;
+        statement->srcMode = UNKNOWN_ADDRESSING_MODE;
+    }
+
+    isValid = BOOLEANIZE(errorCode == NO_ERROR && statement->inst != UNKNOWN_INST &&
+                         (statement->src != NULL) + (statement->dest != NULL) == getNumberOfOperands(statement->inst) &&
+                         hasCorrectAddressingModes(statement->inst, statement->srcMode, statement->destMode));
+    errorCode = NO_ERROR;
+
+    if (!isValid)
+        freeStatement(statement);
+    return isValid;
+}
+
+/**
+ * This function returns the index of the first instruction statement after line #i of #source
+ * @return The index, or the number of lines if there is none
+ * **/
+static unsigned getNextInstructionLine(SourceFile *source, unsigned i) {
+    /* Directives don't take place in the code image, the next instruction follows the current one */
+    for (++i; i < source->count; ++i)
+        if (!isIgnorable(source->lines[i].text) && !startWithDot(source->lines[i].text))
+            break;
+    return i;
+}
+
+/**
+ * This function returns whether if #dest, the operand of the jump at line #i of #source, is the label of the next
+ * instruction
+ * **/
+static Boolean isJumpToNextInstruction(SourceFile *source, unsigned i, char *dest) {
+    unsigned next = getNextInstructionLine(source, i);
+    char line[MAX_LINE_LENGTH], *label;
+    Boolean isNext;
+
+    if (next == source->count)
+        return FALSE;
+
+    strcpy(line, source->lines[next].text);
+    errorCode = NO_ERROR;
+    label = getLabel(line);
+    isNext = BOOLEANIZE(errorCode == NO_ERROR && label != NULL && strcmp(label, dest) == 0);
+    errorCode = NO_ERROR;
+
+    free(label);
+    return isNext;
+}
+
+/**
+ * This function returns the rule that applies to #statement (at line #i of #source)
+ * @return The rule, or NUMBER_OF_RULES if none applies
+ * **/
+static PeepholeRule getApplicableRule(SourceFile *source, unsigned i, Statement *statement) {
+    Boolean isSrcImmediate = BOOLEANIZE(statement->srcMode == IMMEDIATE);
+
+    switch (statement->inst) {
+        case JMP_INST:
+        case BNE_INST:
+            /* Removing the jump moves its label (if it has one), the jump is kept then */
+            if (statement->label == NULL && statement->destMode == DIRECT &&
+                isJumpToNextInstruction(source, i, statement->dest))
+                return JUMP_TO_NEXT_RULE;
+            break;
+        case MOV_INST:
+            if (statement->label == NULL && statement->srcMode == statement->destMode &&
+                (statement->srcMode == REGISTER_DIRECT || statement->srcMode == REGISTER_INDIRECT) &&
+                getRegister(statement->src) == getRegister(statement->dest))
+                return SELF_MOVE_RULE;
+            if (isSrcImmediate && getNumber(statement->src) == 0)
+                return MOVE_ZERO_RULE;
+            break;
+        /* Only cmp sets the zero flag, so the flags don't tell add / sub from inc / dec */
+        case ADD_INST:
+            if (isSrcImmediate && getNumber(statement->src) == 1)
+                return ADD_ONE_RULE;
+            break;
+        case SUB_INST:
+            if (isSrcImmediate && getNumber(statement->src) == 1)
+                return SUB_ONE_RULE;
+            break;
+        default:
+            break;
+    }
+
+    return NUMBER_OF_RULES;
+}
+
+/**
+ * This function returns the number of data words the data directive #text installs (it installs them in the data
+ * image and takes them back, like the first pass would install them)
+ * **/
+static unsigned getDataWords(char *text) {
+    char line[MAX_LINE_LENGTH];
+    unsigned start = dc, words;
+
+    strcpy(line, text);
+    switch (getDirective(line)) {
+        case DATA_DIR:
+            installNumbersFromLine(line);
+            break;
+        case STRING_DIR:
+            installStringFromLine(line);
+            break;
+        case INCBIN_DIR:
+            installBinaryFromLine(line);
+            break;
+        default:
+            break;
+    }
+
+    /* Take the words back, the first pass installs them */
+    words = dc - start;
+    dc = start;
+    dataWordsInstalled -= words;
+    errorCode = NO_ERROR;
+    return words;
+}
+
+/**
+ * This function returns the label of the .entry directive #text (in a new string)
+ * **/
+static char *getEntryOperand(char *text) {
+    char line[MAX_LINE_LENGTH], *entryLabel, *copy;
+
+    strcpy(line, text);
+    entryLabel =  strip(strstr(line, ".entry")); /* Go to the directive */
+    entryLabel += strlen(".entry"); /* skip it */
+    entryLabel =  removeNewLine(strip(entryLabel)); /* skip spaces and remove the new line */
+
+    if ((copy = (char *) malloc(strlen(entryLabel) + 1)) == NULL) {
+        perror("getEntryOperand");
+        exit(EXIT_FAILURE);
+    }
+    return strcpy(copy, entryLabel);
+}
+
+/**
+ * This function marks the block labeled #label (if there is one) as reached, and pushes it to #pending
+ * **/
+static void reachLabel(SymbolHash *labels, SourceBlock *blocks, unsigned *pending, unsigned *pendingCount,
+                       char *label) {
+    SymbolHashNode *node = label ? findSymbol(labels, label) : NULL;
+
+    if (node != NULL && !blocks[node->value].isReached) {
+        blocks[node->value].isReached = TRUE;
+        pending[(*pendingCount)++] = node->value;
+    }
+}
+
+/**
+ * This function splits #source into blocks (in #blocks, that holds a block for every line), the block of every
+ * line is put in #lineBlocks (-1 for lines that are in no block)
+ * @return The number of blocks, or -1 if a statement has an error (the first pass reports it)
+ * **/
+static int splitSourceBlocks(SourceFile *source, SourceBlock *blocks, int *lineBlocks) {
+    int count = 0, codeBlock = -1, dataBlock = -1, *current;
+    Statement statement;
+    Directive dir;
+    char line[MAX_LINE_LENGTH], *label;
+    unsigned i;
+
+    for (i = 0; i < source->count; ++i) {
+        lineBlocks[i] = -1;
+        if (isIgnorable(source->lines[i].text))
+            continue;
+
+        if (startWithDot(source->lines[i].text)) { /* A directive */
+            strcpy(line, source->lines[i].text);
+            if ((dir = getDirective(line)) != DATA_DIR && dir != STRING_DIR && dir != INCBIN_DIR)
+                continue; /* .entry / .extern lines are never removed */
+            errorCode = NO_ERROR;
+            label = getLabel(line);
+            if (errorCode != NO_ERROR)
+                return -1;
+            current = &dataBlock;
+        } else { /* An instruction */
+            if (!readStatement(source->lines[i].text, &statement))
+                return -1;
+            label = statement.label;
+            statement.label = NULL;
+            current = &codeBlock;
+        }
+
+        /* A label starts a new block of its kind, so does the first line of that kind */
+        if (label != NULL || *current < 0) {
+            *current = count++;
+            blocks[*current].label = label;
+            blocks[*current].isCode = BOOLEANIZE(current == &codeBlock);
+            blocks[*current].firstLine = i;
+            blocks[*current].isReached = FALSE;
+            blocks[*current].words = 0;
+        }
+        blocks[*current].lastLine = i;
+        lineBlocks[i] = *current;
+
+        if (current == &codeBlock) {
+            blocks[*current].words += 1 + getOperandInstructionWidth(statement.srcMode, statement.destMode);
+            blocks[*current].fallsThrough = BOOLEANIZE(statement.inst != JMP_INST && statement.inst != RTS_INST &&
+                                                       statement.inst != STOP_INST);
+            freeStatement(&statement);
+        } else
+            blocks[*current].words += getDataWords(source->lines[i].text);
+    }
+
+    return count;
+}
+
+void eliminateUnusedBlocks(SourceFile *source) {
+    SourceBlock *blocks = (SourceBlock *) malloc((source->count + 1) * sizeof(SourceBlock));
+    unsigned *pending = (unsigned *) malloc((source->count + 1) * sizeof(unsigned));
+    int *lineBlocks = (int *) malloc((source->count + 1) * sizeof(int));
+    unsigned i, j, b, pendingCount = 0, removedWords = 0;
+    int count, next;
+    char line[MAX_REPORT_LINE_LENGTH], *entryLabel;
+    SymbolHash labels;
+    Statement statement;
+
+    if (blocks == NULL || pending == NULL || lineBlocks == NULL) {
+        perror("eliminateUnusedBlocks");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((count = splitSourceBlocks(source, blocks, lineBlocks)) < 0) {
+        free(blocks);
+        free(pending);
+        free(lineBlocks);
+        return;
+    }
+
+    /* Map the labels to their blocks */
+    initSymbolHash(&labels, (unsigned) count);
+    for (b = 0; b < (unsigned) count; ++b)
+        if (blocks[b].label != NULL)
+            insertSymbol(&labels, blocks[b].label, b, 0);
+
+    /* The roots: the first code block, the data without a label, and the entry labels */
+    for (b = 0; b < (unsigned) count; ++b)
+        if (blocks[b].label == NULL) {
+            blocks[b].isReached = TRUE;
+            pending[pendingCount++] = b;
+        }
+    for (b = 0; b < (unsigned) count && !blocks[b].isCode; ++b)
+        ;
+    if (b < (unsigned) count && !blocks[b].isReached) {
+        blocks[b].isReached = TRUE;
+        pending[pendingCount++] = b;
+    }
+    for (i = 0; i < source->count; ++i)
+        if (!isIgnorable(source->lines[i].text) && strstr(source->lines[i].text, ".entry") != NULL &&
+            startWithDot(source->lines[i].text)) {
+            entryLabel = getEntryOperand(source->lines[i].text);
+            reachLabel(&labels, blocks, pending, &pendingCount, entryLabel);
+            free(entryLabel);
+        }
+
+    /* Go through the reached code blocks: their direct operands and the block they fall through to are reached */
+    while (pendingCount > 0) {
+        b = pending[--pendingCount];
+        if (!blocks[b].isCode)
+            continue;
+
+        for (j = blocks[b].firstLine; j <= blocks[b].lastLine; ++j)
+            if (lineBlocks[j] == (int) b && readStatement(source->lines[j].text, &statement)) {
+                if (statement.srcMode == DIRECT)
+                    reachLabel(&labels, blocks, pending, &pendingCount, statement.src);
+                if (statement.destMode == DIRECT)
+                    reachLabel(&labels, blocks, pending, &pendingCount, statement.dest);
+                freeStatement(&statement);
+            }
+
+        if (blocks[b].fallsThrough) {
+            for (next = (int) b + 1; next < count && !blocks[next].isCode; ++next)
+                ;
+            if (next < count && !blocks[next].isReached) {
+                blocks[next].isReached = TRUE;
+                pending[pendingCount++] = (unsigned) next;
+            }
+        }
+    }
+
+    /* Remove the blocks that weren't reached (the lines of the other blocks between their lines stay) */
+    reportText("\nUNUSED BLOCKS ELIMINATION:\n");
+    for (b = 0; b < (unsigned) count; ++b) {
+        if (!blocks[b].isReached) {
+            for (j = blocks[b].firstLine; j <= blocks[b].lastLine; ++j)
+                if (lineBlocks[j] == (int) b) {
+                    strcpy(source->lines[j].text, "\n");
+                    source->lines[j].included = NULL; /* The analysis of an included line no longer holds */
+                }
+
+            sprintf(line, "  removed %s %s: %u words\n", blocks[b].isCode ? "code" : "data", blocks[b].label,
+                    blocks[b].words);
+            reportText(line);
+            removedWords += blocks[b].words;
+        }
+        free(blocks[b].label);
+    }
+    sprintf(line, "  total: %u words saved\n", removedWords);
+    reportText(line);
+
+    freeSymbolHash(&labels);
+    free(blocks);
+    free(pending);
+    free(lineBlocks);
+}
+
+void optimizeSource(SourceFile *source) {
+    unsigned i, counts[NUMBER_OF_RULES] = {0}, saved[NUMBER_OF_RULES] = {0}, totalSaved = 0;
+    char *mnemonic = NULL, line[MAX_REPORT_LINE_LENGTH];
+    Statement statement;
+    PeepholeRule rule;
+    int before, after;
+
+    for (i = 0; i < source->count; ++i) {
+        if (!readStatement(source->lines[i].text, &statement))
+            continue;
+
+        if ((rule = getApplicableRule(source, i, &statement)) != NUMBER_OF_RULES) {
+            before = 1 + getOperandInstructionWidth(statement.srcMode, statement.destMode);
+            source->lines[i].included = NULL; /* The analysis of an included line no longer holds */
+
+            if (rule == JUMP_TO_NEXT_RULE || rule == SELF_MOVE_RULE) {
+                /* Remove the statement, the line stays (empty) */
+                strcpy(source->lines[i].text, "\n");
+                after = 0;
+            } else {
+                /* Rewrite it to the one operand instruction, with the same label and destination */
+                mnemonic = (rule == MOVE_ZERO_RULE) ? "clr" : (rule == ADD_ONE_RULE) ? "inc" : "dec";
+                sprintf(source->lines[i].text, "%s%s%s %s\n", statement.label ? statement.label : "",
+                        statement.label ? ": " : "", mnemonic, statement.dest);
+                after = 1 + getOperandInstructionWidth(UNKNOWN_ADDRESSING_MODE, statement.destMode);
+            }
+
+            ++counts[rule];
+            saved[rule] += before - after;
+            totalSaved += before - after;
+        }
+
+        freeStatement(&statement);
+    }
+
+    /* Report the savings of each rule */
+    reportText("\nPEEPHOLE OPTIMIZATION:\n");
+    for (rule = JUMP_TO_NEXT_RULE; rule < NUMBER_OF_RULES; ++rule) {
+        sprintf(line, "  %s: %u times, %u words saved\n", ruleNames[rule], counts[rule], saved[rule]);
+        reportText(line);
+    }
+    sprintf(line, "  total: %u words saved\n", totalSaved);
+    reportText(line);
+}
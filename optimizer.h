@@ -0,0 +1,57 @@
+/*****************************************
+* Peephole Optimizer Header              *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "sourceFile.h"
+
+/* Definitions */
+#define MAX_REPORT_LINE_LENGTH 128
+
+/* Type Definitions */
+/* The rewrites of the peephole optimizer */
+typedef enum {
+    JUMP_TO_NEXT_RULE = 0, SELF_MOVE_RULE, MOVE_ZERO_RULE, ADD_ONE_RULE, SUB_ONE_RULE, NUMBER_OF_RULES
+} PeepholeRule;
+
+/* A block of the source: the lines from a labeled statement up to the next one of the same kind (code / data) */
+typedef struct {
+    char *label;            /* The label the block starts with (NULL if it has none)                    */
+    Boolean isCode;         /* If the block is made of instructions, else of data directives            */
+    unsigned firstLine;     /* The index of the first line of the block                                 */
+    unsigned lastLine;      /* The index of the last line of the block                                  */
+    Boolean fallsThrough;   /* If the execution goes on to the next code block (no jmp / rts / stop)    */
+    Boolean isReached;      /* If the block is reached from a root                                      */
+    unsigned words;         /* The number of words the block takes                                      */
+} SourceBlock;
+
+/* An instruction statement of the source, as the first pass reads it */
+typedef struct {
+    char *label;               /* The label of the statement (NULL if it has none) */
+    Instruction inst;          /* The instruction                                  */
+    char *src, *dest;          /* The operands (NULL if missing)                   */
+    AddressingMode srcMode;    /* The addressing mode of the source operand        */
+    AddressingMode destMode;   /* The addressing mode of the destination operand   */
+} Statement;
+
+/* Function Prototypes */
+/**
+ * This function rewrites the instruction statements of #source to ones that are encoded in fewer words and do
+ * the same (the first pass then computes the labels from the rewritten source). A removed statement is left as
+ * an empty line, so the line numbers don't change.
+ * **/
+void optimizeSource(SourceFile *source);
+
+/**
+ * This function removes the code blocks and data items of #source that are not reached from the first
+ * instruction, an entry label or a direct operand of a reached code block (removed lines are left empty)
+ * **/
+void eliminateUnusedBlocks(SourceFile *source);
+
+#endif
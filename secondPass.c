@@ -12,6 +12,11 @@
 #include "secondPass.h"
 #include "externalVariables.h"
 #include "fileHandling.h"
+#include "sourceFile.h"
+#include "diagnostics.h"
+#include "crossReference.h"
+#include "includeCache.h"
+#include "trace.h"
 
 /* Functions */
 void installEntryLabelFromLine(char *line) {
@@ -43,13 +48,15 @@ Word makeOperandWordImmediate(unsigned val) {
     return operandWord;
 }
 
-Word makeOperandWordDirect(char *label) {
+Word makeOperandWordDirect(char *label, Boolean isSource) {
     Word operandWord = 0U; /* An empty word */
     LabelPointer node;
 
     if ((node = searchByName(&symbolTable, label)) != NULL) { /* if the label exist */
-        /* Set its value in the word */
+        /* Set its value in the word, and count the reference */
         operandWord = (node->value << ARE_OFFSET);
+        ++node->references;
+        addCrossReference(node, ic + MEMORY_OFFSET, currentLineNum, isSource);
         /* Set ARE */
         if (node->feature != EXTERN_FEATURE) /* If the feature is data/code */
             setARE(&operandWord, RELOCATABLE);
@@ -102,7 +109,7 @@ void installOperandWord(char *op, AddressingMode mode, Boolean isSource) {
         installWordInCode(makeOperandWordImmediate(getNumber(op)));
 
     else if (mode == DIRECT) /* Addressing mode 1 */
-        installWordInCode(makeOperandWordDirect(op));
+        installWordInCode(makeOperandWordDirect(op, isSource));
 
     else if (mode == REGISTER_DIRECT || mode == REGISTER_INDIRECT) /* Addressing modes 2/3 */
         installWordInCode(makeOperandWordSingleRegister(getRegister(op), isSource));
@@ -120,7 +127,7 @@ void analyzeLineSecondPass(char *line) {
         return;
 
     /* If the line is a non-entry directive */
-    if (dir == DATA_DIR || dir == STRING_DIR || dir == EXTERN_DIR)
+    if (dir == DATA_DIR || dir == STRING_DIR || dir == EXTERN_DIR || dir == INCBIN_DIR || dir == INCLUDE_DIR)
         return;
 
     /* If the line is an entry directive */
@@ -129,6 +136,10 @@ void analyzeLineSecondPass(char *line) {
         return;
     }
 
+    /* A check doesn't encode the operands (an unknown operand label isn't an error of the second pass anyway) */
+    if (isCheckMode)
+        return;
+
     /* Else, the line is an instruction */
     /* Get the operands */
     firstOperand  = getFirstOperand(line);
@@ -168,42 +179,62 @@ void analyzeLineSecondPass(char *line) {
     }
 }
 
-void secondPass(char *fileName, FILE *fp) {
-    int lineNum = 1;
+void secondPass(SourceFile *source) {
+    unsigned i;
     Boolean hadError = FALSE;
     char line[MAX_LINE_LENGTH];
 
-    printf("\n******************************************\n");
-    printf("STARTED SECOND PASS ON FILE %s.\n", fileName);
-    printf("******************************************\n");
+    reportText("\n******************************************\n");
+    reportText("STARTED SECOND PASS ON FILE ");
+    reportText(source->name);
+    reportText(".\n******************************************\n");
     /* Set ic to 0 */
     ic = 0;
-
-    /* Read fp line by line */
-    while (fgets(line, MAX_LINE_LENGTH, fp)) {
+    enterMemoryPhase(SECOND_PASS_PHASE);
+    traceBegin("secondPass", source->name);
+
+    /* Go through the source line by line (on a copy, the analysis changes the line) */
+    for (i = 0; i < source->count && !reachedErrorLimit(); ++i) {
+        if (source->lines[i].included != NULL && source->lines[i].included->kind != PLAIN_STATEMENT &&
+            source->lines[i].included->kind != INSTRUCTION_STATEMENT)
+            continue; /* The included .extern / data lines have nothing to resolve */
+        strcpy(line, source->lines[i].text);
+        currentLineNum = source->lines[i].lineNum;
         errorCode = NO_ERROR;
+        errorColumn = 0;
         analyzeLineSecondPass(line);
 
         if (errorCode != NO_ERROR) { /* If an error was encountered */
-            alertLineError(lineNum, errorCode);
+            alertLineError(source->lines[i].lineNum,
+                           errorColumn ? errorColumn : getStatementColumn(source->lines[i].text), errorCode);
             hadError = TRUE;
         }
-        ++lineNum;
     }
 
     /* If an error was encountered in the first pass, there's no need to continue to the second pass */
     if (hadError) {
-        printf("\n**********************************************************************\n");
-        printf("ERRORS WERE ENCOUNTERED DURING THE SECOND PASS, OUTPUT FILES "
+        if (reachedErrorLimit() && i < source->count)
+            reportText("\nTHE MAXIMAL NUMBER OF ERRORS WAS REACHED, THE REST OF THE FILE WASN'T CHECKED\n");
+        reportText("\n**********************************************************************\n");
+        reportText("ERRORS WERE ENCOUNTERED DURING THE SECOND PASS, OUTPUT FILES "
                "WON'T BE CREATED\n");
-        printf("**********************************************************************\n");
+        reportText("**********************************************************************\n");
+        traceEnd("secondPass");
         return;
     }
 
-    printf("\n******************************\n");
-    printf("SECOND PASS ENDED SUCCESSFULLY \n" );
-    printf("******************************\n"  );
+    reportText("\n******************************\n");
+    reportText("SECOND PASS ENDED SUCCESSFULLY \n" );
+    reportText("******************************\n"  );
+    traceEnd("secondPass");
+
+    /* A check writes nothing */
+    if (isCheckMode)
+        return;
 
     /* Create output files */
-    createOutputFiles(fileName);
-}
\ No newline at end of file
+    enterMemoryPhase(OUTPUT_PHASE);
+    traceBegin("createOutputFiles", source->name);
+    createOutputFiles(source->name);
+    traceEnd("createOutputFiles");
+}
\ No newline at end of file
@@ -9,6 +9,7 @@
 
 /*Imports */
 #include <stdio.h>
+#include "sourceFile.h"
 
 /* Definitions */
 #define ARE_OFFSET ((unsigned ) 3)
@@ -26,9 +27,9 @@
 void installEntryLabelFromLine(char *line);
 
 /**
- * This functions treats the second pass on file #fp
+ * This functions treats the second pass on #source
  * **/
-void secondPass(char *fileName, FILE *fp);
+void secondPass(SourceFile *source);
 
 /**
  * This functions treats a line in the second pass
@@ -36,9 +37,9 @@ void secondPass(char *fileName, FILE *fp);
 void analyzeLineSecondPass(char *line);
 
 /**
- * This functions make an operand word from a label
+ * This functions make an operand word from a label (the reference is recorded, #isSource tells which operand it is)
  * **/
-Word makeOperandWordDirect(char *label);
+Word makeOperandWordDirect(char *label, Boolean isSource);
 
 /**
  * This functions install an operand word in the memory
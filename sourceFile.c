@@ -0,0 +1,96 @@
+/*****************************************
+* Source File Operations                 *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "sourceFile.h"
+
+/* Functions */
+void appendSourceLine(SourceFile *source, char *text, int lineNum) {
+    SourceLine *tmp;
+
+    /* Grow the lines array (by doubling) if needed */
+    if (source->count == source->capacity) {
+        source->capacity = source->capacity ? source->capacity * 2 : INITIAL_SOURCE_CAPACITY;
+        if ((tmp = (SourceLine *) realloc(source->lines, source->capacity * sizeof(SourceLine))) == NULL) {
+            perror("appendSourceLine");
+            exit(EXIT_FAILURE);
+        }
+        source->lines = tmp;
+    }
+
+    strncpy(source->lines[source->count].text, text, MAX_LINE_LENGTH - 1);
+    source->lines[source->count].text[MAX_LINE_LENGTH - 1] = '\0';
+    source->lines[source->count].lineNum = lineNum;
+    source->lines[source->count].included = NULL;
+    ++source->count;
+}
+
+void readSourceFile(FILE *fp, char *name, SourceFile *source) {
+    char line[MAX_LINE_LENGTH];
+    int lineNum = 1;
+
+    source->name = name;
+    source->lines = NULL;
+    source->count = source->capacity = 0;
+
+    /* Read fp line by line */
+    while (fgets(line, MAX_LINE_LENGTH, fp))
+        appendSourceLine(source, line, lineNum++);
+}
+
+void readSourceText(char *text, size_t length, char *name, SourceFile *source) {
+    char line[MAX_LINE_LENGTH];
+    size_t position = 0, lineLength;
+    int lineNum = 1;
+
+    source->name = name;
+    source->lines = NULL;
+    source->count = source->capacity = 0;
+
+    /* Cut the lines like fgets does: through the '\n', or MAX_LINE_LENGTH - 1 characters if it's farther */
+    while (position < length) {
+        for (lineLength = 0; lineLength < MAX_LINE_LENGTH - 1 && position + lineLength < length;)
+            if (text[position + lineLength++] == '\n')
+                break;
+        memcpy(line, text + position, lineLength);
+        line[lineLength] = '\0';
+        appendSourceLine(source, line, lineNum++);
+        position += lineLength;
+    }
+}
+
+void copySourceFile(SourceFile *from, SourceFile *to) {
+    unsigned i;
+
+    to->name = from->name;
+    to->lines = NULL;
+    to->count = to->capacity = 0;
+
+    for (i = 0; i < from->count; ++i) {
+        appendSourceLine(to, from->lines[i].text, from->lines[i].lineNum);
+        to->lines[i].included = from->lines[i].included;
+    }
+}
+
+Boolean isSourceEqual(SourceFile *first, SourceFile *second) {
+    unsigned i;
+
+    if (first->count != second->count)
+        return FALSE;
+
+    /* The line numbers follow the lines, only the texts are compared */
+    for (i = 0; i < first->count; ++i)
+        if (strcmp(first->lines[i].text, second->lines[i].text) != 0)
+            return FALSE;
+
+    return TRUE;
+}
+
+void freeSourceFile(SourceFile *source) {
+    free(source->lines);
+    source->lines = NULL;
+    source->count = source->capacity = 0;
+}
@@ -0,0 +1,65 @@
+/*****************************************
+* Source File Header                     *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+/*Imports */
+#include "mainHeader.h"
+#include "dataTypes.h"
+
+/* Definitions */
+#define INITIAL_SOURCE_CAPACITY 64
+
+/* Type Definitions */
+/* A line of the source, as read by fgets */
+typedef struct {
+    char text[MAX_LINE_LENGTH]; /* The text of the line (up to MAX_LINE_LENGTH - 1 characters)  */
+    int lineNum;                /* The line number reported for the line in errors              */
+    struct IncludedLine *included; /* The analysis of a line of an included file (see includeCache.h), else NULL */
+} SourceLine;
+
+/* A source file held in memory, so both passes (and any pass in between) can go over it without re-reading it */
+typedef struct {
+    char *name;         /* The name of the source (as given to the assembler)  */
+    SourceLine *lines;  /* The lines of the source                             */
+    unsigned count;     /* The number of lines in #lines                       */
+    unsigned capacity;  /* The number of lines #lines can hold                 */
+} SourceFile;
+
+/* Function Prototypes */
+/**
+ * This function reads all the lines of #fp into #source (the file or a pipe, it's never rewound)
+ * **/
+void readSourceFile(FILE *fp, char *name, SourceFile *source);
+
+/**
+ * This function splits the #length characters of #text (a whole file read at once) into the lines of #source,
+ * the same lines readSourceFile reads
+ * **/
+void readSourceText(char *text, size_t length, char *name, SourceFile *source);
+
+/**
+ * This function appends a line with the text #text and the number #lineNum to #source
+ * **/
+void appendSourceLine(SourceFile *source, char *text, int lineNum);
+
+/**
+ * This function copies #from into #to (a new source, free it when done)
+ * **/
+void copySourceFile(SourceFile *from, SourceFile *to);
+
+/**
+ * This function returns whether if #first and #second have the same lines
+ * **/
+Boolean isSourceEqual(SourceFile *first, SourceFile *second);
+
+/**
+ * This function frees the memory held by #source
+ * **/
+void freeSourceFile(SourceFile *source);
+
+#endif
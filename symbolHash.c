@@ -0,0 +1,94 @@
+/*****************************************
+* Symbol Hash Table Operations           *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "symbolHash.h"
+
+/* Functions */
+unsigned hashString(char *str) {
+    unsigned hash = 2166136261U; /* FNV offset basis */
+
+    /* Mix every character into the hash */
+    for (; *str; ++str) {
+        hash ^= (unsigned char) *str;
+        hash *= 16777619U; /* FNV prime */
+    }
+
+    return hash;
+}
+
+void initSymbolHash(SymbolHash *table, unsigned expectedSize) {
+    unsigned count = MIN_HASH_BUCKETS;
+
+    /* Keep the load factor under 1/2 */
+    while (count < 2 * expectedSize)
+        count <<= 1U;
+
+    table->bucketCount = count;
+    table->size = 0;
+    if ((table->buckets = (SymbolHashNode **) calloc(count, sizeof(SymbolHashNode *))) == NULL) {
+        perror("initSymbolHash");
+        exit(EXIT_FAILURE);
+    }
+}
+
+SymbolHashNode *findSymbol(SymbolHash *table, char *name) {
+    SymbolHashNode *node = table->buckets[hashString(name) & (table->bucketCount - 1)];
+
+    /* Traverse the bucket, if found, return the node */
+    for (; node; node = node->next)
+        if (strcmp(node->name, name) == 0)
+            return node;
+
+    return NULL;
+}
+
+SymbolHashNode *insertSymbol(SymbolHash *table, char *name, unsigned value, unsigned owner) {
+    unsigned bucket = hashString(name) & (table->bucketCount - 1);
+    SymbolHashNode *node = table->buckets[bucket];
+
+    /* If the symbol already exists, return it */
+    for (; node; node = node->next)
+        if (strcmp(node->name, name) == 0)
+            return node;
+
+    /* Allocating memory for the new node and its name */
+    node = (SymbolHashNode *) malloc(sizeof(SymbolHashNode));
+    if (node == NULL || (node->name = (char *) malloc(strlen(name) + 1)) == NULL) {
+        perror("insertSymbol");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Initializing the new node */
+    strcpy(node->name, name);
+    node->value = value;
+    node->owner = owner;
+
+    /* Attaching the node at the beginning of its bucket */
+    node->next = table->buckets[bucket];
+    table->buckets[bucket] = node;
+    ++table->size;
+
+    return NULL;
+}
+
+void freeSymbolHash(SymbolHash *table) {
+    unsigned i;
+    SymbolHashNode *tmp;
+
+    /* Free every bucket */
+    for (i = 0; i < table->bucketCount; ++i)
+        while (table->buckets[i] != NULL) {
+            tmp = table->buckets[i];
+            table->buckets[i] = tmp->next;
+            free(tmp->name);
+            free(tmp);
+        }
+
+    free(table->buckets);
+    table->buckets = NULL;
+    table->bucketCount = table->size = 0;
+}
@@ -0,0 +1,60 @@
+/*****************************************
+* Symbol Hash Table Header               *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef SYMBOL_HASH_H
+#define SYMBOL_HASH_H
+
+/*Imports */
+#include "dataTypes.h"
+
+/* Definitions */
+#define MIN_HASH_BUCKETS 64
+
+/* Type Definitions */
+/* A node in a bucket of the symbol hash table */
+typedef struct SymbolHashNode {
+    char *name;                  /* The name of the symbol.                          Example: LIST */
+    unsigned value;              /* The value attached to the symbol.                Example: 137  */
+    unsigned owner;              /* The index of the owner of the symbol (a module / a file)       */
+    struct SymbolHashNode *next; /* A pointer to the next node in the same bucket                  */
+} SymbolHashNode;
+
+/* A chained hash table of symbols, the number of buckets is a power of 2 */
+typedef struct {
+    SymbolHashNode **buckets; /* The buckets of the table           */
+    unsigned bucketCount;     /* The number of buckets (power of 2) */
+    unsigned size;            /* The number of symbols in the table */
+} SymbolHash;
+
+/* Function Prototypes */
+/**
+ * This function returns the hash (FNV-1a) of a string
+ * **/
+unsigned hashString(char *str);
+
+/**
+ * This function initializes #table to hold about #expectedSize symbols without chains growing long
+ * **/
+void initSymbolHash(SymbolHash *table, unsigned expectedSize);
+
+/**
+ * This function searches a symbol by its name #name
+ * @return The node holding #name, or NULL if not found
+ * **/
+SymbolHashNode *findSymbol(SymbolHash *table, char *name);
+
+/**
+ * This function inserts the symbol #name with #value and #owner to #table
+ * @return NULL if the symbol was inserted, or the existing node if #name is already in #table
+ * **/
+SymbolHashNode *insertSymbol(SymbolHash *table, char *name, unsigned value, unsigned owner);
+
+/**
+ * This function frees the memory held by #table
+ * **/
+void freeSymbolHash(SymbolHash *table);
+
+#endif
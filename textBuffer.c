@@ -0,0 +1,55 @@
+/*****************************************
+* Text Buffer Operations                 *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "textBuffer.h"
+
+/* Functions */
+void initTextBuffer(TextBuffer *buffer) {
+    buffer->data = NULL;
+    buffer->length = buffer->capacity = 0;
+}
+
+void reserveTextBuffer(TextBuffer *buffer, size_t length) {
+    size_t capacity = buffer->capacity ? buffer->capacity : INITIAL_TEXT_BUFFER_CAPACITY;
+    char *tmp;
+
+    /* Grow the buffer (by doubling) if needed */
+    if (buffer->length + length > buffer->capacity) {
+        while (capacity < buffer->length + length)
+            capacity *= 2;
+
+        if ((tmp = (char *) realloc(buffer->data, capacity)) == NULL) {
+            perror("reserveTextBuffer");
+            exit(EXIT_FAILURE);
+        }
+        buffer->data = tmp;
+        buffer->capacity = capacity;
+    }
+}
+
+void appendChars(TextBuffer *buffer, char *chars, size_t length) {
+    reserveTextBuffer(buffer, length);
+    memcpy(buffer->data + buffer->length, chars, length);
+    buffer->length += length;
+}
+
+void appendString(TextBuffer *buffer, char *str) {
+    appendChars(buffer, str, strlen(str));
+}
+
+void clearTextBuffer(TextBuffer *buffer) {
+    buffer->length = 0;
+}
+
+void freeTextBuffer(TextBuffer *buffer) {
+    free(buffer->data);
+    initTextBuffer(buffer);
+}
+
+Boolean writeTextBuffer(TextBuffer *buffer, FILE *file) {
+    return BOOLEANIZE(fwrite(buffer->data, 1, buffer->length, file) == buffer->length);
+}
@@ -0,0 +1,62 @@
+/*****************************************
+* Text Buffer Header                     *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef TEXT_BUFFER_H
+#define TEXT_BUFFER_H
+
+/*Imports */
+#include <stdio.h>
+#include "dataTypes.h"
+
+/* Definitions */
+#define INITIAL_TEXT_BUFFER_CAPACITY 4096
+
+/* Type Definitions */
+/* A growable buffer of characters, used to build output in memory */
+typedef struct {
+    char *data;        /* The characters of the buffer (not '\0' terminated) */
+    size_t length;     /* The number of characters in the buffer             */
+    size_t capacity;   /* The number of characters #data can hold            */
+} TextBuffer;
+
+/* Function Prototypes */
+/**
+ * This function initializes #buffer to an empty buffer
+ * **/
+void initTextBuffer(TextBuffer *buffer);
+
+/**
+ * This function makes #buffer hold at least #length more characters without growing
+ * **/
+void reserveTextBuffer(TextBuffer *buffer, size_t length);
+
+/**
+ * This function appends #length characters from #chars to #buffer
+ * **/
+void appendChars(TextBuffer *buffer, char *chars, size_t length);
+
+/**
+ * This function appends the string #str to #buffer
+ * **/
+void appendString(TextBuffer *buffer, char *str);
+
+/**
+ * This function empties #buffer (its memory is kept for reuse)
+ * **/
+void clearTextBuffer(TextBuffer *buffer);
+
+/**
+ * This function frees the memory held by #buffer
+ * **/
+void freeTextBuffer(TextBuffer *buffer);
+
+/**
+ * This function writes the content of #buffer to #file
+ * @return TRUE on success, else FALSE
+ * **/
+Boolean writeTextBuffer(TextBuffer *buffer, FILE *file);
+
+#endif
@@ -0,0 +1,150 @@
+/*****************************************
+* Trace Operations                       *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#define _POSIX_C_SOURCE 200112L /* For clock_gettime */
+#include <time.h>
+#include "trace.h"
+#include "json.h"
+
+/* Definitions */
+#define TRACE_PROCESS_ID 1    /* All the threads are of one process */
+#define TRACE_TEXT_LENGTH 128 /* The longest text of an event, without its strings */
+
+/* Type Definitions */
+/* The beginning or the end of a span */
+typedef struct {
+    char *name;              /* The span                                      */
+    char *detail;            /* The file it works on (NULL if none)            */
+    unsigned long time;      /* Nanoseconds since the trace started            */
+    char phase;              /* 'B' for a beginning, 'E' for an end            */
+} TraceEvent;
+
+/* The events of a thread, only the thread itself appends to them */
+typedef struct {
+    TraceEvent *events;      /* The events, in the order they were recorded    */
+    unsigned count;          /* The number of #events                          */
+    unsigned capacity;       /* The events #events has room for                */
+} TraceBuffer;
+
+/* The buffers of the threads, by the order the threads first recorded */
+static TraceBuffer buffers[MAX_TRACE_THREADS];
+static int threadCount = 0;
+static __thread int threadIndex = -1; /* The buffer of the calling thread (-1 before it first records) */
+
+static int isTracing = 0;
+static struct timespec startTime;
+
+/* Functions */
+void startTrace() {
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    isTracing = 1;
+}
+
+/**
+ * This function records an event #phase of the span #name (on #detail) on the calling thread
+ * **/
+static void recordEvent(char *name, char *detail, char phase) {
+    struct timespec now;
+    TraceBuffer *buffer;
+    TraceEvent *tmp;
+
+    if (!isTracing)
+        return;
+
+    /* A thread takes the next buffer the first time it records, no other thread ever touches it until the end */
+    if (threadIndex < 0)
+        threadIndex = __sync_fetch_and_add(&threadCount, 1);
+    if (threadIndex >= MAX_TRACE_THREADS)
+        return;
+    buffer = buffers + threadIndex;
+
+    /* Grow the buffer (by doubling) if needed */
+    if (buffer->count == buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity * 2 : INITIAL_TRACE_EVENTS;
+        if ((tmp = (TraceEvent *) realloc(buffer->events, buffer->capacity * sizeof(TraceEvent))) == NULL) {
+            perror("recordEvent");
+            exit(EXIT_FAILURE);
+        }
+        buffer->events = tmp;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    buffer->events[buffer->count].name = name;
+    buffer->events[buffer->count].detail = detail;
+    buffer->events[buffer->count].time = (unsigned long) (now.tv_sec - startTime.tv_sec) * 1000000000UL +
+                                         (unsigned long) now.tv_nsec - (unsigned long) startTime.tv_nsec;
+    buffer->events[buffer->count++].phase = phase;
+}
+
+void traceBegin(char *name, char *detail) {
+    recordEvent(name, detail, 'B');
+}
+
+void traceEnd(char *name) {
+    recordEvent(name, NULL, 'E');
+}
+
+void writeTrace(TextBuffer *buffer) {
+    TraceEvent *event;
+    char text[TRACE_TEXT_LENGTH];
+    int i, count = threadCount < MAX_TRACE_THREADS ? threadCount : MAX_TRACE_THREADS;
+    unsigned j;
+
+    appendString(buffer, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    for (i = 0; i < count; ++i) {
+        /* The name of the thread (the first one to record is the main thread) */
+        sprintf(text, "%s\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, "
+                      "\"args\": {\"name\": ", i ? "," : "", TRACE_PROCESS_ID, i);
+        appendString(buffer, text);
+        sprintf(text, i ? "\"thread %d\"}}" : "\"main\"}}", i);
+        appendString(buffer, text);
+
+        /* Its events, the times in microseconds */
+        for (j = 0; j < buffers[i].count; ++j) {
+            event = buffers[i].events + j;
+            appendString(buffer, ",\n  {\"name\": ");
+            appendJsonString(buffer, event->name);
+            sprintf(text, ", \"ph\": \"%c\", \"ts\": %lu.%03lu, \"pid\": %d, \"tid\": %d", event->phase,
+                    event->time / 1000, event->time % 1000, TRACE_PROCESS_ID, i);
+            appendString(buffer, text);
+            if (event->detail != NULL) {
+                appendString(buffer, ", \"args\": {\"file\": ");
+                appendJsonString(buffer, event->detail);
+                appendString(buffer, "}");
+            }
+            appendString(buffer, "}");
+        }
+    }
+    appendString(buffer, "\n]}\n");
+}
+
+Boolean saveTrace(char *fileName) {
+    TextBuffer buffer;
+    FILE *file;
+    Boolean isWritten;
+    int i;
+
+    initTextBuffer(&buffer);
+    writeTrace(&buffer);
+
+    /* The events are written once, at the end of the run */
+    for (i = 0; i < MAX_TRACE_THREADS; ++i) {
+        free(buffers[i].events);
+        buffers[i].events = NULL;
+        buffers[i].count = buffers[i].capacity = 0;
+    }
+
+    if ((file = fopen(fileName, "w")) == NULL) {
+        freeTextBuffer(&buffer);
+        return FALSE;
+    }
+    isWritten = writeTextBuffer(&buffer, file);
+    isWritten = BOOLEANIZE(fclose(file) == 0 && isWritten);
+
+    freeTextBuffer(&buffer);
+    return isWritten;
+}
@@ -0,0 +1,49 @@
+/*****************************************
+* Trace Header                           *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "textBuffer.h"
+
+/* Definitions */
+#define MAX_TRACE_THREADS 64       /* The threads that record events (the events of the ones after them are dropped) */
+#define INITIAL_TRACE_EVENTS 1024  /* The events a thread can record before its buffer first grows                  */
+
+/* Function Prototypes */
+/**
+ * This function starts recording events (until it's called, the calls below record nothing), the times of the
+ * events are measured from now
+ * **/
+void startTrace();
+
+/**
+ * This function records the beginning of the span #name on the calling thread. #detail is the file the span works
+ * on (NULL if none), it must stay valid until the trace is saved. Every thread records into a buffer of its own,
+ * so a thread never waits for another one to record
+ * **/
+void traceBegin(char *name, char *detail);
+
+/**
+ * This function records the end of the last span #name that began on the calling thread
+ * **/
+void traceEnd(char *name);
+
+/**
+ * This function writes the events of all the threads into #buffer, in the Chrome trace event format (JSON, opened
+ * by chrome://tracing and Perfetto). Call it once the threads that recorded have ended
+ * **/
+void writeTrace(TextBuffer *buffer);
+
+/**
+ * This function writes the events to the file #fileName, then frees them
+ * @return TRUE on success, else FALSE
+ * **/
+Boolean saveTrace(char *fileName);
+
+#endif
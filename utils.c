@@ -10,6 +10,10 @@
 #include "firstPass.h"
 #include "dataTypes.h"
 #include "externalVariables.h"
+#include "diagnostics.h"
+#include "dataPool.h"
+#include "crossReference.h"
+#include "debugTable.h"
 
 /* Functions */
 /** Syntax Analysis And Input Detection **/
@@ -24,26 +28,32 @@ char *strip(char *line) {
 }
 
 char *removeNewLine(char *sequence) {
-    int newLineLoc = 0; /* The location of the new line character */
+    char *newLine = sequence; /* The location of the new line character */
 
-    /* Find the index of the new line */
-    for (; !isEmpty(sequence) && sequence[newLineLoc] != '\n' && sequence[newLineLoc] != '\r'; ++newLineLoc)
+    /* A text of only spaces is emptied (one scan, instead of one for every character) */
+    if (isEmpty(sequence)) {
+        *sequence = '\0';
+        return sequence;
+    }
+
+    /* Find the new line */
+    for (; *newLine && *newLine != '\n' && *newLine != '\r'; ++newLine)
         ;
 
     /* remove it by ending the string  */
-    sequence[newLineLoc] = '\0';
+    *newLine = '\0';
     return sequence;
 }
 
 char *removeColon(char *sequence) {
     int colonLoc = 0; /* The location of the colon character */
-    char *noColon = (char *) calloc(MAX_LABEL_SIZE_WITH_COLON * sizeof(char), 1);
+    char *noColon = (char *) calloc(MAX_LINE_LENGTH * sizeof(char), 1);
 
-    /* Copy the label to the noColon variable */
-    strcpy(noColon, sequence);
+    /* Copy the label to the noColon variable (it can be as long as the line) */
+    strncpy(noColon, sequence, MAX_LINE_LENGTH - 1);
 
     /* Find the index of the colon */
-    for (; !isEmpty(noColon) && noColon[colonLoc] != ':'; ++colonLoc)
+    for (; noColon[colonLoc] && noColon[colonLoc] != ':'; ++colonLoc)
         ;
 
     /* remove it by ending the string  */
@@ -94,7 +104,9 @@ Boolean isDirectiveName(char *sequence) {
     return strcmp(sequence, "data")    == 0 ||
            strcmp(sequence, "string")  == 0 ||
            strcmp(sequence, "extern")  == 0 ||
-           strcmp(sequence, "entry")   == 0;
+           strcmp(sequence, "entry")   == 0 ||
+           strcmp(sequence, "incbin")  == 0 ||
+           strcmp(sequence, "include") == 0;
 }
 
 Boolean isInstructionName(char *sequence) {
@@ -128,7 +140,7 @@ Boolean isNumber(char *sequence) {
         ++sequence;
 
     /* Go to end of the digit sequence (if exists) */
-    while (!isEmpty(sequence) && isdigit(*sequence))
+    while (isdigit(*sequence))
         ++sequence;
 
     /* If there are foreign characters after the digit sequence, it is not a number */
@@ -145,7 +157,7 @@ Boolean isString(char *sequence) {
     ++sequence;
 
     /* Go to the next '"' if exists */
-    while (!isEmpty(sequence) && *sequence != '\"')
+    while (*sequence && *sequence != '\"')
         ++sequence;
 
     /* if the sequence doesn't end with '"', it is not a string */
@@ -183,7 +195,7 @@ Boolean isLegalLabel(char *sequence){
     }
 
     /* Skip the alpha-numeric characters until the colon */
-    while (!isEmpty(sequence) && isalnum(*sequence) && *sequence != ':')
+    while (isalnum(*sequence))
         ++sequence;
 
     /* If the sequence doesn't end with ':', it is not a label */
@@ -222,7 +234,7 @@ Boolean isLegalLabelNoColon(char *sequence){
     }
 
     /* Skip the alpha-numeric characters until the colon */
-    while (!isEmpty(sequence) && isalnum(*sequence))
+    while (isalnum(*sequence))
         ++sequence;
 
     return isEmpty(sequence);
@@ -238,7 +250,7 @@ Boolean hasTwoCommas (char *line) {
         return FALSE;
 
     /* If there are two consecutive characters that are ',', return true*/
-    for (; !isEmpty(line); ++line)
+    for (; *line; ++line)
         if (*line == ',' && *(line + 1) == ',')
             return TRUE;
 
@@ -314,7 +326,7 @@ AddressingMode getAddressingModeSecondPass(char *operand) {
 char *getLabel(char *line) {
     int i;
     /* Will hold the label */
-    char *label = (char *) calloc(MAX_LABEL_SIZE_WITH_COLON * sizeof(char), 1);
+    char *label = (char *) calloc(MAX_LINE_LENGTH * sizeof(char), 1);
 
     /* remove all spaces at the beginning */
     line = strip(line);
@@ -323,7 +335,7 @@ char *getLabel(char *line) {
         return NULL;
 
     /* Copy the label to #label until ':' */
-    for (i = 0; !isEmpty(line) && line[i] != ':'; ++i)
+    for (i = 0; line[i] && line[i] != ':'; ++i)
         label[i] = line[i];
 
     /* If the next character is a ':', copy it to #label, else there is no label definition */
@@ -343,21 +355,17 @@ char *getLabel(char *line) {
 }
 
 Directive getDirective(char *line) {
-    char temp[2];
+    int i = 0;
     char *dir = (char *) calloc(sizeof(char) * MAX_DIRECTIVE_LENGTH, 1);
     line = strip(line);
 
     /* Skip to the dot */
-    while (!isEmpty(line) && *line != '.')
+    while (*line && *line != '.')
         ++line;
 
-    /* Read all chars until a space */
-    while (!isEmpty(line) && !isspace(*line)) {
-        temp[0] = *line;
-        temp[1] = '\0';
-        strcat(dir, temp);
-        ++line;
-    }
+    /* Read all chars until a space (a longer sequence is not a directive anyway) */
+    while (i < MAX_DIRECTIVE_LENGTH - 1 && *line && !isspace(*line))
+        dir[i++] = *line++;
 
     /* Return the correct directive */
     if (strcmp(dir, ".string") == 0) {
@@ -376,6 +384,14 @@ Directive getDirective(char *line) {
         free(dir);
         return EXTERN_DIR;
 
+    } else if (strcmp(dir, ".incbin") == 0) {
+        free(dir);
+        return INCBIN_DIR;
+
+    } else if (strcmp(dir, ".include") == 0) {
+        free(dir);
+        return INCLUDE_DIR;
+
     } else {
         free(dir);
         return UNKNOWN_DIRECTIVE;
@@ -428,13 +444,37 @@ int getNumber(char *sequence) {
     return sign * abs;
 }
 
+char *readNumber(char *sequence, int *number) {
+    int sign = 1, abs = 0;
+
+    /* A number can't start with a space (the token would be empty) */
+    if (*sequence == '\0' || isspace(*sequence))
+        return NULL;
+
+    /* If the sequence has a sign symbol, skip it */
+    if (*sequence == '-' || *sequence == '+')
+        sign = (*sequence++ == '-') ? -1 : 1;
+
+    /* Convert the digit sequence while validating it */
+    for (; isdigit(*sequence); ++sequence)
+        abs = (10 * abs) + (*sequence - '0');
+
+    /* Only spaces (a new line) may follow the digits until the end of the token */
+    for (; *sequence && *sequence != ',' && *sequence != ' ' && *sequence != '\t'; ++sequence)
+        if (!isspace(*sequence))
+            return NULL;
+
+    *number = sign * abs;
+    return sequence;
+}
+
 char *getString(char *sequence) {
     int secondQuoteLoc = 0;
     /* Get rid of the first '"' */
     ++sequence;
 
     /* Get rid of the second '"' */
-    for (; !isEmpty(sequence) && sequence[secondQuoteLoc] != '\"'; ++secondQuoteLoc)
+    for (; sequence[secondQuoteLoc] && sequence[secondQuoteLoc] != '\"'; ++secondQuoteLoc)
         ;
 
     sequence[secondQuoteLoc] = '\0';
@@ -458,8 +498,8 @@ Instruction getInstruction(char *line) {
         line = strip(line);
     }
 
-    /* Copy the instruction */
-    while (!isEmpty(line) && !isspace(*line)) {
+    /* Copy the instruction (a longer sequence is not an instruction anyway) */
+    while (i < (int) sizeof(inst) - 1 && *line && !isspace(*line)) {
         inst[i] = *line;
         ++i, ++line;
     }
@@ -531,7 +571,7 @@ int getInstructionLength(Instruction code) {
 
 char *getFirstOperand(char *line) {
     int i = 0;
-    char *operand = (char *) calloc(MAX_OPERAND_LENGTH * sizeof(char), 1), *label;
+    char *operand = (char *) calloc(MAX_LINE_LENGTH * sizeof(char), 1), *label;
     Instruction inst = getInstruction(line);
 
     /* If the line is empty */
@@ -556,26 +596,19 @@ char *getFirstOperand(char *line) {
     if (isEmpty(line))
         return NULL;
 
-    /* Copy the operand */
-    while (!isEmpty(line) && *line != ',') {
+    /* Copy the operand, up to the first space or comma */
+    while (*line && *line != ',' && !isspace(*line)) {
         operand[i] = *line;
         ++i, ++line;
     }
 
-    /* remove trailing spaces from the operand */
-    for (i = 0; operand[i]; ++i)
-        if (isspace(operand[i])) {
-            operand[i] = '\0';
-            break;
-        }
-
     return operand;
 }
 
 char *getSecondOperand(char *line) {
     int i = 0;
     Instruction inst = getInstruction(line);
-    char *operand    = (char *) calloc(MAX_OPERAND_LENGTH * sizeof(char), 1), *label;
+    char *operand    = (char *) calloc(MAX_LINE_LENGTH * sizeof(char), 1), *label;
     char *firstOp    = getFirstOperand(line);
 
     /* If the line is empty */
@@ -612,7 +645,7 @@ char *getSecondOperand(char *line) {
     line = strip(line);
 
     /* Copy the operand */
-    while (!isEmpty(line) && !isspace(*line)) {
+    while (*line && !isspace(*line)) {
         operand[i] = *line;
         ++i, ++line;
     }
@@ -653,74 +686,146 @@ int getOperandInstructionWidth(AddressingMode src, AddressingMode dest) {
 
 /** Memory Operations And Encoding Operations **/
 void installWordInData(Word w) {
-    dataImage[dc] = w; /* Install the word */
-    ++dc; /* Increment dc to point to the new free location */
-    ++dataWordsInstalled;
+    installWordsInData(&w, 1);
+}
+
+Boolean installWordsInData(Word *words, unsigned count) {
+    /* If the words don't fit in the data image */
+    if (dc + count > MEMORY_SIZE) {
+        errorCode = DATA_IMAGE_OVERFLOW;
+        return FALSE;
+    }
+
+    if (!isCheckMode) { /* A check only validates, the image isn't built */
+        markDebugWords(FALSE, dc); /* The words come from the current statement */
+        memcpy(dataImage + dc, words, count * sizeof(Word)); /* Install the words */
+    }
+    dc += count; /* Increment dc to point to the new free location */
+    dataWordsInstalled += count;
+    return TRUE;
 }
 
 void installWordInCode(Word w) {
+    markDebugWords(TRUE, ic); /* The word comes from the current statement */
     machineCodeImage[ic] = w; /* Install the word */
     ++ic; /* Increment ic to point to the new free location */
     ++codeWordsInstalled;
 }
 
 /** Error Handling Functions **/
-void alertLineError(int lineNum, Error err) {
+char *getErrorMessage(Error err) {
     switch (err) { /* Go through all errors */
         case LABEL_NAME_TOO_LONG:
-            printf("Error Stats For Line no. %d:\tThe Label Is Too Long\n", lineNum);
-            break;
+            return "The Label Is Too Long";
         case LABEL_NAME_INVALID:
-            printf("Error Stats For Line no. %d:\tThe Label Name Is Invalid\n", lineNum);
-            break;
+            return "The Label Name Is Invalid";
         case LABEL_NAME_RESERVED:
-            printf("Error Stats For Line no. %d:\tThe Label Name Is Reserved\n", lineNum);
-            break;
+            return "The Label Name Is Reserved";
         case LABEL_NAME_ALREADY_EXIST:
-            printf("Error Stats For Line no. %d:\tThe Label Name Is Already Defined\n", lineNum);
-            break;
+            return "The Label Name Is Already Defined";
         case INVALID_CMD_NAME:
-            printf("Error Stats For Line no. %d:\tThe Instruction Name Is Invalid\n", lineNum);
-            break;
+            return "The Instruction Name Is Invalid";
         case INVALID_DIR_NAME:
-            printf("Error Stats For Line no. %d:\tThe Directive Name Is Invalid\n", lineNum);
-            break;
+            return "The Directive Name Is Invalid";
         case INVALID_OPERANDS_DATA_DIR:
-            printf("Error Stats For Line no. %d:\tNo Operands Were Given To The Data Directive\n", lineNum);
-            break;
+            return "No Operands Were Given To The Data Directive";
         case INVALID_OPERANDS_STRING_DIR:
-            printf("Error Stats For Line no. %d:\tNo Operand Were Given To The String Directive\n", lineNum);
-            break;
+            return "No Operand Were Given To The String Directive";
         case INVALID_OPERAND_NUMBER_CMD:
-            printf("Error Stats For Line no. %d:\tInvalid Number Of Operands For That Instruction\n", lineNum);
-            break;
+            return "Invalid Number Of Operands For That Instruction";
         case INVALID_ADDR_MODES:
-            printf("Error Stats For Line no. %d:\tInvalid Addressing Modes For That Instruction\n", lineNum);
-            break;
+            return "Invalid Addressing Modes For That Instruction";
         case ENTRY_LABEL_DOSENT_EXIST:
-            printf("Error Stats For Line no. %d:\tEntry Operand Is Not Defined\n", lineNum);
-            break;
+            return "Entry Operand Is Not Defined";
         case EXTERN_OPERAND_INVALID:
-            printf("Error Stats For Line no. %d:\tExtern Operand Is Not Valid\n", lineNum);
-            break;
+            return "Extern Operand Is Not Valid";
         case EXTERN_OPERAND_ALREADY_EXIST:
-            printf("Error Stats For Line no. %d:\tExtern Operand Already Exist\n", lineNum);
-            break;
+            return "Extern Operand Already Exist";
         case INVALID_COMMAS:
-            printf("Error Stats For Line no. %d:\tTwo Or More Consecutive Commas\n", lineNum);
-            break;
+            return "Two Or More Consecutive Commas";
         case STRING_OPERAND_INVALID:
-            printf("Error Stats For Line no. %d:\tThe Operand Of The String Directive Is Invalid\n", lineNum);
-            break;
+            return "The Operand Of The String Directive Is Invalid";
         case DATA_OPERAND_INVALID:
-            printf("Error Stats For Line no. %d:\tOne Or More Operands Of The Data Directive Is Invalid\n", lineNum);
-            break;
+            return "One Or More Operands Of The Data Directive Is Invalid";
+        case DATA_IMAGE_OVERFLOW:
+            return "The Data Doesn't Fit In The Memory";
+        case INCBIN_OPERANDS_INVALID:
+            return "The Operands Of The Incbin Directive Are Invalid";
+        case INCBIN_FILE_INVALID:
+            return "The File Of The Incbin Directive Can't Be Read";
+        case INCBIN_WORD_TOO_WIDE:
+            return "A Word Of The Incbin Directive Doesn't Fit In 15 Bits";
+        case OPERAND_LABEL_UNDEFINED:
+            return "The Label Of The Operand Is Not Defined";
+        case INCLUDE_OPERAND_INVALID:
+            return "The Operand Of The Include Directive Is Invalid";
+        case INCLUDE_FILE_INVALID:
+            return "The File Of The Include Directive Can't Be Read";
+        case INCLUDE_CYCLE:
+            return "The File Of The Include Directive Includes Itself";
+        case MACRO_NAME_INVALID:
+            return "The Macro Name Is Invalid";
+        case MACRO_NAME_ALREADY_EXIST:
+            return "The Macro Name Is Already Defined";
+        case MACRO_NESTED:
+            return "A Macro Can't Be Defined Inside A Macro";
+        case MACRO_NOT_ENDED:
+            return "The Macro Definition Has No End";
+        case MACRO_END_INVALID:
+            return "The End Of The Macro Definition Is Invalid";
         case NO_ERROR:
         default:
-            break;
+            return "";
     }
 }
 
+void alertLineError(int lineNum, int column, Error err) {
+    reportDiagnostic(SEVERITY_ERROR, lineNum, column, err);
+}
+
+int getStatementColumn(char *line) {
+    /* The statement starts at the first non-space character */
+    return (int) (strip(line) - line) + 1;
+}
+
+/**
+ * This function skips the label definition of #line, if it has one
+ * @return Where the instruction (or directive) starts
+ * **/
+static char *skipLabelDefinition(char *line) {
+    char *token = strip(line), *end;
+
+    /* A label definition is the first token, up to its ':' */
+    for (end = token; *end && *end != ':' && !isspace(*end); ++end)
+        ;
+
+    return *end == ':' ? strip(end + 1) : token;
+}
+
+int getInstructionColumn(char *line) {
+    return (int) (skipLabelDefinition(line) - line) + 1;
+}
+
+int getOperandColumn(char *line, int index) {
+    char *operand = skipLabelDefinition(line), *end = line + strlen(line);
+
+    /* Skip the instruction, then the operands before #index (each one ends at a comma) */
+    while (*operand && !isspace(*operand))
+        ++operand;
+    for (; index > 0 && operand != NULL; --index)
+        if ((operand = strchr(operand, ',')) != NULL)
+            ++operand;
+
+    /* A missing operand is at the end of the statement */
+    if (isEmpty(operand)) {
+        while (end > line && isspace(end[-1]))
+            --end;
+        return (int) (end - line) + 1;
+    }
+
+    return (int) (strip(operand) - line) + 1;
+}
+
 /** Misc. **/
 void initializeGlobalVariables() {
     int i;
@@ -728,8 +833,13 @@ void initializeGlobalVariables() {
     ic = 0, dc = 0;
     codeWordsInstalled = 0, dataWordsInstalled = 0;
 
-    /* Reset error code */
+    /* Reset error code and diagnostics */
     errorCode = NO_ERROR;
+    errorColumn = 0;
+    resetDiagnostics();
+    resetDataPool();
+    resetCrossReferences();
+    resetDebugTable();
 
     /* Reset dynamic tables */
     symbolTable = NULL;
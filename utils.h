@@ -114,6 +114,13 @@ int getInstructionLength(Instruction code);
  * **/
 int getNumber (char *sequence);
 
+/**
+ * This functions validates and converts the number at the beginning of #sequence in one pass (the number ends at
+ * the next ',', ' ' or '\t', like a token of a data directive)
+ * @return A pointer to the character after the number, or NULL if it isn't a valid number
+ * **/
+char *readNumber(char *sequence, int *number);
+
 /**
  * This functions returns a string from a sequence
  * **/
@@ -155,13 +162,44 @@ int getOperandInstructionWidth(AddressingMode src, AddressingMode dest);
  * **/
 void installWordInData(Word w);
 
+/**
+ * This functions installs #count words from #words in the data image (in check mode only the room for them is
+ * taken, #words isn't read)
+ * @return TRUE on success, FALSE (with the error code set) if the data image can't hold them
+ * **/
+Boolean installWordsInData(Word *words, unsigned count);
+
 /**
  * This functions installs a word in the machine image
  * **/
 void installWordInCode(Word w);
 
 /** Error Handling Methods **/
-void alertLineError(int lineNum, Error err);
+/**
+ * This functions reports error #err on line #lineNum, column #column
+ * **/
+void alertLineError(int lineNum, int column, Error err);
+
+/**
+ * This functions returns the message describing error #err
+ * **/
+char *getErrorMessage(Error err);
+
+/**
+ * This functions returns the column (1 based) where the statement in #line starts
+ * **/
+int getStatementColumn(char *line);
+
+/**
+ * This functions returns the column (1 based) of the instruction (or directive) in #line, after its label
+ * **/
+int getInstructionColumn(char *line);
+
+/**
+ * This functions returns the column (1 based) of operand #index (0 based) of the instruction in #line,
+ * or the column after the statement if it has no such operand
+ * **/
+int getOperandColumn(char *line, int index);
 
 /** Misc. Methods **/
 /**
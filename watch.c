@@ -0,0 +1,242 @@
+/*****************************************
+* Watch Mode Operations                  *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#define _POSIX_C_SOURCE 200112L /* For poll, read */
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include "watch.h"
+#include "fileHandling.h"
+#include "includeCache.h"
+#include "externalVariables.h"
+
+/* Functions */
+/**
+ * This function adds an inotify watch on the directory of the file #path (a directory watched already keeps its
+ * watch), it is put in #watch
+ * @return The name of the file in its directory (a new string), or NULL if the directory can't be watched
+ * **/
+static char *watchDirectory(int inotify, char *path, int *watch) {
+    char *copy = (char *) malloc(strlen(path) + 1), *separator, *directory = ".", *baseName, *name;
+
+    if (copy == NULL) {
+        perror("watchDirectory");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(copy, path);
+
+    /* Split the path to the directory and the name of the file in it */
+    baseName = copy;
+    if ((separator = strrchr(copy, PATH_SEPARATOR)) != NULL) {
+        *separator = '\0';
+        directory = *copy ? copy : "/";
+        baseName = separator + 1;
+    }
+
+    /*
+     * The directory is watched rather than the file, editors often save by writing a new file and renaming it
+     * over the old one, which a watch on the old file would miss
+     */
+    if ((*watch = inotify_add_watch(inotify, directory, IN_CLOSE_WRITE | IN_MOVED_TO)) < 0) {
+        free(copy);
+        return NULL;
+    }
+
+    if ((name = (char *) malloc(strlen(baseName) + 1)) == NULL) {
+        perror("watchDirectory");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(name, baseName);
+    free(copy);
+    return name;
+}
+
+/**
+ * This function adds an inotify watch on the directory of #file, and keeps the name of #file in it
+ * @return TRUE on success, else FALSE
+ * **/
+static Boolean watchFile(int inotify, WatchedFile *file) {
+    char *path = appendFileSuffix(file->name, ASM);
+
+    if (path == NULL)
+        return FALSE;
+
+    if ((file->baseName = watchDirectory(inotify, path, &file->watch)) == NULL)
+        perror(file->name);
+    free(path);
+    return BOOLEANIZE(file->baseName != NULL);
+}
+
+/**
+ * This function watches the files #file included when it was last assembled, instead of the ones it included before.
+ * A file in a directory that can't be watched (one that doesn't exist yet) isn't watched.
+ * **/
+static void watchIncludes(int inotify, WatchedFile *file) {
+    WatchedInclude *include;
+    char **paths;
+    unsigned i, count = getIncludedPaths(&paths);
+
+    for (i = 0; i < file->includeCount; ++i)
+        free(file->includes[i].baseName);
+    free(file->includes);
+    file->includes = NULL;
+    file->includeCount = 0;
+    if (count == 0)
+        return;
+
+    if ((file->includes = (WatchedInclude *) malloc(count * sizeof(WatchedInclude))) == NULL) {
+        perror("watchIncludes");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < count; ++i) {
+        include = file->includes + file->includeCount;
+        if ((include->baseName = watchDirectory(inotify, paths[i], &include->watch)) != NULL)
+            ++file->includeCount;
+    }
+}
+
+/**
+ * This function reads the pending events of #inotify and marks the files they are about as changed (all of them if
+ * the queue of events overflowed)
+ * **/
+static void readEvents(int inotify, WatchedFile *files, int count) {
+    union { /* The events are read into it, it must be aligned like one */
+        struct inotify_event event;
+        char bytes[WATCH_EVENT_BUFFER_SIZE];
+    } buffer;
+    struct inotify_event *event;
+    ssize_t length;
+    char *position;
+    unsigned j;
+    int i;
+
+    if ((length = read(inotify, buffer.bytes, WATCH_EVENT_BUFFER_SIZE)) <= 0)
+        return;
+
+    for (position = buffer.bytes; position < buffer.bytes + length; position += sizeof(struct inotify_event) + event->len) {
+        event = (struct inotify_event *) position;
+
+        /* Events were dropped, any file may have changed: each one is read again (and assembled if it includes) */
+        if (event->mask & IN_Q_OVERFLOW) {
+            for (i = 0; i < count; ++i) {
+                files[i].isChanged = TRUE;
+                files[i].isIncludeChanged = BOOLEANIZE(files[i].isIncludeChanged || files[i].includeCount > 0);
+            }
+            continue;
+        }
+        if (event->len == 0)
+            continue;
+        for (i = 0; i < count; ++i) {
+            if (files[i].watch == event->wd && strcmp(files[i].baseName, event->name) == 0)
+                files[i].isChanged = TRUE;
+            for (j = 0; j < files[i].includeCount; ++j)
+                if (files[i].includes[j].watch == event->wd && strcmp(files[i].includes[j].baseName, event->name) == 0)
+                    files[i].isChanged = files[i].isIncludeChanged = TRUE;
+        }
+    }
+}
+
+/**
+ * This function reads the changed files of #files, and assembles the ones whose content (or included file) changed,
+ * then watches the files they include with #inotify
+ * @return The number of files assembled
+ * **/
+static int assembleChanged(int inotify, WatchedFile *files, int count, AssembleFunction assemble) {
+    SourceFile source, copy;
+    FILE *fp;
+    int i, assembled = 0;
+
+    for (i = 0; i < count; ++i) {
+        if (!files[i].isChanged)
+            continue;
+        files[i].isChanged = FALSE;
+
+        if ((fp = openFile(files[i].name, ASM, "r")) == NULL) {
+            fprintf(diagnosticsFile, "\nERROR: Couldn't Open File %s, Try To Check If It Exists,"
+                                     " And If You Have The Correct Permissions To Open It.\n", files[i].name);
+            continue;
+        }
+        readSourceFile(fp, files[i].name, &source);
+        fclose(fp);
+
+        /*
+         * A save that didn't change the content (or a change that was undone) doesn't assemble it again, unless an
+         * included file changed (the include cache tells if its content did)
+         */
+        if (files[i].isLoaded && !files[i].isIncludeChanged && isSourceEqual(&source, &files[i].source)) {
+            freeSourceFile(&source);
+            continue;
+        }
+        if (files[i].isLoaded)
+            freeSourceFile(&files[i].source);
+        files[i].source = source;
+        files[i].isLoaded = TRUE;
+
+        /* The passes may rewrite the lines they get, the kept lines must stay as they were read */
+        copySourceFile(&files[i].source, &copy);
+        files[i].isIncludeChanged = FALSE;
+        assemble(&copy);
+        freeSourceFile(&copy);
+        watchIncludes(inotify, files + i);
+        ++assembled;
+    }
+
+    return assembled;
+}
+
+int watchSources(char **names, int count, AssembleFunction assemble) {
+    WatchedFile *files = (WatchedFile *) calloc((size_t) count, sizeof(WatchedFile));
+    struct pollfd pending;
+    int inotify, i;
+
+    if (files == NULL) {
+        perror("watchSources");
+        exit(EXIT_FAILURE);
+    }
+    if ((inotify = inotify_init()) < 0) {
+        perror("inotify_init");
+        free(files);
+        return EXIT_FAILURE;
+    }
+
+    /* Watch every file before it is first read, so a change made while it is assembled isn't missed */
+    for (i = 0; i < count; ++i) {
+        files[i].name = names[i];
+        files[i].isChanged = TRUE;
+        if (!watchFile(inotify, files + i)) {
+            close(inotify);
+            return EXIT_FAILURE;
+        }
+    }
+
+    pending.fd = inotify;
+    pending.events = POLLIN;
+    for (;;) {
+        /*
+         * The outputs are written next to the sources, their events wake the loop too but assemble nothing. The
+         * included files the changes left behind are freed, the run never ends
+         */
+        if (assembleChanged(inotify, files, count, assemble) > 0) {
+            trimIncludeCache();
+            if (!isQuietMode) {
+                fprintf(diagnosticsFile, "\nWAITING FOR CHANGES...\n");
+                fflush(diagnosticsFile);
+            }
+        }
+
+        /* Wait for a change, then for the burst it starts to end (every save of the burst is read on the way) */
+        if (poll(&pending, 1, -1) < 0)
+            break;
+        do
+            readEvents(inotify, files, count);
+        while (poll(&pending, 1, WATCH_SETTLE_MILLISECONDS) > 0);
+    }
+
+    perror("poll");
+    close(inotify);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,51 @@
+/*****************************************
+* Watch Mode Header                      *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef WATCH_H
+#define WATCH_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "sourceFile.h"
+
+/* Definitions */
+#define WATCH_SETTLE_MILLISECONDS 150   /* A burst of changes ends after that long without one   */
+#define WATCH_EVENT_BUFFER_SIZE 4096    /* The bytes read from the inotify descriptor at once     */
+
+/* Type Definitions */
+/* Assembles a source (the passes, the output files and the report) */
+typedef void (*AssembleFunction)(SourceFile *source);
+
+/* A file a source includes, being watched */
+typedef struct {
+    char *baseName;       /* The name of the file in its directory                    Example: defs.as */
+    int watch;            /* The inotify watch of its directory                                        */
+} WatchedInclude;
+
+/* A source file being watched */
+typedef struct {
+    char *name;                 /* The name of the source (as given to the assembler)       Example: src/ps */
+    char *baseName;             /* The name of its file in its directory                    Example: ps.as  */
+    int watch;                  /* The inotify watch of its directory                                       */
+    SourceFile source;          /* The lines it was last assembled from                                     */
+    WatchedInclude *includes;   /* The files it included when it was last assembled                         */
+    unsigned includeCount;      /* The number of #includes                                                  */
+    Boolean isLoaded;           /* If #source holds anything yet                                            */
+    Boolean isChanged;          /* If its file (or a file it includes) changed since it was last read       */
+    Boolean isIncludeChanged;   /* If a file it includes changed since it was last assembled                */
+} WatchedFile;
+
+/* Function Prototypes */
+/**
+ * This function assembles the #count sources in #names with #assemble, then waits for their files (and the files
+ * they include) to change and assembles again only the ones whose content changed, or one of whose included files
+ * changed (a burst of changes is assembled once, when it ends).
+ * It returns only if the files can't be watched.
+ * @return The exit status
+ * **/
+int watchSources(char **names, int count, AssembleFunction assemble);
+
+#endif
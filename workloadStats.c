@@ -0,0 +1,169 @@
+/*****************************************
+* Workload Statistics Operations         *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+/* Imports */
+#include "workloadStats.h"
+#include "decoder.h"
+#include "json.h"
+
+/* The counts of the run, all its sources added together */
+static WorkloadStats stats;
+
+/* The names of the directives, ordered like Directive */
+static char *directiveNames[DATA_DIRECTIVE_COUNT] = {"data", "string", "entry", "extern", "incbin", "include"};
+
+/* Functions */
+void countSourceFile() {
+    ++stats.files;
+}
+
+void countLine(char *line) {
+    size_t length = strlen(line);
+    char *c;
+
+    /* The line ending isn't a part of the line */
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+        --length;
+
+    ++stats.lines;
+    ++stats.lineLengths[length / LINE_LENGTH_BUCKET_SIZE];
+
+    for (c = line; *c && isspace((unsigned char) *c); ++c)
+        ;
+    if (*c == '\0')
+        ++stats.blankLines;
+    else if (*c == ';')
+        ++stats.commentLines;
+}
+
+void countLabelDefinition() {
+    ++stats.labelDefinitions;
+}
+
+void countInstruction(Instruction inst, AddressingMode srcMode, AddressingMode destMode) {
+    ++stats.instructions[inst];
+
+    /* The slot of a missing operand is the first one (UNKNOWN_ADDRESSING_MODE is -1) */
+    ++stats.addressingModes[srcMode + 1][destMode + 1];
+
+    /* A direct operand names a label */
+    stats.labelReferences += (srcMode == DIRECT) + (destMode == DIRECT);
+}
+
+void countDirective(Directive dir, unsigned words) {
+    ++stats.directives[dir];
+    stats.directiveWords[dir] += words;
+}
+
+/**
+ * This function appends the member name #key (and its colon) to #buffer, after a comma unless #isFirst
+ * **/
+static void appendJsonKey(TextBuffer *buffer, char *key, Boolean isFirst) {
+    if (!isFirst)
+        appendString(buffer, ", ");
+    appendJsonString(buffer, key);
+    appendString(buffer, ": ");
+}
+
+/**
+ * This function appends the member #key with the number #value to #buffer
+ * **/
+static void appendJsonCount(TextBuffer *buffer, char *key, unsigned long value, Boolean isFirst) {
+    char number[MAX_LINE_LENGTH];
+
+    appendJsonKey(buffer, key, isFirst);
+    sprintf(number, "%lu", value);
+    appendString(buffer, number);
+}
+
+void writeWorkloadStats(TextBuffer *buffer) {
+    char text[MAX_LINE_LENGTH];
+    unsigned long instructions = 0;
+    Boolean isFirst;
+    int i, j;
+
+    appendString(buffer, "{\n  ");
+    appendJsonCount(buffer, "files", stats.files, TRUE);
+
+    /* The lines, how many of them hold nothing, and their lengths */
+    appendString(buffer, ",\n  \"lines\": {");
+    appendJsonCount(buffer, "total", stats.lines, TRUE);
+    appendJsonCount(buffer, "blank", stats.blankLines, FALSE);
+    appendJsonCount(buffer, "comment", stats.commentLines, FALSE);
+    appendJsonKey(buffer, "commentRatio", FALSE);
+    sprintf(text, "%.*f", RATIO_PRECISION, stats.lines ? (double) stats.commentLines / stats.lines : 0.0);
+    appendString(buffer, text);
+    appendString(buffer, ",\n    \"lengths\": {");
+    for (i = 0; i < LINE_LENGTH_BUCKETS; ++i) {
+        sprintf(text, "%d-%d", i * LINE_LENGTH_BUCKET_SIZE, i == LINE_LENGTH_BUCKETS - 1 ? MAX_LINE_LENGTH - 1 :
+                                                            (i + 1) * LINE_LENGTH_BUCKET_SIZE - 1);
+        appendJsonCount(buffer, text, stats.lineLengths[i], BOOLEANIZE(i == 0));
+    }
+    appendString(buffer, "}}");
+
+    /* The instruction mix, by opcode */
+    appendString(buffer, ",\n  \"instructions\": {");
+    for (i = 0; i < INSTRUCTION_COUNT; ++i) {
+        appendJsonCount(buffer, getInstructionMnemonic((Instruction) i), stats.instructions[i], BOOLEANIZE(i == 0));
+        instructions += stats.instructions[i];
+    }
+    appendJsonCount(buffer, "total", instructions, FALSE);
+    appendString(buffer, "}");
+
+    /* The (source, dest) addressing mode pairs that were used */
+    appendString(buffer, ",\n  \"addressingModes\": [");
+    for (i = 0, isFirst = TRUE; i < MODE_SLOTS; ++i)
+        for (j = 0; j < MODE_SLOTS; ++j) {
+            if (stats.addressingModes[i][j] == 0)
+                continue;
+            appendString(buffer, isFirst ? "\n    {" : ",\n    {");
+            appendJsonKey(buffer, "source", TRUE);
+            appendJsonString(buffer, getAddressingModeName((AddressingMode) (i - 1)));
+            appendJsonKey(buffer, "dest", FALSE);
+            appendJsonString(buffer, getAddressingModeName((AddressingMode) (j - 1)));
+            appendJsonCount(buffer, "count", stats.addressingModes[i][j], FALSE);
+            appendString(buffer, "}");
+            isFirst = FALSE;
+        }
+    appendString(buffer, isFirst ? "]" : "\n  ]");
+
+    /* The labels */
+    appendString(buffer, ",\n  \"labels\": {");
+    appendJsonCount(buffer, "definitions", stats.labelDefinitions, TRUE);
+    appendJsonCount(buffer, "references", stats.labelReferences, FALSE);
+    appendString(buffer, "}");
+
+    /* The directives, and the data words they put */
+    appendString(buffer, ",\n  \"directives\": {");
+    for (i = 0; i < DATA_DIRECTIVE_COUNT; ++i) {
+        appendJsonKey(buffer, directiveNames[i], BOOLEANIZE(i == 0));
+        appendString(buffer, "{");
+        appendJsonCount(buffer, "count", stats.directives[i], TRUE);
+        if (i == DATA_DIR || i == STRING_DIR || i == INCBIN_DIR)
+            appendJsonCount(buffer, "words", stats.directiveWords[i], FALSE);
+        appendString(buffer, "}");
+    }
+    appendString(buffer, "}\n}\n");
+}
+
+Boolean saveWorkloadStats(char *fileName) {
+    TextBuffer buffer;
+    FILE *file;
+    Boolean isWritten;
+
+    initTextBuffer(&buffer);
+    writeWorkloadStats(&buffer);
+
+    if ((file = fopen(fileName, "w")) == NULL) {
+        freeTextBuffer(&buffer);
+        return FALSE;
+    }
+    isWritten = writeTextBuffer(&buffer, file);
+    isWritten = BOOLEANIZE(fclose(file) == 0 && isWritten);
+
+    freeTextBuffer(&buffer);
+    return isWritten;
+}
@@ -0,0 +1,74 @@
+/*****************************************
+* Workload Statistics Header             *
+* @author Zvi Badash                     *
+* ****************************************
+*/
+
+#ifndef WORKLOAD_STATS_H
+#define WORKLOAD_STATS_H
+
+/*Imports */
+#include "dataTypes.h"
+#include "mainHeader.h"
+#include "textBuffer.h"
+
+/* Definitions */
+#define LINE_LENGTH_BUCKET_SIZE 16
+#define LINE_LENGTH_BUCKETS ((MAX_LINE_LENGTH + LINE_LENGTH_BUCKET_SIZE - 1) / LINE_LENGTH_BUCKET_SIZE)
+#define INSTRUCTION_COUNT (STOP_INST + 1)
+#define MODE_SLOTS (REGISTER_DIRECT + 2)        /* The addressing modes, and a slot for no operand */
+#define DATA_DIRECTIVE_COUNT (INCLUDE_DIR + 1)  /* The directives, the ones that put words in the data image counted */
+#define RATIO_PRECISION 4
+
+/* Type Definitions */
+/* What the sources of a run hold, counted as their lines are analyzed by the first pass */
+typedef struct {
+    unsigned long files;                                       /* The sources analyzed                          */
+    unsigned long lines, blankLines, commentLines;             /* Their lines, and the ones that hold nothing   */
+    unsigned long lineLengths[LINE_LENGTH_BUCKETS];            /* The lines by length (LINE_LENGTH_BUCKET_SIZE each) */
+    unsigned long instructions[INSTRUCTION_COUNT];             /* The instructions by opcode                    */
+    unsigned long addressingModes[MODE_SLOTS][MODE_SLOTS];     /* The instructions by (source, dest) modes      */
+    unsigned long labelDefinitions;                            /* The labels defined on code / data             */
+    unsigned long labelReferences;                             /* The direct operands (each one names a label)  */
+    unsigned long directives[DATA_DIRECTIVE_COUNT];            /* The directives by kind                        */
+    unsigned long directiveWords[DATA_DIRECTIVE_COUNT];        /* The data words put by .data / .string / .incbin */
+} WorkloadStats;
+
+/* Function Prototypes */
+/**
+ * This function counts a source about to be analyzed
+ * **/
+void countSourceFile();
+
+/**
+ * This function counts the line #line (its length, and whether it's blank or a comment)
+ * **/
+void countLine(char *line);
+
+/**
+ * This function counts a label defined on a code or a data line
+ * **/
+void countLabelDefinition();
+
+/**
+ * This function counts an instruction #inst with the operands of #srcMode and #destMode
+ * **/
+void countInstruction(Instruction inst, AddressingMode srcMode, AddressingMode destMode);
+
+/**
+ * This function counts a directive #dir, that put #words words in the data image
+ * **/
+void countDirective(Directive dir, unsigned words);
+
+/**
+ * This function writes the counts of the run (of all its sources together) into #buffer, as JSON
+ * **/
+void writeWorkloadStats(TextBuffer *buffer);
+
+/**
+ * This function writes the counts of the run to the file #fileName, as JSON
+ * @return TRUE on success, else FALSE
+ * **/
+Boolean saveWorkloadStats(char *fileName);
+
+#endif